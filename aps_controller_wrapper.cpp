@@ -141,6 +141,11 @@ int ApsControllerWrapper::apsdeDataRequest(const deCONZ::ApsDataRequest &req)
     {
         m_zclDefaultResponder->checkApsdeDataRequest(req);
     }
+    if (m_stub)
+    {
+        m_stubRequests++;
+        return deCONZ::Success;
+    }
     return m_apsCtrl->apsdeDataRequest(req);
 }
 
@@ -172,6 +177,11 @@ ZclDefaultResponder::~ZclDefaultResponder()
     {
         if (ZCL_NeedDefaultResponse(m_ind, m_zclFrame))
         {
+            if (m_apsCtrlWrapper->isStub())
+            {
+                m_apsCtrlWrapper->addStubRequest();
+                return;
+            }
             ZCL_SendDefaultResponse(m_apsCtrlWrapper->apsController(), m_ind, m_zclFrame, deCONZ::ZclSuccessStatus);
         }
     }
@@ -50,6 +50,8 @@ private:
 /*! Wraps \c deCONZ::ApsController to intercept apsdeDataRequest().
 
     The main purpose is to deterministic send ZCL Default Response if needed.
+    In stub mode requests aren't sent but only counted, this is used when replaying
+    captured indications.
  */
 class ApsControllerWrapper
 {
@@ -59,9 +61,15 @@ public:
     void registerZclDefaultResponder(ZclDefaultResponder *resp) { m_zclDefaultResponder = resp; }
     void clearZclDefaultResponder() { m_zclDefaultResponder = nullptr; };
     deCONZ::ApsController *apsController() { return m_apsCtrl; }
+    void setStub(bool stub) { m_stub = stub; m_stubRequests = 0; }
+    bool isStub() const { return m_stub; }
+    void addStubRequest() { m_stubRequests++; }
+    int stubRequests() const { return m_stubRequests; }
 
 private:
     deCONZ::ApsController *m_apsCtrl = nullptr;
+    bool m_stub = false;
+    int m_stubRequests = 0;
     ZclDefaultResponder *m_zclDefaultResponder = nullptr;
 };
 
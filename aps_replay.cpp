@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <QFile>
+#include "de_web_plugin.h"
+#include "de_web_plugin_private.h"
+#include "json.h"
+#include "utils/aps_capture.h"
+#include "utils/latency.h"
+
+/*
+    Capture and offline replay of APS indications.
+
+    --aps-capture=<path>  records every APS indication into <path> (format see utils/aps_capture.h).
+
+    --aps-replay=<path>   feeds the records of <path> through apsdeDataIndication() once the
+                          database is loaded, as fast as possible and without pacing.
+                          Outgoing requests via the ApsControllerWrapper are only counted (stub mode).
+                          To make sure nothing is sent to the real devices, the replay is refused
+                          while the gateway is connected to a network (use --auto-connect=0).
+
+    After the replay the throughput and the per indication cost are logged and the resulting
+    state of all device resources is written to <path>.state.json. If <path>.expected.json
+    exists, e.g. a state file of an earlier run, it is compared with the new state and
+    differences are logged. Together this allows benchmarks and regression tests of the
+    parsing path with traffic captured from a real gateway.
+*/
+
+#define APS_REPLAY_DELAY 10000 // ms, wait until devices are loaded from the database
+#define APS_REPLAY_SETTLE_DELAY 5000 // ms, let queued events be processed before taking the state
+
+static void CAP_ToIndication(const CAP_Record &rec, deCONZ::ApsDataIndication *ind)
+{
+    ind->setSrcAddressMode(deCONZ::ApsAddressMode(rec.srcAddrMode));
+    ind->srcAddress().setNwk(rec.srcNwk);
+    ind->srcAddress().setExt(rec.srcExt);
+    ind->setDstAddressMode(deCONZ::ApsAddressMode(rec.dstAddrMode));
+
+    if (rec.dstAddrMode == deCONZ::ApsGroupAddress)
+    {
+        ind->dstAddress().setGroup(rec.dstAddr);
+    }
+    else
+    {
+        ind->dstAddress().setNwk(rec.dstAddr);
+    }
+
+    ind->setSrcEndpoint(rec.srcEndpoint);
+    ind->setDstEndpoint(rec.dstEndpoint);
+    ind->setProfileId(rec.profileId);
+    ind->setClusterId(rec.clusterId);
+    ind->setLinkQuality(rec.lqi);
+    ind->setRssi(rec.rssi);
+    ind->setAsdu(QByteArray(reinterpret_cast<const char*>(rec.asdu.data()), int(rec.asdu.size())));
+}
+
+/*! Returns true if \p suffix changes with every replay and isn't part of the compared state.
+ */
+static bool CAP_IsVolatileItem(const char *suffix)
+{
+    return suffix == RStateLastUpdated || suffix == RAttrLastSeen || suffix == RAttrLastAnnounced;
+}
+
+void DeRestPluginPrivate::initApsReplay()
+{
+    const QString capturePath = deCONZ::appArgumentString("--aps-capture", QString());
+
+    if (!capturePath.isEmpty())
+    {
+        apsCaptureFile = new QFile(capturePath, this);
+
+        if (apsCaptureFile->open(QFile::WriteOnly | QFile::Truncate))
+        {
+            std::vector<uint8_t> buf;
+            CAP_WriteHeader(&buf);
+            apsCaptureFile->write(reinterpret_cast<const char*>(buf.data()), qint64(buf.size()));
+            apsCaptureTime.start();
+            DBG_Printf(DBG_INFO, "APS capture to %s\n", qPrintable(capturePath));
+        }
+        else
+        {
+            DBG_Printf(DBG_ERROR, "APS capture failed to open %s\n", qPrintable(capturePath));
+            delete apsCaptureFile;
+            apsCaptureFile = nullptr;
+        }
+    }
+
+    apsReplayPath = deCONZ::appArgumentString("--aps-replay", QString());
+
+    if (!apsReplayPath.isEmpty())
+    {
+        QTimer::singleShot(APS_REPLAY_DELAY, this, [this]() { replayApsCapture(); });
+    }
+}
+
+/*! Appends \p ind to the capture file.
+ */
+void DeRestPluginPrivate::apsCaptureIndication(const deCONZ::ApsDataIndication &ind)
+{
+    if (!apsCaptureFile || apsCtrlWrapper.isStub())
+    {
+        return;
+    }
+
+    CAP_Record rec;
+    rec.timeMs = uint32_t(apsCaptureTime.elapsed());
+    rec.srcAddrMode = uint8_t(ind.srcAddressMode());
+    rec.srcNwk = ind.srcAddress().nwk();
+    rec.srcExt = ind.srcAddress().ext();
+    rec.dstAddrMode = uint8_t(ind.dstAddressMode());
+    rec.dstAddr = ind.dstAddressMode() == deCONZ::ApsGroupAddress ? ind.dstAddress().group() : ind.dstAddress().nwk();
+    rec.srcEndpoint = ind.srcEndpoint();
+    rec.dstEndpoint = ind.dstEndpoint();
+    rec.profileId = ind.profileId();
+    rec.clusterId = ind.clusterId();
+    rec.lqi = ind.linkQuality();
+    rec.rssi = ind.rssi();
+    rec.asdu.assign(ind.asdu().constBegin(), ind.asdu().constEnd());
+
+    std::vector<uint8_t> buf;
+    CAP_WriteRecord(&buf, rec);
+    apsCaptureFile->write(reinterpret_cast<const char*>(buf.data()), qint64(buf.size()));
+}
+
+/*! Replays the capture file given by --aps-replay through apsdeDataIndication().
+ */
+void DeRestPluginPrivate::replayApsCapture()
+{
+    if (isInNetwork())
+    {
+        DBG_Printf(DBG_ERROR, "APS replay refused while connected to the network, start with --auto-connect=0\n");
+        return;
+    }
+
+    QFile file(apsReplayPath);
+    if (!file.open(QFile::ReadOnly))
+    {
+        DBG_Printf(DBG_ERROR, "APS replay failed to open %s\n", qPrintable(apsReplayPath));
+        return;
+    }
+
+    const QByteArray data = file.readAll();
+    const auto *p = reinterpret_cast<const uint8_t*>(data.constData());
+    const size_t size = size_t(data.size());
+    size_t pos = 0;
+
+    if (CAP_ReadHeader(p, size, &pos) != CAP_Ok)
+    {
+        DBG_Printf(DBG_ERROR, "APS replay %s isn't a supported capture file\n", qPrintable(apsReplayPath));
+        return;
+    }
+
+    CAP_Record rec;
+    CAP_Result result;
+    deCONZ::ApsDataIndication ind;
+    LAT_Histogram hist;
+    int unknownDevices = 0;
+
+    apsCtrlWrapper.setStub(true);
+    const int64_t start = LAT_NowUs();
+
+    while ((result = CAP_ReadRecord(p, size, &pos, &rec)) == CAP_Ok)
+    {
+        CAP_ToIndication(rec, &ind);
+
+        if (rec.srcExt != 0 && !DEV_GetDevice(m_devices, rec.srcExt))
+        {
+            unknownDevices++;
+        }
+
+        const int64_t t = LAT_NowUs();
+        apsdeDataIndication(ind);
+        LAT_Add(&hist, LAT_NowUs() - t);
+    }
+
+    const int64_t totalUs = LAT_NowUs() - start;
+
+    if (result != CAP_End)
+    {
+        DBG_Printf(DBG_INFO, "APS replay stopped at offset %zu, %s record\n", pos, result == CAP_Truncated ? "truncated" : "invalid");
+    }
+
+    DBG_Printf(DBG_INFO, "APS replay %u indications in %lld ms, %.0f ind/s, avg %llu us, p50 %u us, p99 %u us, max %u us, %d from unknown devices, %d requests stubbed\n",
+               hist.count, static_cast<long long>(totalUs / 1000),
+               totalUs > 0 ? double(hist.count) * 1000000.0 / double(totalUs) : 0.0,
+               static_cast<unsigned long long>(hist.count ? hist.totalUs / hist.count : 0),
+               LAT_Percentile(hist, 50), LAT_Percentile(hist, 99), hist.maxUs,
+               unknownDevices, apsCtrlWrapper.stubRequests());
+
+    QTimer::singleShot(APS_REPLAY_SETTLE_DELAY, this, [this]()
+    {
+        apsReplayDumpState(apsReplayPath);
+        apsCtrlWrapper.setStub(false);
+    });
+}
+
+/*! Writes the state of all device resources to <path>.state.json and compares it with <path>.expected.json if present.
+ */
+void DeRestPluginPrivate::apsReplayDumpState(const QString &path)
+{
+    QVariantMap state;
+
+    for (auto &device : m_devices)
+    {
+        for (Resource *r : device->subDevices())
+        {
+            const ResourceItem *uniqueId = r->item(RAttrUniqueId);
+            if (!uniqueId)
+            {
+                continue;
+            }
+
+            QVariantMap items;
+            for (int i = 0; i < r->itemCount(); i++)
+            {
+                const ResourceItem *item = r->itemForIndex(size_t(i));
+                if (item && !CAP_IsVolatileItem(item->descriptor().suffix))
+                {
+                    items[QLatin1String(item->descriptor().suffix)] = item->toVariant();
+                }
+            }
+
+            state[uniqueId->toString()] = items;
+        }
+    }
+
+    const QByteArray json = Json::serialize(state);
+
+    QFile stateFile(path + QLatin1String(".state.json"));
+    if (stateFile.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        stateFile.write(json);
+    }
+
+    QFile expectedFile(path + QLatin1String(".expected.json"));
+    if (!expectedFile.open(QFile::ReadOnly))
+    {
+        return;
+    }
+
+    // compare the serialized values, so number types don't matter after the JSON round trip
+    const QVariantMap actual = Json::parse(QString::fromUtf8(json)).toMap();
+    const QVariantMap expected = Json::parse(QString::fromUtf8(expectedFile.readAll())).toMap();
+    int mismatches = 0;
+
+    for (auto r = expected.cbegin(); r != expected.cend(); ++r)
+    {
+        const QVariantMap expectedItems = r.value().toMap();
+        const QVariantMap actualItems = actual.value(r.key()).toMap();
+
+        for (auto i = expectedItems.cbegin(); i != expectedItems.cend(); ++i)
+        {
+            const QByteArray expectedVal = Json::serialize(i.value());
+            const QByteArray actualVal = actualItems.contains(i.key()) ? Json::serialize(actualItems.value(i.key())) : QByteArray("missing");
+
+            if (expectedVal != actualVal)
+            {
+                DBG_Printf(DBG_INFO, "APS replay %s %s expected %s, got %s\n", qPrintable(r.key()), qPrintable(i.key()), expectedVal.constData(), actualVal.constData());
+                mismatches++;
+            }
+        }
+    }
+
+    DBG_Printf(DBG_INFO, "APS replay state %s, %d mismatches\n", mismatches == 0 ? "matches" : "differs", mismatches);
+}
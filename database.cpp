@@ -9,10 +9,18 @@
  */
 
 #define __STDC_FORMAT_MACROS
+#include <algorithm>
+#include <cctype>
 #include <inttypes.h>
+#include <map>
+#include <string>
+#include <unordered_map>
 #include <QString>
 #include <QStringBuilder>
 #include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <unistd.h>
 #include "database.h"
 #include "de_web_plugin_private.h"
@@ -28,6 +36,8 @@
 #include "json.h"
 #include "product_match.h"
 #include "utils/ArduinoJson.h"
+#include "utils/snapshot.h"
+#include "utils/timeseries.h"
 #include "utils/utils.h"
 
 constexpr size_t MAX_SQL_LEN = 2048;
@@ -62,6 +72,8 @@ static bool upgradeDbToUserVersion7();
 static bool upgradeDbToUserVersion8();
 static bool upgradeDbToUserVersion9();
 static bool upgradeDbToUserVersion10();
+static bool upgradeDbToUserVersion11();
+static bool upgradeDbToUserVersion12();
 static int sqliteLoadAuthCallback(void *user, int ncols, char **colval , char **colname);
 static int sqliteLoadConfigCallback(void *user, int ncols, char **colval , char **colname);
 static int sqliteLoadUserparameterCallback(void *user, int ncols, char **colval , char **colname);
@@ -83,6 +95,124 @@ static int sqliteLoadAllGatewaysCallback(void *user, int ncols, char **colval ,
                     Implementation
 ******************************************************************************/
 
+#define DB_DIRTY_MAX_ENTRIES 1024
+#define DB_DIRTY_FULL_SCAN_INTERVAL 16
+
+/*! Records which lights or sensors changed since the last saveDb().
+
+    Nodes are recorded by RestNodeBase::setNeedSaveDatabase() with their resource handle,
+    which holds the container index and the hash of the uniqueid. A node without valid
+    handle, e.g. a temporary object which is copied into the container later, causes a
+    full scan. All entries are also walked after the container was reallocated or shrunk,
+    every DB_DIRTY_FULL_SCAN_INTERVAL saves and on shutdown, see DB_SetFullSaveNeeded().
+ */
+struct DB_DirtySet
+{
+    std::vector<Resource::Handle> nodes;
+    const void *data = nullptr; // container data() at last save
+    size_t size = 0; // container size() at last save
+    unsigned saves = 0;
+    bool full = true;
+};
+
+static DB_DirtySet dbDirtyLights;
+static DB_DirtySet dbDirtySensors;
+
+static QElapsedTimer dbStartupTime;
+static std::vector<DB_StartupPhase> dbStartupTimeline;
+static bool dbDeferredLoaded = false; // scenes, rules, schedules and value history
+
+static void DB_AddDirtyNode(DB_DirtySet &dirty, const Resource *r)
+{
+    if (dirty.full)
+    {
+        return; // all entries are walked anyway
+    }
+
+    if (!isValid(r->handle()) || dirty.nodes.size() >= DB_DIRTY_MAX_ENTRIES)
+    {
+        dirty.nodes.clear();
+        dirty.full = true;
+        return;
+    }
+
+    dirty.nodes.push_back(r->handle());
+}
+
+/*! Records that \p node needs to be saved by the next saveDb(). */
+void DB_MarkNodeDirty(const RestNodeBase *node)
+{
+    if (const auto *sensor = dynamic_cast<const Sensor*>(node))
+    {
+        DB_AddDirtyNode(dbDirtySensors, sensor);
+    }
+    else if (const auto *lightNode = dynamic_cast<const LightNode*>(node))
+    {
+        DB_AddDirtyNode(dbDirtyLights, lightNode);
+    }
+}
+
+/*! Makes the next saveDb() walk all lights and sensors, used before shutdown. */
+void DB_SetFullSaveNeeded()
+{
+    dbDirtyLights.nodes.clear();
+    dbDirtyLights.full = true;
+    dbDirtySensors.nodes.clear();
+    dbDirtySensors.full = true;
+}
+
+/*! Returns the indexes of \p container entries which need to be saved and resets \p dirty. */
+template <typename T>
+static std::vector<size_t> DB_TakeDirtyIndexes(const std::vector<T> &container, DB_DirtySet &dirty)
+{
+    std::vector<size_t> result;
+
+    dirty.saves++;
+
+    if (dirty.full || dirty.data != container.data() || dirty.size > container.size() ||
+        (dirty.saves % DB_DIRTY_FULL_SCAN_INTERVAL) == 0)
+    {
+        for (size_t i = 0; i < container.size(); i++)
+        {
+            if (container[i].needSaveDatabase())
+            {
+                result.push_back(i);
+            }
+        }
+    }
+    else
+    {
+        for (const Resource::Handle &hnd : dirty.nodes)
+        {
+            const size_t i = hnd.index;
+            // the hash verifies that the entry still belongs to the same uniqueid
+            if (i < container.size() && container[i].handle().hash == hnd.hash && container[i].needSaveDatabase())
+            {
+                result.push_back(i);
+            }
+        }
+
+        // appended since last save
+        for (size_t i = dirty.size; i < container.size(); i++)
+        {
+            if (container[i].needSaveDatabase())
+            {
+                result.push_back(i);
+            }
+        }
+
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+
+    dirty.nodes.clear();
+    dirty.data = container.data();
+    dirty.size = container.size();
+    dirty.full = false;
+
+    return result;
+}
+
 static QString dbEscapeString(const QString &str)
 {
     QString result;
@@ -103,37 +233,708 @@ static QString dbEscapeString(const QString &str)
             result.push_back(ch);
             break;
 
-        default:
-            result.push_back(ch);
-            break;
-        }
+        default:
+            result.push_back(ch);
+            break;
+        }
+    }
+
+    return result;
+}
+
+static DB_Profile dbProfile = DB_ProfileSafe;
+static DB_CommitStats dbCommitStats;
+
+static const char *dbProfileNames[] = { "safe", "balanced", "throughput" };
+
+/*! PRAGMAs of each DB_Profile, executed for each new connection. */
+static const char *dbProfilePragmas[][5] = {
+    { "PRAGMA journal_mode = DELETE", "PRAGMA synchronous = FULL", "PRAGMA temp_store = DEFAULT", "PRAGMA cache_size = -2000", nullptr },
+    { "PRAGMA journal_mode = WAL", "PRAGMA synchronous = NORMAL", "PRAGMA temp_store = MEMORY", "PRAGMA wal_autocheckpoint = 0", nullptr },
+    { "PRAGMA journal_mode = WAL", "PRAGMA synchronous = OFF", "PRAGMA temp_store = MEMORY", "PRAGMA wal_autocheckpoint = 0", "PRAGMA cache_size = -8000" }
+};
+
+static void DB_ApplyProfile()
+{
+    if (!db || sqlite3_get_autocommit(db) == 0)
+    {
+        return; // applied on next open, journal_mode can't be changed within a transaction
+    }
+
+    for (const char *sql : dbProfilePragmas[dbProfile])
+    {
+        if (!sql)
+        {
+            break;
+        }
+
+        char *errmsg = nullptr;
+        int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errmsg);
+
+        if (rc != SQLITE_OK)
+        {
+            if (errmsg)
+            {
+                DBG_Printf(DBG_ERROR, "DB sqlite3_exec failed: %s, error: %s (%d)\n", sql, errmsg, rc);
+                sqlite3_free(errmsg);
+            }
+        }
+    }
+}
+
+/*! Selects the durability profile by name without applying it.
+    \returns false if \p name isn't a known profile
+ */
+static bool DB_SelectProfile(QLatin1String name)
+{
+    for (int i = DB_ProfileSafe; i <= DB_ProfileThroughput; i++)
+    {
+        if (name == QLatin1String(dbProfileNames[i]))
+        {
+            if (dbProfile != DB_Profile(i))
+            {
+                DBG_Printf(DBG_INFO, "DB durability profile: %s\n", dbProfileNames[i]);
+                dbProfile = DB_Profile(i);
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*! Selects the durability profile by name, applied immediately if the database is open.
+    Must not be called while a statement runs, e.g. from a sqlite3_exec() callback.
+    \returns false if \p name isn't a known profile
+ */
+bool DB_SetProfile(QLatin1String name)
+{
+    if (!DB_SelectProfile(name))
+    {
+        return false;
+    }
+
+    DB_ApplyProfile();
+    return true;
+}
+
+DB_Profile DB_GetProfile()
+{
+    return dbProfile;
+}
+
+const char *DB_ProfileName(DB_Profile profile)
+{
+    return dbProfileNames[profile];
+}
+
+const DB_CommitStats &DB_GetCommitStats()
+{
+    return dbCommitStats;
+}
+
+static void DB_RecordCommit(int rc, int64_t commitMs, int64_t saveMs)
+{
+    if (rc != SQLITE_OK)
+    {
+        dbCommitStats.failed++;
+        return;
+    }
+
+    dbCommitStats.commits++;
+    dbCommitStats.commitTotalMs += commitMs;
+    dbCommitStats.commitMaxMs = std::max(dbCommitStats.commitMaxMs, commitMs);
+    dbCommitStats.saveTotalMs += saveMs;
+    dbCommitStats.saveMaxMs = std::max(dbCommitStats.saveMaxMs, saveMs);
+}
+
+/*! Copies the WAL into the database in idle time, so that commits don't run into
+    automatic checkpoints. Passive mode doesn't wait for other connections.
+ */
+void DB_Checkpoint()
+{
+    if (!db || dbProfile == DB_ProfileSafe || sqlite3_get_autocommit(db) == 0)
+    {
+        return;
+    }
+
+    int logFrames = 0;
+    int checkpointedFrames = 0;
+
+    QElapsedTimer measTimer;
+    measTimer.start();
+
+    int rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_PASSIVE, &logFrames, &checkpointedFrames);
+
+    if (rc == SQLITE_OK && logFrames > 0)
+    {
+        DBG_Printf(DBG_INFO_L2, "DB checkpoint %d/%d WAL frames in %d ms\n", checkpointedFrames, logFrames, int(measTimer.elapsed()));
+    }
+}
+
+#define DB_WRITE_QUEUE_FLUSH_SIZE 64 // schedule a fast save
+#define DB_WRITE_QUEUE_MAX_SIZE 512 // execute immediately
+#define DB_WRITE_MAX_ATTEMPTS 3 // a failed operation is dropped after this many attempts
+
+/*! Typed write operations which are queued and executed by saveDb() within one transaction. */
+enum DB_WriteOpType
+{
+    DB_WriteResourceItem, // resource_items, text: sub-device uniqueid
+    DB_WriteDeviceItem, // dev_resource_items, id: device id
+    DB_WriteOpTypeMax
+};
+
+struct DB_WriteOp
+{
+    DB_WriteOpType type;
+    int64_t id = 0;
+    int64_t timestamp = 0;
+    int attempts = 0;
+    std::string text;
+    std::string item;
+    std::string value;
+};
+
+/*! SQL of each DB_WriteOpType, the statements are prepared once and cached until the database is closed.
+    Both tables replace existing entries on conflict.
+ */
+static const char *dbWriteSql[DB_WriteOpTypeMax] = {
+    "INSERT INTO resource_items (sub_device_id,item,value,source,timestamp)"
+    " SELECT id, ?2, ?3, 'dev', ?4 FROM sub_devices WHERE uniqueid = ?1",
+    "INSERT INTO dev_resource_items (device_id,item,value,timestamp) VALUES (?1, ?2, ?3, ?4)"
+};
+
+static sqlite3_stmt *dbWriteStmt[DB_WriteOpTypeMax] = { };
+static std::vector<DB_WriteOp> dbWriteQueue;
+static std::unordered_map<std::string, size_t> dbWriteIndex; // dedup key -> index in dbWriteQueue
+
+/*! Returns the deduplication key, a newer operation with the same key replaces the queued one. */
+static std::string DB_WriteOpKey(const DB_WriteOp &op)
+{
+    std::string key;
+    key.reserve(24 + op.text.size() + op.item.size());
+    key.push_back(char('0' + op.type));
+    key += std::to_string(op.id);
+    key.push_back('/');
+    key += op.text;
+    key.push_back('/');
+    key += op.item;
+    return key;
+}
+
+static bool DB_IsWriteQueued(const DB_WriteOp &op)
+{
+    return dbWriteIndex.find(DB_WriteOpKey(op)) != dbWriteIndex.end();
+}
+
+/*! Executes all queued write operations with the cached statements.
+    Should be called within a transaction. Failed operations stay queued for the next
+    save, up to DB_WRITE_MAX_ATTEMPTS times.
+    \returns the number of failed operations.
+ */
+static int DB_ExecWriteQueue()
+{
+    if (!db || dbWriteQueue.empty())
+    {
+        return 0;
+    }
+
+    int failed = 0;
+    std::vector<DB_WriteOp> retry;
+
+    for (DB_WriteOp &op : dbWriteQueue)
+    {
+        sqlite3_stmt *&stmt = dbWriteStmt[op.type];
+
+        if (!stmt)
+        {
+            int rc = sqlite3_prepare_v2(db, dbWriteSql[op.type], -1, &stmt, nullptr);
+            if (rc != SQLITE_OK)
+            {
+                DBG_Printf(DBG_ERROR, "DB prepare failed: %s, error: %s (%d)\n", dbWriteSql[op.type], sqlite3_errmsg(db), rc);
+                stmt = nullptr;
+                failed++;
+                if (++op.attempts < DB_WRITE_MAX_ATTEMPTS)
+                {
+                    retry.push_back(std::move(op));
+                }
+                continue;
+            }
+        }
+
+        if (op.type == DB_WriteResourceItem)
+        {
+            sqlite3_bind_text(stmt, 1, op.text.c_str(), int(op.text.size()), SQLITE_STATIC);
+        }
+        else
+        {
+            sqlite3_bind_int64(stmt, 1, op.id);
+        }
+        sqlite3_bind_text(stmt, 2, op.item.c_str(), int(op.item.size()), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, op.value.c_str(), int(op.value.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, op.timestamp);
+
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+
+        if (rc != SQLITE_DONE)
+        {
+            DBG_Printf(DBG_ERROR, "DB write %s/%s failed, error: %s (%d)\n", op.text.c_str(), op.item.c_str(), sqlite3_errmsg(db), rc);
+            failed++;
+            if (++op.attempts < DB_WRITE_MAX_ATTEMPTS)
+            {
+                retry.push_back(std::move(op));
+            }
+        }
+    }
+
+    DBG_Printf(DBG_INFO_L2, "DB executed %d queued writes, %d failed, %d kept for retry\n", int(dbWriteQueue.size()), failed, int(retry.size()));
+
+    dbWriteQueue = std::move(retry);
+    dbWriteIndex.clear();
+
+    for (size_t i = 0; i < dbWriteQueue.size(); i++)
+    {
+        dbWriteIndex.emplace(DB_WriteOpKey(dbWriteQueue[i]), i);
+    }
+
+    if (!dbWriteQueue.empty())
+    {
+        DeRestPluginPrivate::instance()->queSaveDb(DB_QUERY_QUEUE, DB_LONG_SAVE_DELAY);
+    }
+
+    return failed;
+}
+
+/*! Executes pending writes before tables of the queue are read or when the queue is full.
+    \returns false if a write or the commit failed.
+ */
+static bool DB_FlushWriteQueue()
+{
+    if (!db || dbWriteQueue.empty())
+    {
+        return true;
+    }
+
+    const bool ownTransaction = sqlite3_get_autocommit(db) != 0;
+
+    QElapsedTimer measTimer;
+    measTimer.start();
+
+    if (ownTransaction)
+    {
+        sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+    }
+
+    const int failed = DB_ExecWriteQueue();
+
+    if (ownTransaction)
+    {
+        char *errmsg = nullptr;
+        QElapsedTimer commitTimer;
+        commitTimer.start();
+        int rc = sqlite3_exec(db, "COMMIT", nullptr, nullptr, &errmsg);
+        DB_RecordCommit(rc, commitTimer.elapsed(), measTimer.elapsed());
+        if (rc != SQLITE_OK && errmsg)
+        {
+            DBG_Printf(DBG_ERROR, "DB sqlite3_exec failed: COMMIT, error: %s (%d)\n", errmsg, rc);
+            sqlite3_free(errmsg);
+        }
+
+        if (rc != SQLITE_OK)
+        {
+            return false;
+        }
+    }
+
+    return failed == 0;
+}
+
+#define DB_SUB_ITEMS_CACHE_TTL (10 * 60 * 1000) // released 10 minutes after the preload
+
+/*! Items of all sub-devices, loaded by DB_PreloadSubDeviceItems() with a single query
+    when the first device is initialized, instead of one query per sub-device.
+ */
+static bool dbSubItemsPreloaded = false;
+static QElapsedTimer dbSubItemsAge;
+static std::unordered_map<std::string, std::vector<DB_ResourceItem>> dbSubItems; // sub-device uniqueid -> items
+static std::unordered_map<std::string, std::string> dbSubItemsDevice; // device uniqueid -> uniqueid of its first sub-device
+
+static void DB_ReleaseSubDeviceItems()
+{
+    dbSubItems.clear();
+    dbSubItemsDevice.clear();
+}
+
+/*! Keeps the preloaded items in sync with writes to 'resource_items'. */
+static void DB_UpdateSubDeviceItems(const DB_WriteOp &op)
+{
+    const auto i = dbSubItems.find(op.text);
+    if (i == dbSubItems.end())
+    {
+        return;
+    }
+
+    auto dbItem = std::find_if(i->second.begin(), i->second.end(), [&op](const DB_ResourceItem &x)
+    {
+        return op.item == x.name.c_str();
+    });
+
+    if (dbItem == i->second.end())
+    {
+        i->second.push_back({});
+        dbItem = i->second.end() - 1;
+        dbItem->name = op.item.c_str();
+    }
+
+    dbItem->value = QString::fromStdString(op.value);
+    dbItem->timestampMs = op.timestamp * 1000;
+}
+
+/*! Queues \p op, an already queued operation with the same key is replaced in place. */
+static bool DB_QueueWrite(DB_WriteOp &&op)
+{
+    if (op.type == DB_WriteResourceItem)
+    {
+        DB_UpdateSubDeviceItems(op);
+    }
+
+    std::string key = DB_WriteOpKey(op);
+    const auto i = dbWriteIndex.find(key);
+
+    if (i != dbWriteIndex.end())
+    {
+        dbWriteQueue[i->second] = std::move(op);
+        return true;
+    }
+
+    dbWriteIndex.emplace(std::move(key), dbWriteQueue.size());
+    dbWriteQueue.push_back(std::move(op));
+
+    if (dbWriteQueue.size() >= DB_WRITE_QUEUE_MAX_SIZE)
+    {
+        return DB_FlushWriteQueue();
+    }
+    else if (dbWriteQueue.size() >= DB_WRITE_QUEUE_FLUSH_SIZE)
+    {
+        DeRestPluginPrivate::instance()->queSaveDb(DB_QUERY_QUEUE, DB_FAST_SAVE_DELAY);
+    }
+    else
+    {
+        DeRestPluginPrivate::instance()->queSaveDb(DB_QUERY_QUEUE, DB_SHORT_SAVE_DELAY);
+    }
+
+    return true;
+}
+
+static void DB_FinalizeWriteStatements()
+{
+    for (sqlite3_stmt *&stmt : dbWriteStmt)
+    {
+        if (stmt)
+        {
+            sqlite3_finalize(stmt);
+            stmt = nullptr;
+        }
+    }
+}
+
+#define DB_SIZE_STATS_MAX_AGE (5 * 60 * 1000) // table sizes are queried at most every 5 minutes
+
+/*! Statement statistics keyed by "<op> <table>", collected by DB_TraceCallback() and DB_UpdateHook()
+    once enabled by DB_EnableStatementStats().
+ */
+static std::unordered_map<std::string, DB_StatementStats> dbStatementStats;
+static bool dbStatementStatsEnabled = false;
+static bool dbStatementStatsPaused = false;
+static DB_SizeStats dbSizeStats;
+static QElapsedTimer dbSizeStatsAge;
+
+static bool DB_IsIdentChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+/*! Returns the next word of \p sql and advances \p sql behind it, quotes are skipped. */
+static std::string DB_NextWord(const char **sql)
+{
+    const char *p = *sql;
+
+    while (*p && !DB_IsIdentChar(*p))
+    {
+        p++;
+    }
+
+    const char *start = p;
+    while (DB_IsIdentChar(*p))
+    {
+        p++;
+    }
+
+    *sql = p;
+    return std::string(start, size_t(p - start));
+}
+
+/*! Extracts the statement type and its main table from the SQL text. */
+static std::string DB_StatementKey(const char *sql, std::string *op, std::string *table)
+{
+    *op = DB_NextWord(&sql);
+    std::transform(op->begin(), op->end(), op->begin(), ::toupper);
+    table->clear();
+
+    const char *keyword = nullptr;
+    if      (*op == "SELECT" || *op == "DELETE") { keyword = "FROM"; }
+    else if (*op == "INSERT" || *op == "REPLACE") { keyword = "INTO"; }
+    else if (*op == "UPDATE" || *op == "PRAGMA") { keyword = ""; }
+
+    if (keyword)
+    {
+        while (*sql)
+        {
+            std::string word = DB_NextWord(&sql);
+            if (keyword[0] == '\0' || qstricmp(word.c_str(), keyword) == 0)
+            {
+                *table = keyword[0] == '\0' ? word : DB_NextWord(&sql);
+                break;
+            }
+        }
+    }
+
+    return table->empty() ? *op : *op + ' ' + *table;
+}
+
+static DB_StatementStats &DB_GetStatementEntry(const std::string &key, const std::string &op, const std::string &table)
+{
+    DB_StatementStats &stats = dbStatementStats[key];
+    if (stats.op.empty())
+    {
+        stats.op = op;
+        stats.table = table;
+    }
+    return stats;
+}
+
+#if SQLITE_VERSION_NUMBER > 3014000
+/*! Called by SQLite after each statement with its execution time. */
+static int DB_TraceCallback(unsigned type, void *user, void *p, void *x)
+{
+    Q_UNUSED(user);
+
+    if (type != SQLITE_TRACE_PROFILE || dbStatementStatsPaused)
+    {
+        return 0;
     }
 
-    return result;
+    const char *sql = sqlite3_sql(static_cast<sqlite3_stmt*>(p));
+    if (!sql)
+    {
+        return 0;
+    }
+
+    std::string op;
+    std::string table;
+    const std::string key = DB_StatementKey(sql, &op, &table);
+    const uint64_t us = uint64_t(*static_cast<sqlite3_int64*>(x)) / 1000;
+
+    DB_StatementStats &stats = DB_GetStatementEntry(key, op, table);
+    stats.count++;
+    stats.totalUs += us;
+    stats.maxUs = std::max(stats.maxUs, us);
+
+    return 0;
 }
+#endif
 
-#ifdef DECONZ_DEBUG_BUILD
+/*! Counts changed rows per table, this includes rows changed by triggers and foreign key cascades. */
 static void DB_UpdateHook(void *user, int op, char const *dbName, char const *tableName, sqlite3_int64 rowid)
 {
     (void)user;
+    (void)dbName;
+    (void)rowid;
     const char *opName = "?";
 
     if      (op == SQLITE_INSERT) { opName = "INSERT"; }
     else if (op == SQLITE_UPDATE) { opName = "UPDATE"; }
     else if (op == SQLITE_DELETE) { opName = "DELETE"; }
 
+    if (dbStatementStatsEnabled && !dbStatementStatsPaused)
+    {
+        const std::string table(tableName);
+        DB_GetStatementEntry(std::string(opName) + ' ' + table, opName, table).rows++;
+    }
+
+#ifdef DECONZ_DEBUG_BUILD
+    DBG_Printf(DBG_INFO, "%s %s %lld\n", opName, tableName, (long long)rowid);
+#endif
+}
+
+/*! Installs the statistics callbacks on the open connection, without statistics
+    only debug builds keep the update hook for logging.
+ */
+static void DB_InstallStatementHooks()
+{
+    if (!db)
+    {
+        return;
+    }
+
+#ifdef DECONZ_DEBUG_BUILD
+    sqlite3_update_hook(db, DB_UpdateHook, nullptr);
+#else
+    sqlite3_update_hook(db, dbStatementStatsEnabled ? DB_UpdateHook : nullptr, nullptr);
+#endif
+
+#if SQLITE_VERSION_NUMBER > 3014000
+    if (dbStatementStatsEnabled)
+    {
+        sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, DB_TraceCallback, nullptr);
+    }
+#endif
+}
+
+/*! Starts collecting statement statistics, they cost a callback per statement and changed row. */
+void DB_EnableStatementStats()
+{
+    if (!dbStatementStatsEnabled)
+    {
+        dbStatementStatsEnabled = true;
+        DB_InstallStatementHooks();
+    }
+}
+
+std::vector<DB_StatementStats> DB_GetStatementStats()
+{
+    std::vector<DB_StatementStats> result;
+    result.reserve(dbStatementStats.size());
+
+    for (const auto &i : dbStatementStats)
+    {
+        result.push_back(i.second);
+    }
+
+    std::sort(result.begin(), result.end(), [](const DB_StatementStats &a, const DB_StatementStats &b)
+    {
+        return a.totalUs > b.totalUs;
+    });
+
+    return result;
+}
+
+/*! Returns the row estimate of the first number of a 'sqlite_stat1' entry. */
+static int64_t DB_StatRowEstimate(const char *stat)
+{
+    return stat ? strtoll(stat, nullptr, 10) : -1;
+}
+
+/*! Queries file and table sizes, these statements aren't counted in the statement statistics.
+
+    Row counts are estimates from 'sqlite_stat1' (written by ANALYZE) or from the dbstat
+    table, only tables without an estimate are counted. The result is cached for
+    DB_SIZE_STATS_MAX_AGE since the queries read the whole file.
+ */
+bool DB_GetSizeStats(DB_SizeStats *stats)
+{
+    if (dbSizeStatsAge.isValid() && dbSizeStatsAge.elapsed() < DB_SIZE_STATS_MAX_AGE)
+    {
+        *stats = dbSizeStats;
+        return true;
+    }
+
+    DeRestPluginPrivate::instance()->openDb();
+
+    if (!db)
+    {
+        return false;
+    }
+
+    dbStatementStatsPaused = true;
+
+    stats->pageCount = getDbPragmaInteger(pragmaPageCount);
+    stats->pageSize = getDbPragmaInteger(pragmaPageSize);
+    stats->freePages = getDbPragmaInteger(pragmaFreeListCount);
+    stats->tables.clear();
+
+    sqlite3_stmt *res = nullptr;
+    int rc = sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%'", -1, &res, nullptr);
+
+    while (rc == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
+    {
+        DB_TableStats table;
+        table.name = reinterpret_cast<const char*>(sqlite3_column_text(res, 0));
+        table.rows = -1;
+        stats->tables.push_back(std::move(table));
+    }
+    sqlite3_finalize(res);
+
+    // only present after ANALYZE, the first number of each entry is the table row count
+    res = nullptr;
+    rc = sqlite3_prepare_v2(db, "SELECT tbl, stat FROM sqlite_stat1", -1, &res, nullptr);
 
-    if (op == SQLITE_UPDATE)
+    while (rc == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
     {
-        if (tableName[0] == 'd')
+        const char *name = reinterpret_cast<const char*>(sqlite3_column_text(res, 0));
+        const int64_t rows = DB_StatRowEstimate(reinterpret_cast<const char*>(sqlite3_column_text(res, 1)));
+        for (DB_TableStats &table : stats->tables)
         {
-            DBG_Printf(DBG_INFO_L2, "dummy\n");
+            if (name && table.name == name)
+            {
+                table.rows = std::max(table.rows, rows);
+                break;
+            }
         }
     }
-    DBG_Printf(DBG_INFO, "%s %s %lld\n", opName, tableName, (long long)rowid);
+    sqlite3_finalize(res);
+
+    // only available if SQLite was compiled with SQLITE_ENABLE_DBSTAT_VTAB, includes the table indexes,
+    // the cells of the leaf pages of the table itself are its rows
+    res = nullptr;
+    rc = sqlite3_prepare_v2(db, "SELECT tbl_name, SUM(pgsize), SUM(CASE WHEN name = tbl_name AND pagetype = 'leaf' THEN ncell ELSE 0 END)"
+                                " FROM dbstat INNER JOIN sqlite_master USING (name) GROUP BY tbl_name", -1, &res, nullptr);
+
+    while (rc == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
+    {
+        const char *name = reinterpret_cast<const char*>(sqlite3_column_text(res, 0));
+        for (DB_TableStats &table : stats->tables)
+        {
+            if (name && table.name == name)
+            {
+                table.bytes = sqlite3_column_int64(res, 1);
+                if (table.rows < 0)
+                {
+                    table.rows = sqlite3_column_int64(res, 2);
+                }
+                break;
+            }
+        }
+    }
+    sqlite3_finalize(res);
+
+    for (DB_TableStats &table : stats->tables)
+    {
+        if (table.rows >= 0)
+        {
+            continue;
+        }
+
+        const std::string sql = "SELECT COUNT(*) FROM \"" + table.name + "\"";
+        res = nullptr;
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &res, nullptr) == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
+        {
+            table.rows = sqlite3_column_int64(res, 0);
+        }
+        sqlite3_finalize(res);
+    }
+
+    dbStatementStatsPaused = false;
+
+    DeRestPluginPrivate::instance()->closeDb();
 
+    dbSizeStats = *stats;
+    dbSizeStatsAge.start();
+
+    return true;
 }
-#endif
 
 
 /*! Inits the database and creates tables/columns if necessary.
@@ -196,6 +997,14 @@ void DeRestPluginPrivate::checkDbUserVersion()
         updated = upgradeDbToUserVersion10();
     }
     else if (userVersion == 10)
+    {
+        updated = upgradeDbToUserVersion11();
+    }
+    else if (userVersion == 11)
+    {
+        updated = upgradeDbToUserVersion12();
+    }
+    else if (userVersion == 12)
     {
         // latest version
     }
@@ -814,6 +1623,53 @@ static bool upgradeDbToUserVersion10()
     return setDbUserVersion(10);
 }
 
+/*! Upgrades database to user_version 11. */
+static bool upgradeDbToUserVersion11()
+{
+    DBG_Printf(DBG_INFO, "DB upgrade to user_version 11\n");
+
+    /*
+       The 'zcl_series' table holds the ZCL value history as compact blocks,
+       see utils/timeseries.h. Each row is one block of a series, the 'mac'
+       column is the 64-bit extended address as integer.
+     */
+
+    // create tables
+    const char *sql[] = {
+        "CREATE TABLE if NOT EXISTS zcl_series ("
+        " mac INTEGER NOT NULL,"
+        " endpoint INTEGER NOT NULL,"
+        " cluster INTEGER NOT NULL,"
+        " attribute INTEGER NOT NULL,"
+        " t0 INTEGER NOT NULL," // first timestamp
+        " t1 INTEGER NOT NULL," // last timestamp
+        " count INTEGER NOT NULL,"
+        " data BLOB NOT NULL,"
+        " PRIMARY KEY (mac, endpoint, cluster, attribute, t0) ON CONFLICT REPLACE"
+        ")",
+        "CREATE INDEX if NOT EXISTS zcl_series_t1_idx ON zcl_series (t1)",
+        nullptr
+    };
+
+    for (int i = 0; sql[i] != nullptr; i++)
+    {
+        char *errmsg = nullptr;
+        int rc = sqlite3_exec(db, sql[i], nullptr, nullptr, &errmsg);
+
+        if (rc != SQLITE_OK)
+        {
+            if (errmsg)
+            {
+                DBG_Printf(DBG_ERROR_L2, "SQL exec failed: %s, error: %s (%d), line: %d\n", sql[i], errmsg, rc, __LINE__);
+                sqlite3_free(errmsg);
+            }
+            return false;
+        }
+    }
+
+    return setDbUserVersion(11);
+}
+
 /*! Stores a source route.
     Any existing source route with the same uuid will be replaced automatically.
  */
@@ -1072,31 +1928,208 @@ int DB_StoreDevice(DB_Device &dev)
     U_sstream_put_long(&ss, dev.nwk);
     U_sstream_put_str(&ss, ", strftime('%s','now');");
 
-    rc = sqlite3_exec(db, sqlBuf, nullptr, nullptr, nullptr);
-    if (rc == SQLITE_OK)
+    rc = sqlite3_exec(db, sqlBuf, nullptr, nullptr, nullptr);
+    if (rc == SQLITE_OK)
+    {
+        U_sstream_init(&ss, sqlBuf, sizeof(sqlBuf));
+
+        // query again to get device id
+        U_sstream_put_str(&ss, "SELECT id, nwk FROM devices WHERE mac = '");
+        U_sstream_put_mac_address(&ss, dev.mac);
+        U_sstream_put_str(&ss, "'");
+
+        entry.id = -1;
+        entry.nwk = -1;
+        entry.creationTime = -1;
+
+        rc = sqlite3_exec(db, sqlBuf, loadDeviceCallback, &entry, nullptr);
+
+        if (rc == SQLITE_OK && entry.id != -1)
+        {
+            dev.deviceId = entry.id;
+            dev.creationTime = entry.creationTime;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*! In-memory copy of the 'device_descriptors' table, the data shares the
+    implicitly shared QByteArray of the pushed descriptor.
+ */
+struct DB_ZdpDescriptor
+{
+    uint8_t endpoint;
+    uint16_t type;
+    QByteArray data;
+};
+
+static bool dbZdpDescriptorsLoaded = false;
+static std::unordered_map<uint64_t, std::vector<DB_ZdpDescriptor>> dbZdpDescriptors; // extAddr -> descriptors
+
+static DB_ZdpDescriptor *DB_FindZdpDescriptor(uint64_t extAddr, uint8_t endpoint, uint16_t type)
+{
+    const auto i = dbZdpDescriptors.find(extAddr);
+    if (i == dbZdpDescriptors.end())
+    {
+        return nullptr;
+    }
+
+    for (DB_ZdpDescriptor &desc : i->second)
+    {
+        if (desc.endpoint == endpoint && desc.type == type)
+        {
+            return &desc;
+        }
+    }
+
+    return nullptr;
+}
+
+static void DB_CacheZdpDescriptor(uint64_t extAddr, uint8_t endpoint, uint16_t type, const QByteArray &data)
+{
+    DB_ZdpDescriptor *desc = DB_FindZdpDescriptor(extAddr, endpoint, type);
+
+    if (desc)
+    {
+        desc->data = data;
+    }
+    else
+    {
+        dbZdpDescriptors[extAddr].push_back({endpoint, type, data});
+    }
+}
+
+/*! Loads all descriptors with one query when first needed. */
+static void DB_LoadZdpDescriptors()
+{
+    if (dbZdpDescriptorsLoaded)
+    {
+        return;
+    }
+
+    DeRestPluginPrivate::instance()->openDb();
+
+    if (!db)
+    {
+        return;
+    }
+
+    dbZdpDescriptorsLoaded = true;
+
+    sqlite3_stmt *res = nullptr;
+    const char *sql = "SELECT devices.mac, endpoint, type, data FROM device_descriptors"
+                      " INNER JOIN devices ON device_descriptors.device_id = devices.id";
+
+    int rc = sqlite3_prepare_v2(db, sql, -1, &res, nullptr);
+    DBG_Assert(rc == SQLITE_OK);
+
+    size_t count = 0;
+    while (rc == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
+    {
+        const char *mac = reinterpret_cast<const char*>(sqlite3_column_text(res, 0));
+        const int endpoint = sqlite3_column_int(res, 1);
+        const int type = sqlite3_column_int(res, 2);
+        const char *data = static_cast<const char*>(sqlite3_column_blob(res, 3));
+        const int size = sqlite3_column_bytes(res, 3);
+
+        const uint64_t extAddr = mac ? extAddressFromUniqueId(QLatin1String(mac)) : 0;
+
+        if (extAddr == 0 || !data || size <= 0 || endpoint < 0 || endpoint > 0xFF || type < 0 || type > 0xFFFF)
+        {
+            continue;
+        }
+
+        DB_CacheZdpDescriptor(extAddr, uint8_t(endpoint), uint16_t(type), QByteArray(data, size));
+        count++;
+    }
+
+    if (res)
+    {
+        sqlite3_finalize(res);
+    }
+
+    DBG_Printf(DBG_INFO, "DB loaded %d ZDP descriptors\n", int(count));
+
+    DeRestPluginPrivate::instance()->closeDb();
+}
+
+/*! Restores a missing node descriptor and missing simple descriptors of \p node
+    from the descriptors stored by pushZdpDescriptorDb(), so they don't need to be queried again.
+    \returns the number of restored descriptors
+ */
+int DB_RestoreZdpDescriptors(const deCONZ::Node *node)
+{
+    if (!node || !node->address().hasExt())
+    {
+        return 0;
+    }
+
+    DB_LoadZdpDescriptors();
+
+    const auto i = dbZdpDescriptors.find(node->address().ext());
+    if (i == dbZdpDescriptors.end())
+    {
+        return 0;
+    }
+
+    int count = 0;
+    auto *n = const_cast<deCONZ::Node*>(node);
+    const DB_ZdpDescriptor *nodeDescriptor = DB_FindZdpDescriptor(node->address().ext(), ZDO_ENDPOINT, ZDP_NODE_DESCRIPTOR_CLID);
+
+    if (nodeDescriptor && node->nodeDescriptor().isNull())
+    {
+        QDataStream stream(nodeDescriptor->data);
+        stream.setByteOrder(QDataStream::LittleEndian);
+
+        deCONZ::NodeDescriptor nd;
+        nd.readFromStream(stream);
+
+        if (stream.status() == QDataStream::Ok && !nd.isNull())
+        {
+            n->setNodeDescriptor(nd);
+            count++;
+        }
+    }
+
+    if (node->nodeDescriptor().isNull())
+    {
+        return count; // manufacturer code is needed to parse simple descriptors
+    }
+
+    for (const DB_ZdpDescriptor &desc : i->second)
     {
-        U_sstream_init(&ss, sqlBuf, sizeof(sqlBuf));
+        if (desc.type != ZDP_SIMPLE_DESCRIPTOR_CLID)
+        {
+            continue;
+        }
 
-        // query again to get device id
-        U_sstream_put_str(&ss, "SELECT id, nwk FROM devices WHERE mac = '");
-        U_sstream_put_mac_address(&ss, dev.mac);
-        U_sstream_put_str(&ss, "'");
+        deCONZ::SimpleDescriptor known;
+        if (node->copySimpleDescriptor(desc.endpoint, &known) == 0 && known.deviceId() != 0xffff)
+        {
+            continue; // already known
+        }
 
-        entry.id = -1;
-        entry.nwk = -1;
-        entry.creationTime = -1;
+        QDataStream stream(desc.data);
+        stream.setByteOrder(QDataStream::LittleEndian);
 
-        rc = sqlite3_exec(db, sqlBuf, loadDeviceCallback, &entry, nullptr);
+        deCONZ::SimpleDescriptor sd;
+        sd.readFromStream(stream, node->nodeDescriptor().manufacturerCode());
 
-        if (rc == SQLITE_OK && entry.id != -1)
+        if (stream.status() == QDataStream::Ok && sd.isValid() && sd.endpoint() == desc.endpoint && sd.deviceId() != 0xffff)
         {
-            dev.deviceId = entry.id;
-            dev.creationTime = entry.creationTime;
-            return 1;
+            n->setSimpleDescriptor(sd);
+            count++;
         }
     }
 
-    return 0;
+    if (count > 0)
+    {
+        DBG_Printf(DBG_INFO, "DB restored %d ZDP descriptors of " FMT_MAC "\n", count, FMT_MAC_CAST(node->address().ext()));
+    }
+
+    return count;
 }
 
 /*! Push/update a zdp descriptor in the database to cache node data.
@@ -1105,6 +2138,14 @@ void DeRestPluginPrivate::pushZdpDescriptorDb(quint64 extAddress, quint8 endpoin
 {
     DBG_Printf(DBG_INFO_L2, "DB pushZdpDescriptorDb()\n");
 
+    DB_LoadZdpDescriptors();
+
+    const DB_ZdpDescriptor *cached = DB_FindZdpDescriptor(extAddress, endpoint, type);
+    if (cached && cached->data == data)
+    {
+        return; // already stored
+    }
+
     openDb();
     DBG_Assert(db);
     if (!db)
@@ -1112,12 +2153,6 @@ void DeRestPluginPrivate::pushZdpDescriptorDb(quint64 extAddress, quint8 endpoin
         return;
     }
 
-    // store now to make sure 'devices' table is populated
-    if (!dbQueryQueue.empty())
-    {
-        saveDb();
-    }
-
     qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
     const QString uniqueid = generateUniqueId(extAddress, 0, 0);
     char mac[23 + 1];
@@ -1175,6 +2210,11 @@ void DeRestPluginPrivate::pushZdpDescriptorDb(quint64 extAddress, quint8 endpoin
     rc = sqlite3_finalize(res);
     DBG_Assert(rc == SQLITE_OK);
 
+    if (rows > 0)
+    {
+        DB_CacheZdpDescriptor(extAddress, endpoint, type, data);
+    }
+
     if (rows != 0) // error or already existing
     {
         return;
@@ -1198,140 +2238,457 @@ void DeRestPluginPrivate::pushZdpDescriptorDb(quint64 extAddress, quint8 endpoin
         DBG_Assert(rc == SQLITE_OK);
     }
 
-    if (rc == SQLITE_OK)
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int64(res, 2, now);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_text(res, 3, mac, -1, SQLITE_STATIC);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int(res, 4, endpoint);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int(res, 5, type);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc != SQLITE_OK)
+    {
+        DBG_Printf(DBG_INFO, "DB failed %s\n", sqlite3_errmsg(db));
+        if (res)
+        {
+            rc = sqlite3_finalize(res);
+            DBG_Assert(rc == SQLITE_OK);
+        }
+        return;
+    }
+
+#if SQLITE_VERSION_NUMBER > 3014000
+    auto exp = sqlite3_expanded_sql(res);
+    if (exp)
+    {
+        DBG_Printf(DBG_INFO, "DB %s\n", exp);
+        sqlite3_free(exp);
+    }
+#endif
+
+    int changes = -1;
+    rc = sqlite3_step(res);
+    if (rc == SQLITE_DONE)
+    {
+        changes = sqlite3_changes(db);
+    }
+    DBG_Assert(rc == SQLITE_DONE);
+
+    rc = sqlite3_finalize(res);
+    DBG_Assert(rc == SQLITE_OK);
+
+    if (rc != SQLITE_OK)
+    {
+        return;
+    }
+
+    if (changes == 1)
+    {
+        DB_CacheZdpDescriptor(extAddress, endpoint, type, data);
+        return; // done updating already existing entry
+    }
+
+    // 2) no existing entry, insert new entry
+    res = nullptr;
+    sql = "INSERT INTO device_descriptors (device_id, endpoint, type, data, timestamp)"
+          " SELECT id, ?1, ?2, ?3, ?4"
+          " FROM devices WHERE mac = ?5";
+
+    rc = sqlite3_prepare_v2(db, sql, -1, &res, nullptr);
+    DBG_Assert(res);
+    DBG_Assert(rc == SQLITE_OK);
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int(res, 1, endpoint);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int(res, 2, type);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_blob(res, 3, data.constData(), data.size(), SQLITE_STATIC);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int64(res, 4, now);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_text(res, 5, mac, -1, SQLITE_STATIC);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    if (rc != SQLITE_OK)
+    {
+        DBG_Printf(DBG_INFO, "DB failed %s\n", sqlite3_errmsg(db));
+        if (res)
+        {
+            rc = sqlite3_finalize(res);
+            DBG_Assert(rc == SQLITE_OK);
+        }
+        return;
+    }
+
+#if SQLITE_VERSION_NUMBER > 3014000
+    exp = sqlite3_expanded_sql(res);
+    if (exp)
+    {
+        DBG_Printf(DBG_INFO, "DB %s\n", exp);
+        sqlite3_free(exp);
+    }
+#endif
+
+    rc = sqlite3_step(res);
+    if (rc == SQLITE_DONE)
+    {
+        changes = sqlite3_changes(db);
+        DBG_Assert(changes == 1);
+    }
+    rc = sqlite3_finalize(res);
+    DBG_Assert(rc == SQLITE_OK);
+
+    if (changes == 1)
+    {
+        DB_CacheZdpDescriptor(extAddress, endpoint, type, data);
+    }
+    closeDb();
+}
+
+/*! ZCL value history, persisted in the 'zcl_series' table. */
+static TS_Store dbTimeSeries;
+static bool dbTimeSeriesLoaded = false;
+static std::vector<std::pair<TS_Key, TS_Sample>> dbTimeSeriesPending; // live samples before readDeferredDb()
+
+/*! 'zcl_values' rows which hold the value history, the remaining rows are the
+    single values of DB_StoreZclValue(): app version, OTA file version and IAS zone type.
+ */
+static const char *dbLegacyHistoryFilter = "NOT ((cluster = 0 AND attribute = 1) OR (cluster = 25 AND attribute = 2) OR (cluster = 1280 AND attribute = 1))";
+
+/*! Imports the history of the former 'zcl_values' based store into \p store.
+
+    Only samples older than the already present history of a series are imported,
+    they are put in front of it.
+ */
+static void DB_ImportLegacyZclValues(TS_Store *store)
+{
+    snprintf(sqlBuf, sizeof(sqlBuf), "SELECT devices.mac, endpoint, cluster, attribute, data, zcl_values.timestamp"
+                                     " FROM zcl_values INNER JOIN devices ON zcl_values.device_id = devices.id"
+                                     " WHERE %s ORDER BY zcl_values.timestamp", dbLegacyHistoryFilter);
+
+    sqlite3_stmt *res = nullptr;
+    int rc = sqlite3_prepare_v2(db, sqlBuf, -1, &res, nullptr);
+    DBG_Assert(rc == SQLITE_OK);
+
+    std::map<TS_Key, std::vector<TS_Sample>, bool(*)(const TS_Key&, const TS_Key&)> samples(TS_KeyLess);
+
+    while (rc == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
+    {
+        const char *mac = reinterpret_cast<const char*>(sqlite3_column_text(res, 0));
+        if (!mac)
+        {
+            continue;
+        }
+
+        TS_Key key;
+        key.extAddr = extAddressFromUniqueId(QLatin1String(mac));
+        key.endpoint = static_cast<uint8_t>(sqlite3_column_int(res, 1));
+        key.clusterId = static_cast<uint16_t>(sqlite3_column_int(res, 2));
+        key.attributeId = static_cast<uint16_t>(sqlite3_column_int(res, 3));
+
+        if (key.extAddr == 0)
+        {
+            continue;
+        }
+
+        const TS_Sample sample{sqlite3_column_int64(res, 5), sqlite3_column_int64(res, 4)};
+        const TS_Series *series = store->series(key);
+
+        if (series && !series->blocks.empty() && sample.t >= series->blocks.front().t0)
+        {
+            continue; // already covered by the present history
+        }
+
+        samples[key].push_back(sample);
+    }
+
+    if (res)
+    {
+        sqlite3_finalize(res);
+    }
+
+    size_t count = 0;
+    for (const auto &i : samples)
+    {
+        count += store->insert(i.first, i.second);
+    }
+
+    DBG_Printf(DBG_INFO, "DB imported %zu zcl_values into time series\n", count);
+}
+
+/*! Reads the history blocks with samples since \p minTime from 'zcl_series' into \p store.
+    \returns the number of loaded blocks, or -1 on error
+ */
+static int DB_ReadTimeSeries(TS_Store *store, int64_t minTime)
+{
+    const char *sql = "SELECT mac, endpoint, cluster, attribute, t0, data FROM zcl_series WHERE t1 >= ?1";
+
+    sqlite3_stmt *res = nullptr;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &res, nullptr);
+    DBG_Assert(rc == SQLITE_OK);
+
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_bind_int64(res, 1, minTime);
+        DBG_Assert(rc == SQLITE_OK);
+    }
+
+    int blocks = 0;
+    while (rc == SQLITE_OK && sqlite3_step(res) == SQLITE_ROW)
+    {
+        TS_Key key;
+        key.extAddr = static_cast<uint64_t>(sqlite3_column_int64(res, 0));
+        key.endpoint = static_cast<uint8_t>(sqlite3_column_int(res, 1));
+        key.clusterId = static_cast<uint16_t>(sqlite3_column_int(res, 2));
+        key.attributeId = static_cast<uint16_t>(sqlite3_column_int(res, 3));
+        const int64_t t0 = sqlite3_column_int64(res, 4);
+        const auto *data = static_cast<const uint8_t*>(sqlite3_column_blob(res, 5));
+        const int size = sqlite3_column_bytes(res, 5);
+
+        if (data && size > 0 && store->loadBlock(key, t0, data, static_cast<size_t>(size)))
+        {
+            blocks++;
+        }
+    }
+
+    if (res)
+    {
+        sqlite3_finalize(res);
+    }
+
+    return rc == SQLITE_OK ? blocks : -1;
+}
+
+/*! Writes the changed blocks of \p store to 'zcl_series'.
+    \returns true if all blocks were written
+ */
+static bool DB_WriteTimeSeries(TS_Store *store)
+{
+    const char *sql = "REPLACE INTO zcl_series (mac, endpoint, cluster, attribute, t0, t1, count, data)"
+                      " VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)";
+
+    sqlite3_stmt *res = nullptr;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &res, nullptr);
+    DBG_Assert(rc == SQLITE_OK);
+
+    bool ok = rc == SQLITE_OK;
+
+    if (rc == SQLITE_OK)
+    {
+        for (TS_Series &series : store->allSeries())
+        {
+            for (TS_Block &block : series.blocks)
+            {
+                if (!block.dirty)
+                {
+                    continue;
+                }
+
+                sqlite3_reset(res);
+                sqlite3_bind_int64(res, 1, static_cast<sqlite3_int64>(series.key.extAddr));
+                sqlite3_bind_int(res, 2, series.key.endpoint);
+                sqlite3_bind_int(res, 3, series.key.clusterId);
+                sqlite3_bind_int(res, 4, series.key.attributeId);
+                sqlite3_bind_int64(res, 5, block.t0);
+                sqlite3_bind_int64(res, 6, block.t1);
+                sqlite3_bind_int(res, 7, static_cast<int>(block.count));
+                sqlite3_bind_blob(res, 8, block.data.data(), static_cast<int>(block.data.size()), SQLITE_STATIC);
+
+                rc = sqlite3_step(res);
+                if (rc == SQLITE_DONE)
+                {
+                    block.dirty = false;
+                }
+                else
+                {
+                    DBG_Printf(DBG_ERROR, "DB failed to store time series block: %s\n", sqlite3_errmsg(db));
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    if (res)
     {
-        rc = sqlite3_bind_int64(res, 2, now);
-        DBG_Assert(rc == SQLITE_OK);
+        sqlite3_finalize(res);
     }
 
-    if (rc == SQLITE_OK)
-    {
-        rc = sqlite3_bind_text(res, 3, mac, -1, SQLITE_STATIC);
-        DBG_Assert(rc == SQLITE_OK);
-    }
+    return ok;
+}
 
-    if (rc == SQLITE_OK)
+/*! Upgrades database to user_version 12.
+
+    Moves the value history of 'zcl_values' into 'zcl_series' blocks and removes
+    the imported rows, so the import runs only once.
+ */
+static bool upgradeDbToUserVersion12()
+{
+    DBG_Printf(DBG_INFO, "DB upgrade to user_version 12\n");
+
+    TS_Store store;
+
+    if (DB_ReadTimeSeries(&store, 0) < 0)
     {
-        rc = sqlite3_bind_int(res, 4, endpoint);
-        DBG_Assert(rc == SQLITE_OK);
+        return false;
     }
 
-    if (rc == SQLITE_OK)
+    DB_ImportLegacyZclValues(&store);
+
+    if (!DB_WriteTimeSeries(&store))
     {
-        rc = sqlite3_bind_int(res, 5, type);
-        DBG_Assert(rc == SQLITE_OK);
+        return false;
     }
 
+    snprintf(sqlBuf, sizeof(sqlBuf), "DELETE FROM zcl_values WHERE %s", dbLegacyHistoryFilter);
+
+    char *errmsg = nullptr;
+    int rc = sqlite3_exec(db, sqlBuf, nullptr, nullptr, &errmsg);
+
     if (rc != SQLITE_OK)
     {
-        DBG_Printf(DBG_INFO, "DB failed %s\n", sqlite3_errmsg(db));
-        if (res)
+        if (errmsg)
         {
-            rc = sqlite3_finalize(res);
-            DBG_Assert(rc == SQLITE_OK);
+            DBG_Printf(DBG_ERROR_L2, "SQL exec failed: %s, error: %s (%d), line: %d\n", sqlBuf, errmsg, rc, __LINE__);
+            sqlite3_free(errmsg);
         }
-        return;
+        return false;
     }
 
-#if SQLITE_VERSION_NUMBER > 3014000
-    auto exp = sqlite3_expanded_sql(res);
-    if (exp)
-    {
-        DBG_Printf(DBG_INFO, "DB %s\n", exp);
-        sqlite3_free(exp);
-    }
-#endif
+    return setDbUserVersion(12);
+}
 
-    int changes = -1;
-    rc = sqlite3_step(res);
-    if (rc == SQLITE_DONE)
+/*! Loads the ZCL value history blocks from the database once, see readDeferredDb().
+    Live samples which arrived before are appended afterwards.
+    \returns true if pending samples were appended
+ */
+static bool DB_LoadTimeSeries(int64_t minTime)
+{
+    if (dbTimeSeriesLoaded || !db)
     {
-        changes = sqlite3_changes(db);
+        return false;
     }
-    DBG_Assert(rc == SQLITE_DONE);
 
-    rc = sqlite3_finalize(res);
-    DBG_Assert(rc == SQLITE_OK);
+    dbTimeSeriesLoaded = true;
 
-    if (rc != SQLITE_OK)
+    const int blocks = DB_ReadTimeSeries(&dbTimeSeries, minTime);
+
+    bool appended = false;
+    for (const auto &i : dbTimeSeriesPending)
     {
-        return;
+        appended |= dbTimeSeries.append(i.first, i.second.t, i.second.value);
     }
+    dbTimeSeriesPending.clear();
 
-    if (changes == 1)
+    DBG_Printf(DBG_INFO, "DB loaded %d time series blocks, %zu bytes\n", blocks, dbTimeSeries.memoryUsage());
+    return appended;
+}
+
+/*! Writes changed ZCL value history blocks and removes expired ones. */
+static void DB_StoreTimeSeries(int64_t minTime)
+{
+    if (!dbTimeSeriesLoaded)
     {
-        return; // done updating already existing entry
+        return; // nothing appended yet
     }
 
-    // 2) no existing entry, insert new entry
-    res = nullptr;
-    sql = "INSERT INTO device_descriptors (device_id, endpoint, type, data, timestamp)"
-          " SELECT id, ?1, ?2, ?3, ?4"
-          " FROM devices WHERE mac = ?5";
+    dbTimeSeries.expire(minTime);
+    DB_WriteTimeSeries(&dbTimeSeries);
 
-    rc = sqlite3_prepare_v2(db, sql, -1, &res, nullptr);
-    DBG_Assert(res);
-    DBG_Assert(rc == SQLITE_OK);
+    snprintf(sqlBuf, sizeof(sqlBuf), "DELETE FROM zcl_series WHERE t1 < %lld", static_cast<long long>(minTime));
 
-    if (rc == SQLITE_OK)
+    char *errmsg = nullptr;
+    int rc = sqlite3_exec(db, sqlBuf, nullptr, nullptr, &errmsg);
+    if (rc != SQLITE_OK && errmsg)
     {
-        rc = sqlite3_bind_int(res, 1, endpoint);
-        DBG_Assert(rc == SQLITE_OK);
+        DBG_Printf(DBG_ERROR, "DB sqlite3_exec failed: %s, error: %s\n", sqlBuf, errmsg);
+        sqlite3_free(errmsg);
     }
+}
 
-    if (rc == SQLITE_OK)
-    {
-        rc = sqlite3_bind_int(res, 2, type);
-        DBG_Assert(rc == SQLITE_OK);
-    }
+/*! Appends the history of the series \p key to \p ls.
 
-    if (rc == SQLITE_OK)
+    Without \c query.bucket the raw samples are returned, otherwise one entry per bucket
+    with min/max/avg/sum/last/count computed by the history store.
+    At most \c query.max entries in ascending time order are added.
+ */
+static void DB_AppendHistory(QVariantList &ls, const char *suffix, const TS_Key &key, const DB_HistoryQuery &query)
+{
+    if (query.max <= 0 || query.toTime <= query.fromTime)
     {
-        rc = sqlite3_bind_blob(res, 3, data.constData(), data.size(), SQLITE_STATIC);
-        DBG_Assert(rc == SQLITE_OK);
+        return;
     }
 
-    if (rc == SQLITE_OK)
-    {
-        rc = sqlite3_bind_int64(res, 4, now);
-        DBG_Assert(rc == SQLITE_OK);
-    }
+    const size_t max = static_cast<size_t>(query.max);
 
-    if (rc == SQLITE_OK)
+    if (query.bucket <= 0)
     {
-        rc = sqlite3_bind_text(res, 5, mac, -1, SQLITE_STATIC);
-        DBG_Assert(rc == SQLITE_OK);
-    }
+        std::vector<TS_Sample> samples;
+        dbTimeSeries.query(key, query.fromTime + 1, query.toTime, max, &samples);
 
-    if (rc != SQLITE_OK)
-    {
-        DBG_Printf(DBG_INFO, "DB failed %s\n", sqlite3_errmsg(db));
-        if (res)
+        for (const TS_Sample &sample : samples)
         {
-            rc = sqlite3_finalize(res);
-            DBG_Assert(rc == SQLITE_OK);
+            QVariantMap map;
+            map[suffix] = static_cast<qint64>(sample.value);
+            map["t"] = QDateTime::fromMSecsSinceEpoch(sample.t * 1000).toString(QLatin1String("yyyy-MM-ddTHH:mm:ss"));
+            ls.append(map);
         }
         return;
     }
 
-#if SQLITE_VERSION_NUMBER > 3014000
-    exp = sqlite3_expanded_sql(res);
-    if (exp)
-    {
-        DBG_Printf(DBG_INFO, "DB %s\n", exp);
-        sqlite3_free(exp);
-    }
-#endif
+    // the bucket which contains fromTime was returned by the previous page
+    const int64_t from = TS_AlignDown(query.fromTime, query.bucket) + query.bucket;
+    std::vector<TS_Rollup> buckets;
+    dbTimeSeries.aggregate(key, from, query.toTime, query.bucket, max, &buckets);
 
-    rc = sqlite3_step(res);
-    if (rc == SQLITE_DONE)
+    for (const TS_Rollup &b : buckets)
     {
-        changes = sqlite3_changes(db);
-        DBG_Assert(changes == 1);
+        QVariantMap map;
+        const double avg = b.count ? double(b.sum) / b.count : 0.0;
+        map[suffix] = avg;
+        map["t"] = QDateTime::fromMSecsSinceEpoch(b.t * 1000).toString(QLatin1String("yyyy-MM-ddTHH:mm:ss"));
+        map["min"] = static_cast<qint64>(b.min);
+        map["max"] = static_cast<qint64>(b.max);
+        map["avg"] = avg;
+        map["sum"] = static_cast<qint64>(b.sum);
+        map["last"] = static_cast<qint64>(b.last);
+        map["count"] = static_cast<double>(b.count);
+        ls.append(map);
     }
-    rc = sqlite3_finalize(res);
-    DBG_Assert(rc == SQLITE_OK);
-    closeDb();
 }
 
 /*! Push a zcl value sample in the database to keep track of value history.
@@ -1344,39 +2701,25 @@ void DeRestPluginPrivate::pushZclValueDb(quint64 extAddress, quint8 endpoint, qu
         return; // zcl value datastore disabled
     }
 
-    /*
-
-    select mac, printf('0x%04X', cluster), data, datetime(zcl_values.timestamp,'unixepoch','localtime')
-    from zcl_values inner join devices ON zcl_values.device_id = devices.id
-    where zcl_values.timestamp > strftime('%s','now') - 300;
-
-    */
-    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
-    QString sql = QString(QLatin1String(
-                              "INSERT INTO zcl_values (device_id,endpoint,cluster,attribute,data,timestamp) "
-                              "SELECT id, %2, %3, %4, %5, %6 "
-                              "FROM devices WHERE mac = '%1'"))
-            .arg(generateUniqueId(extAddress, 0, 0))
-            .arg(endpoint)
-            .arg(clusterId)
-            .arg(attributeId)
-            .arg(data)
-            .arg(now);
+    TS_Key key;
+    key.extAddr = extAddress;
+    key.endpoint = endpoint;
+    key.clusterId = clusterId;
+    key.attributeId = attributeId;
 
-    dbQueryQueue.push_back(sql);
-    queSaveDb(DB_QUERY_QUEUE, (dbQueryQueue.size() > 30) ? DB_SHORT_SAVE_DELAY : DB_LONG_SAVE_DELAY);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
 
-    // add a cleanup command if not already queued
-    for (const QString &q : dbQueryQueue)
+    if (!dbTimeSeriesLoaded)
     {
-        if (q.startsWith(QLatin1String("DELETE FROM zcl_values")))
-        {
-            return; // already queued
-        }
+        // the history is loaded by readDeferredDb(), keep the sample until then
+        dbTimeSeriesPending.push_back({key, TS_Sample{now, data}});
+        return;
     }
 
-    sql = QString(QLatin1String("DELETE FROM zcl_values WHERE timestamp < %1")).arg(now - dbZclValueMaxAge);
-    dbQueryQueue.push_back(sql);
+    if (dbTimeSeries.append(key, now, data))
+    {
+        queSaveDb(DB_TIMESERIES, DB_LONG_SAVE_DELAY);
+    }
 }
 
 bool DeRestPluginPrivate::dbIsOpen() const
@@ -1409,11 +2752,11 @@ void DeRestPluginPrivate::openDb()
     rc = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
     DBG_Assert(rc == SQLITE_OK);
 
+    DB_ApplyProfile();
+
     ttlDataBaseConnection = idleTotalCounter + DB_CONNECTION_TTL;
 
-#ifdef DECONZ_DEBUG_BUILD
-    sqlite3_update_hook(db, DB_UpdateHook, this);
-#endif
+    DB_InstallStatementHooks();
 }
 
 /*! Reads all data sets from sqlite database.
@@ -1422,23 +2765,264 @@ void DeRestPluginPrivate::readDb()
 {
     DBG_Assert(db != 0);
 
-    if (!db)
+    if (!db)
+    {
+        return;
+    }
+
+    int64_t t = DB_StartupElapsed();
+
+    loadAuthFromDb();
+    t = DB_StartupRecord("auth", t);
+    loadConfigFromDb();
+    t = DB_StartupRecord("config", t);
+    loadUserparameterFromDb();
+    t = DB_StartupRecord("userparameter", t);
+    loadAllGroupsFromDb();
+    t = DB_StartupRecord("groups", t);
+    loadAllResourcelinksFromDb();
+    t = DB_StartupRecord("resourcelinks", t);
+    loadAllSensorsFromDb();
+    t = DB_StartupRecord("sensors", t);
+#ifdef USE_GATEWAY_API
+    loadAllGatewaysFromDb();
+    t = DB_StartupRecord("gateways", t);
+#endif
+
+    // scenes, rules, schedules and the value history aren't needed to serve the first
+    // requests and route indications, ZDP descriptors are loaded on demand
+    dbDeferredLoaded = false;
+}
+
+/*! Loads the tables skipped by readDb().
+
+    Runs from the first idle timer tick or earlier on first access, when a REST
+    request or an indication arrives before that.
+ */
+void DeRestPluginPrivate::readDeferredDb()
+{
+    if (dbDeferredLoaded)
+    {
+        return;
+    }
+
+    dbDeferredLoaded = true;
+
+    openDb();
+
+    int64_t t = DB_StartupElapsed();
+
+    loadAllScenesFromDb();
+    t = DB_StartupRecord("scenes", t);
+    loadAllRulesFromDb();
+    t = DB_StartupRecord("rules", t);
+    loadAllSchedulesFromDb();
+    t = DB_StartupRecord("schedules", t);
+
+    if (dbZclValueMaxAge > 0)
+    {
+        if (DB_LoadTimeSeries(QDateTime::currentMSecsSinceEpoch() / 1000 - dbZclValueMaxAge))
+        {
+            queSaveDb(DB_TIMESERIES, DB_LONG_SAVE_DELAY);
+        }
+        t = DB_StartupRecord("history", t);
+    }
+    DB_StartupRecord("complete", t);
+
+    closeDb();
+}
+
+/*! Starts recording the startup timeline. */
+void DB_StartupBegin()
+{
+    dbStartupTime.start();
+    dbStartupTimeline.clear();
+}
+
+/*! Returns milliseconds since DB_StartupBegin(). */
+int64_t DB_StartupElapsed()
+{
+    return dbStartupTime.isValid() ? dbStartupTime.elapsed() : 0;
+}
+
+/*! Records \p phase which started at \p startMs and ends now.
+    \returns the end time, as start of the next phase
+ */
+int64_t DB_StartupRecord(const char *phase, int64_t startMs)
+{
+    DB_StartupPhase p;
+    p.name = phase;
+    p.startMs = startMs;
+    p.endMs = DB_StartupElapsed();
+
+    DBG_Printf(DBG_INFO, "startup %s in %d ms (at %d ms)\n", phase, int(p.endMs - p.startMs), int(p.endMs));
+
+    dbStartupTimeline.push_back(p);
+    return p.endMs;
+}
+
+const std::vector<DB_StartupPhase> &DB_StartupTimeline()
+{
+    return dbStartupTimeline;
+}
+
+/*! Returns a stamp of the database file which changes with every write. */
+static uint64_t DB_FileStamp(const QString &path)
+{
+    const QFileInfo fi(path);
+
+    if (!fi.exists())
+    {
+        return 0;
+    }
+
+    return (uint64_t(fi.size()) << 32) ^ uint64_t(fi.lastModified().toMSecsSinceEpoch());
+}
+
+/*! Items which are persisted in 'resource_items', same as in DB_StoreSubDeviceItem(). */
+static bool DB_IsSnapshotItem(const ResourceItem *item)
+{
+    const char *suffix = item->descriptor().suffix;
+
+    if ((suffix == RAttrMode && item->toNumber() == Sensor::ModeScenes) || suffix == RStatePresence)
+    {
+        return false;
+    }
+
+    return item->lastChanged().isValid();
+}
+
+static void DB_AddSnapshotResource(SNAP_Writer &writer, const Resource *r)
+{
+    const ResourceItem *uniqueId = r->item(RAttrUniqueId);
+    if (!uniqueId || uniqueId->toLatin1String().size() == 0)
+    {
+        return;
+    }
+
+    writer.addResource(r->prefix(), uniqueId->toCString());
+
+    for (int i = 0; i < r->itemCount(); i++)
+    {
+        const ResourceItem *item = r->itemForIndex(size_t(i));
+
+        if (!item || !DB_IsSnapshotItem(item))
+        {
+            continue;
+        }
+
+        const QByteArray value = item->toVariant().toString().toUtf8();
+        writer.addItem(item->descriptor().suffix, value.constData(), size_t(value.size()), item->lastChanged().toMSecsSinceEpoch());
+    }
+}
+
+/*! Loads the snapshot written by writeStartupSnapshot() at the last clean shutdown.
+
+    Must be called before the database is opened since upgrades and clean-ups modify it.
+    A valid snapshot replaces the 'resource_items' query of DB_PreloadSubDeviceItems(),
+    the items are copied into the preload cache and the file is unmapped right away.
+    Otherwise all items are loaded from the database as before.
+ */
+void DeRestPluginPrivate::loadStartupSnapshot()
+{
+    const QString path = sqliteDatabaseName + QLatin1String(".snapshot");
+
+    if (deCONZ::appArgumentNumeric("--startup-snapshot", 1) == 0 || !QFile::exists(path))
+    {
+        return;
+    }
+
+    QFile file(path);
+    uchar *data = nullptr;
+    std::vector<SNAP_Item> items;
+
+    if (file.open(QIODevice::ReadOnly) && file.size() > 0)
+    {
+        data = file.map(0, file.size());
+    }
+
+    if (data && SNAP_Read(data, size_t(file.size()), DB_FileStamp(sqliteDatabaseName), &items))
+    {
+        DB_ReleaseSubDeviceItems();
+
+        for (const SNAP_Item &snap : items)
+        {
+            const std::string uniqueId(snap.uniqueId);
+            auto &subItems = dbSubItems[uniqueId];
+
+            if (uniqueId.size() >= 23)
+            {
+                dbSubItemsDevice.emplace(uniqueId.substr(0, 23), uniqueId);
+            }
+
+            DB_ResourceItem ritem;
+            ritem.name = snap.suffix;
+            ritem.value = QString::fromUtf8(snap.value, int(snap.valueSize));
+            ritem.timestampMs = snap.timestampMs;
+            subItems.push_back(std::move(ritem));
+        }
+
+        dbSubItemsPreloaded = true;
+        dbSubItemsAge.start();
+
+        file.unmap(data);
+        DBG_Printf(DBG_INFO, "DB startup snapshot with %d items of %d resources\n", int(items.size()), int(dbSubItems.size()));
+        return;
+    }
+
+    DBG_Printf(DBG_INFO, "DB startup snapshot doesn't match database, ignored\n");
+    file.close();
+    QFile::remove(path);
+}
+
+/*! Writes item values of all lights and sensors at clean shutdown.
+    Must be called after the database was closed since the snapshot is tied to the file stamp.
+ */
+void DeRestPluginPrivate::writeStartupSnapshot()
+{
+    const QString path = sqliteDatabaseName + QLatin1String(".snapshot");
+
+    if (deCONZ::appArgumentNumeric("--startup-snapshot", 1) == 0 || db)
     {
+        QFile::remove(path);
         return;
     }
 
-    loadAuthFromDb();
-    loadConfigFromDb();
-    loadUserparameterFromDb();
-    loadAllGroupsFromDb();
-    loadAllResourcelinksFromDb();
-    loadAllScenesFromDb();
-    loadAllRulesFromDb();
-    loadAllSchedulesFromDb();
-    loadAllSensorsFromDb();
-#ifdef USE_GATEWAY_API
-    loadAllGatewaysFromDb();
-#endif
+    QElapsedTimer measTimer;
+    measTimer.start();
+
+    SNAP_Writer writer;
+
+    for (const Sensor &sensor : sensors)
+    {
+        if (sensor.deletedState() == Sensor::StateNormal)
+        {
+            DB_AddSnapshotResource(writer, &sensor);
+        }
+    }
+
+    for (const LightNode &lightNode : nodes)
+    {
+        if (lightNode.state() == LightNode::StateNormal)
+        {
+            DB_AddSnapshotResource(writer, &lightNode);
+        }
+    }
+
+    const std::vector<uint8_t> &data = writer.finish(DB_FileStamp(sqliteDatabaseName));
+
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) &&
+        file.write(reinterpret_cast<const char*>(data.data()), qint64(data.size())) == qint64(data.size()) &&
+        file.commit())
+    {
+        DBG_Printf(DBG_INFO, "DB wrote startup snapshot, %d items, %d bytes in %d ms\n", int(writer.itemCount()), int(data.size()), int(measTimer.elapsed()));
+    }
+    else
+    {
+        DBG_Printf(DBG_ERROR, "DB failed to write startup snapshot %s\n", qPrintable(path));
+        QFile::remove(path);
+    }
 }
 
 /*! Sqlite callback to load authorisation data.
@@ -1955,6 +3539,13 @@ static int sqliteLoadConfigCallback(void *user, int ncols, char **colval , char
             d->gwConfig["websocketport"] = port;
         }
     }
+    else if (strcmp(colval[0], "dbprofile") == 0)
+    {
+        if (!val.isEmpty() && DB_SelectProfile(QLatin1String(colval[1])))
+        {
+            d->gwConfig["dbprofile"] = val;
+        }
+    }
     else if (strcmp(colval[0], "websocketnotifyall") == 0)
     {
       if (!val.isEmpty())
@@ -2090,6 +3681,9 @@ void DeRestPluginPrivate::loadConfigFromDb()
             }
         }
     }
+
+    // the journal mode can't be changed while the SELECT above runs
+    DB_ApplyProfile();
 }
 
 /*! Loads all config from database
@@ -2638,7 +4232,7 @@ void DeRestPluginPrivate::loadAllSchedulesFromDb()
 
 /*! Load sensor data from database.
  */
-void DeRestPluginPrivate::loadSensorDataFromDb(Sensor *sensor, QVariantList &ls, qint64 fromTime, int max)
+void DeRestPluginPrivate::loadSensorDataFromDb(Sensor *sensor, QVariantList &ls, const DB_HistoryQuery &query)
 {
     DBG_Assert(db);
 
@@ -2685,66 +4279,8 @@ void DeRestPluginPrivate::loadSensorDataFromDb(Sensor *sensor, QVariantList &ls,
                 continue;
             }
 
-            const char *sql = "SELECT data,timestamp FROM sensor_device_value_view "
-                              "WHERE sensor_id = ?1 AND timestamp > ?2 AND cluster_id = ?3 limit ?4";
-
-            int rc;
-            int sid = sensor->id().toInt();
-            sqlite3_stmt *res = nullptr;
-
-            rc = sqlite3_prepare_v2(db, sql, -1, &res, nullptr);
-            DBG_Assert(res != nullptr);
-            DBG_Assert(rc == SQLITE_OK);
-
-            if (rc == SQLITE_OK)
-            {
-                rc = sqlite3_bind_int(res, 1, sid);
-                DBG_Assert(rc == SQLITE_OK);
-            }
-
-            if (rc == SQLITE_OK)
-            {
-                rc = sqlite3_bind_int64(res, 2, fromTime);
-                DBG_Assert(rc == SQLITE_OK);
-            }
-
-            if (rc == SQLITE_OK)
-            {
-                rc = sqlite3_bind_int(res, 3, r->clusterId);
-                DBG_Assert(rc == SQLITE_OK);
-            }
-
-            if (rc == SQLITE_OK)
-            {
-                rc = sqlite3_bind_int(res, 4, max);
-                DBG_Assert(rc == SQLITE_OK);
-            }
-
-            if (rc != SQLITE_OK)
-            {
-                if (res)
-                {
-                    rc = sqlite3_finalize(res);
-                    DBG_Assert(rc == SQLITE_OK);
-                }
-                continue;
-            }
-
-            while (sqlite3_step(res) == SQLITE_ROW)
-            {
-                QVariantMap map;
-                qint64 val = sqlite3_column_int64(res, 0);
-                qint64 timestamp = sqlite3_column_int64(res, 1);
-
-                QDateTime dateTime;
-                dateTime.setMSecsSinceEpoch(timestamp * 1000);
-                map[item->descriptor().suffix] = val;
-                map["t"] = dateTime.toString(QLatin1String("yyyy-MM-ddTHH:mm:ss"));
-                ls.append(map);
-            }
-
-            rc = sqlite3_finalize(res);
-            DBG_Assert(rc == SQLITE_OK);
+            const TS_Key key{sensor->address().ext(), r->clusterId, r->attributeId, sensor->fingerPrint().endpoint};
+            DB_AppendHistory(ls, item->descriptor().suffix, key, query);
         }
         r++;
     }
@@ -2752,7 +4288,7 @@ void DeRestPluginPrivate::loadSensorDataFromDb(Sensor *sensor, QVariantList &ls,
 
 /*! Load light from database.
  */
-void DeRestPluginPrivate::loadLightDataFromDb(LightNode *lightNode, QVariantList &ls, qint64 fromTime, int max)
+void DeRestPluginPrivate::loadLightDataFromDb(LightNode *lightNode, QVariantList &ls, const DB_HistoryQuery &query)
 {
     DBG_Assert(db);
 
@@ -2802,68 +4338,8 @@ void DeRestPluginPrivate::loadLightDataFromDb(LightNode *lightNode, QVariantList
             continue;
         }
 
-        const char *sql = "SELECT data,timestamp FROM light_device_value_view "
-                          "WHERE light_id = ?1 AND timestamp > ?2 AND cluster_id = ?3 limit ?4";
-
-        int rc;
-        int sid = lightNode->id().toInt();
-        sqlite3_stmt *res = nullptr;
-
-        rc = sqlite3_prepare_v2(db, sql, -1, &res, 0);
-        DBG_Assert(res != nullptr);
-        DBG_Assert(rc == SQLITE_OK);
-
-        if (rc == SQLITE_OK)
-        {
-            rc = sqlite3_bind_int(res, 1, sid);
-            DBG_Assert(rc == SQLITE_OK);
-        }
-
-        if (rc == SQLITE_OK)
-        {
-            rc = sqlite3_bind_int(res, 2, fromTime);
-            DBG_Assert(rc == SQLITE_OK);
-        }
-
-        if (rc == SQLITE_OK)
-        {
-            rc = sqlite3_bind_int(res, 3, found->clusterId);
-            DBG_Assert(rc == SQLITE_OK);
-        }
-
-        // TODO zcl attribute
-
-        if (rc == SQLITE_OK)
-        {
-            rc = sqlite3_bind_int(res, 4, max);
-            DBG_Assert(rc == SQLITE_OK);
-        }
-
-        if (rc != SQLITE_OK)
-        {
-            if (res)
-            {
-                rc = sqlite3_finalize(res);
-                DBG_Assert(rc == SQLITE_OK);
-            }
-            continue;
-        }
-
-        while (sqlite3_step(res) == SQLITE_ROW)
-        {
-            QVariantMap map;
-            qint64 val = sqlite3_column_int64(res, 0);
-            qint64 timestamp = sqlite3_column_int64(res, 1);
-
-            QDateTime dateTime;
-            dateTime.setMSecsSinceEpoch(timestamp * 1000);
-            map[item->descriptor().suffix] = val;
-            map["t"] = dateTime.toString(QLatin1String("yyyy-MM-ddTHH:mm:ss"));
-            ls.append(map);
-        }
-
-        rc = sqlite3_finalize(res);
-        DBG_Assert(rc == SQLITE_OK);
+        const TS_Key key{lightNode->address().ext(), found->clusterId, found->attributeId, lightNode->haEndpoint().endpoint()};
+        DB_AppendHistory(ls, item->descriptor().suffix, key, query);
     }
 }
 
@@ -5102,6 +6578,7 @@ void DeRestPluginPrivate::saveDb()
         gwConfig["proxyaddress"] = gwProxyAddress;
         gwConfig["proxyport"] = gwProxyPort;
         gwConfig["zclvaluemaxage"] = dbZclValueMaxAge;
+        gwConfig["dbprofile"] = QLatin1String(DB_ProfileName(DB_GetProfile()));
         gwConfig["lightlastseeninterval"] = gwLightLastSeenInterval;
 
         QVariantMap::iterator i = gwConfig.begin();
@@ -5271,11 +6748,12 @@ void DeRestPluginPrivate::saveDb()
     // save nodes
     if (saveDatabaseItems & DB_LIGHTS)
     {
-        std::vector<LightNode>::iterator i = nodes.begin();
-        std::vector<LightNode>::iterator end = nodes.end();
+        const std::vector<size_t> dirty = DB_TakeDirtyIndexes(nodes, dbDirtyLights);
 
-        for (; i != end; ++i)
+        for (const size_t idx : dirty)
         {
+            LightNode *i = &nodes[idx];
+
             if (!i->needSaveDatabase())
             {
                 continue;
@@ -5288,6 +6766,8 @@ void DeRestPluginPrivate::saveDb()
                 // delete LightNode from db (if exist)
                 QString sql = QString("DELETE FROM nodes WHERE mac='%1'").arg(i->uniqueId());
                 sql.append(QString("; DELETE FROM devices WHERE mac = '%1'").arg(generateUniqueId(i->address().ext(), 0, 0)));
+                DB_ReleaseSubDeviceItems();
+                dbZdpDescriptors.erase(i->address().ext());
 
                 errmsg = NULL;
                 rc = sqlite3_exec(db, sql.toUtf8().constData(), NULL, NULL, &errmsg);
@@ -5309,7 +6789,7 @@ void DeRestPluginPrivate::saveDb()
                 Device *device = static_cast<Device*>(i->parentResource());
                 if (device && device->managed())
                 {
-                    DB_StoreSubDeviceItems(&*i);
+                    DB_StoreSubDeviceItems(i);
                 }
             }
 
@@ -5713,11 +7193,11 @@ void DeRestPluginPrivate::saveDb()
     // save/delete sensors
     if (saveDatabaseItems & DB_SENSORS)
     {
-        std::vector<Sensor>::iterator i = sensors.begin();
-        std::vector<Sensor>::iterator end = sensors.end();
+        const std::vector<size_t> dirty = DB_TakeDirtyIndexes(sensors, dbDirtySensors);
 
-        for (; i != end; ++i)
+        for (const size_t idx : dirty)
         {
+            Sensor *i = &sensors[idx];
 
             if (!i->needSaveDatabase())
             {
@@ -5731,6 +7211,8 @@ void DeRestPluginPrivate::saveDb()
                 // delete sensor from db (if exist)
                 QString sql = QString("DELETE FROM sensors WHERE uniqueid='%1'").arg(i->uniqueId());
                 sql.append(QString("; DELETE FROM devices WHERE mac = '%1'").arg(generateUniqueId(i->address().ext(), 0, 0)));
+                DB_ReleaseSubDeviceItems();
+                dbZdpDescriptors.erase(i->address().ext());
 
                 errmsg = NULL;
                 rc = sqlite3_exec(db, sql.toUtf8().constData(), NULL, NULL, &errmsg);
@@ -5762,7 +7244,7 @@ void DeRestPluginPrivate::saveDb()
                 Device *device = static_cast<Device*>(i->parentResource());
                 if (device && device->managed())
                 {
-                    DB_StoreSubDeviceItems(&*i);
+                    DB_StoreSubDeviceItems(i);
                 }
             }
 
@@ -5804,35 +7286,26 @@ void DeRestPluginPrivate::saveDb()
         saveDatabaseItems &= ~DB_SENSORS;
     }
 
-    // process query queue
-    if (saveDatabaseItems & DB_QUERY_QUEUE)
+    // save/expire zcl value history
+    if (saveDatabaseItems & DB_TIMESERIES)
     {
-        for (const QString &sql : dbQueryQueue)
-        {
-            if (DBG_IsEnabled(DBG_INFO_L2))
-            {
-                DBG_Printf(DBG_INFO_L2, "DB sql exec %s\n", qPrintable(sql));
-            }
-
-            errmsg = NULL;
-            rc = sqlite3_exec(db, sql.toUtf8().constData(), NULL, NULL, &errmsg);
-
-            if (rc != SQLITE_OK)
-            {
-                if (errmsg)
-                {
-                    DBG_Printf(DBG_ERROR, "DB sqlite3_exec failed: %s, error: %s\n", qPrintable(sql), errmsg);
-                    sqlite3_free(errmsg);
-                }
-            }
-        }
+        const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        DB_StoreTimeSeries(now - dbZclValueMaxAge);
+        saveDatabaseItems &= ~DB_TIMESERIES;
+    }
 
-        dbQueryQueue.clear();
-        saveDatabaseItems &= ~DB_QUERY_QUEUE;
+    // process typed write queue
+    if (saveDatabaseItems & DB_QUERY_QUEUE)
+    {
+        saveDatabaseItems &= ~DB_QUERY_QUEUE; // set again for failed writes
+        DB_ExecWriteQueue();
     }
 
     errmsg = NULL;
+    QElapsedTimer commitTimer;
+    commitTimer.start();
     rc = sqlite3_exec(db, "COMMIT", 0, 0, &errmsg);
+    DB_RecordCommit(rc, commitTimer.elapsed(), measTimer.elapsed());
     if (rc != SQLITE_OK)
     {
         if (errmsg)
@@ -5873,6 +7346,15 @@ void DeRestPluginPrivate::closeDb()
             return;
         }
 
+        if (ttlDataBaseConnection != 0 && DB_GetProfile() != DB_ProfileSafe)
+        {
+            // WAL: closing would checkpoint and sync() on the calling path, keep the connection,
+            // DB_Checkpoint() runs from the idle timer instead, ttlDataBaseConnection = 0 forces the close
+            return;
+        }
+
+        DB_FinalizeWriteStatements();
+
         int ret = sqlite3_close(db);
         if (ret == SQLITE_OK)
         {
@@ -6039,6 +7521,8 @@ void DeRestPluginPrivate::deleteDeviceDb(const QString &uniqueId)
 
     {
         QString sql = QString("DELETE FROM devices WHERE mac = '%1'").arg(uniqueId);
+        DB_ReleaseSubDeviceItems(); // rows are deleted by cascade
+        dbZdpDescriptors.erase(extAddressFromUniqueId(uniqueId));
         rc = sqlite3_exec(db, sql.toUtf8().constData(), NULL, NULL, &errmsg);
 
         if (rc != SQLITE_OK)
@@ -6833,7 +8317,6 @@ bool DB_StoreSubDevice(const char *uniqueId)
 
 bool DB_StoreDeviceItem(int deviceId, const DB_ResourceItem2 &item)
 {
-    U_SStream ss;
     U_ASSERT(deviceId >= 0);
     U_ASSERT(item.name.size() > 0);
     U_ASSERT(item.valueSize != 0);
@@ -6855,47 +8338,20 @@ bool DB_StoreDeviceItem(int deviceId, const DB_ResourceItem2 &item)
         return false;
     }
 
-    // 1) update or insert
-
-    U_sstream_init(&ss, sqlBuf, sizeof(sqlBuf));
-
-    U_sstream_put_str(&ss, "INSERT INTO dev_resource_items (device_id,item,value,timestamp)"
-                           " VALUES (");
-    U_sstream_put_long(&ss, deviceId);
-    U_sstream_put_str(&ss, ",'");
-    U_sstream_put_str(&ss, item.name.c_str());
-    U_sstream_put_str(&ss, "','");
-    U_sstream_put_str(&ss, item.value);
-    U_sstream_put_str(&ss, "',");
-    U_sstream_put_longlong(&ss, item.timestampMs);
-    U_sstream_put_str(&ss, ")");
-
-    int rc = SQLITE_ERROR;
-
-    if (ss.status == U_SSTREAM_OK)
-    {
-        char *errmsg = nullptr;
+    // 1) queue update or insert, executed by the next saveDb()
 
-        rc = sqlite3_exec(db, sqlBuf, nullptr, nullptr, &errmsg);
+    DB_WriteOp op;
+    op.type = DB_WriteDeviceItem;
+    op.id = deviceId;
+    op.item = item.name.c_str();
+    op.value.assign(item.value, item.valueSize);
+    op.timestamp = item.timestampMs;
 
-        if (rc != SQLITE_OK)
-        {
-            if (errmsg)
-            {
-                DBG_Printf(DBG_ERROR_L2, "SQL exec failed: %s, error: %s (%d)\n", sqlBuf, errmsg, rc);
-                sqlite3_free(errmsg);
-            }
-        }
-    }
+    const bool ret = DB_QueueWrite(std::move(op));
 
     DeRestPluginPrivate::instance()->closeDb();
 
-    if (rc == SQLITE_OK)
-    {
-        return true;
-    }
-
-    return false;
+    return ret;
 }
 
 bool DB_ResourceItem2DbItem(const ResourceItem *rItem, DB_ResourceItem2 *dbItem)
@@ -6963,6 +8419,7 @@ bool DB_LoadDeviceItems(int deviceId, std::vector<DB_ResourceItem2> &items)
     }
 
     DeRestPluginPrivate::instance()->openDb();
+    DB_FlushWriteQueue(); // pending writes must be visible
     if (!db)
     {
         return false;
@@ -7089,6 +8546,7 @@ std::vector<DB_IdentifierPair> DB_LoadIdentifierPairs()
             " WHERE RI.item = 'attr/modelid' and RI2.item = 'attr/manufacturername'";
 
     DeRestPluginPrivate::instance()->openDb();
+    DB_FlushWriteQueue(); // pending writes must be visible
     if (!db)
     {
         return result;
@@ -7222,7 +8680,25 @@ bool DB_StoreSubDeviceItem(const Resource *sub, ResourceItem *item)
     SelectDeviceItemData dbResult;
     dbResult.isValid = false;
     const uint64_t timestamp = item->lastChanged().toMSecsSinceEpoch() / 1000;
-    const auto value = dbEscapeString(item->toVariant().toString()).toUtf8();
+
+    DB_WriteOp op;
+    op.type = DB_WriteResourceItem;
+    op.text = uniqueId->toCString();
+    op.item = item->descriptor().suffix;
+    op.value = item->toVariant().toString().toStdString();
+    op.timestamp = int64_t(timestamp);
+
+    if (DB_IsWriteQueued(op))
+    {
+        // the pending write was already checked, just replace its value
+        const bool queued = DB_QueueWrite(std::move(op));
+        if (queued)
+        {
+            item->clearNeedStore();
+        }
+        DeRestPluginPrivate::instance()->closeDb();
+        return queued;
+    }
 
     // 1) check insert or update needed
 
@@ -7251,9 +8727,9 @@ bool DB_StoreSubDeviceItem(const Resource *sub, ResourceItem *item)
         if (dbResult.isValid)
         {
             bool isEqual = false;
-            if (dbResult.valueLength == (unsigned)value.size())
+            if (dbResult.valueLength == op.value.size())
             {
-                if (memcmp(value.constData(), &dbResult.value[0], dbResult.valueLength) == 0)
+                if (memcmp(op.value.data(), &dbResult.value[0], dbResult.valueLength) == 0)
                 {
                     isEqual = true;
                 }
@@ -7308,43 +8784,18 @@ bool DB_StoreSubDeviceItem(const Resource *sub, ResourceItem *item)
         }
     }
 
-    // 2) update or insert
-
-    ret = snprintf(sqlBuf, sizeof(sqlBuf),
-                       "INSERT INTO resource_items (sub_device_id,item,value,source,timestamp)"
-                       " SELECT id, '%s', '%s', 'dev', %" PRIu64
-                       " FROM sub_devices WHERE uniqueid = '%s'",
-                       item->descriptor().suffix,
-                       value.constData(),
-                       timestamp, uniqueId->toCString());
-
-    DBG_Assert(size_t(ret) < sizeof(sqlBuf));
-    if (size_t(ret) < sizeof(sqlBuf))
-    {
-//        DBG_Printf(DBG_INFO_L2, "%s\n", &sqlBuf[0]);
-
-        DBG_Printf(DBG_DEV, "DB store %s%s/%s ## %s\n", uniqueId->toCString(), sub->prefix(), item->descriptor().suffix, sqlBuf);
+    // 2) queue update or insert, executed by the next saveDb()
 
-        char *errmsg = nullptr;
-
-        int rc = sqlite3_exec(db, sqlBuf, nullptr, nullptr, &errmsg);
+    DBG_Printf(DBG_DEV, "DB store %s%s/%s ## %s\n", uniqueId->toCString(), sub->prefix(), item->descriptor().suffix, op.value.c_str());
 
-        if (rc != SQLITE_OK)
-        {
-            if (errmsg)
-            {
-                DBG_Printf(DBG_ERROR_L2, "SQL exec failed: %s, error: %s (%d)\n", sqlBuf, errmsg, rc);
-                sqlite3_free(errmsg);
-            }
-        }
-        else
-        {
-            item->clearNeedStore();
-        }
+    const bool queued = DB_QueueWrite(std::move(op));
+    if (queued)
+    {
+        item->clearNeedStore();
     }
 
     DeRestPluginPrivate::instance()->closeDb();
-    return true;
+    return queued;
 }
 
 static int DB_LoadSubDeviceItemsCallback(void *user, int ncols, char **colval , char **)
@@ -7366,6 +8817,86 @@ static int DB_LoadSubDeviceItemsCallback(void *user, int ncols, char **colval ,
     return 0;
 };
 
+static int DB_PreloadSubDeviceItemsCallback(void *user, int ncols, char **colval , char **)
+{
+    Q_UNUSED(user);
+    Q_ASSERT(ncols == 4);
+
+    if (!colval[0])
+    {
+        return 0;
+    }
+
+    const std::string uniqueId(colval[0]);
+    auto &items = dbSubItems[uniqueId];
+
+    // the LIKE query in DB_LoadSubDeviceItemsOfDevice() selects the first sub-device
+    if (uniqueId.size() >= 23)
+    {
+        dbSubItemsDevice.emplace(uniqueId.substr(0, 23), uniqueId);
+    }
+
+    if (colval[1] && colval[2])
+    {
+        DB_LoadSubDeviceItemsCallback(&items, 3, &colval[1], nullptr);
+    }
+
+    return 0;
+}
+
+/*! Loads the items of all sub-devices in one query, lookups within DB_SUB_ITEMS_CACHE_TTL
+    are served from memory. Sub-devices created later aren't preloaded and use the regular queries.
+    \returns true if the preloaded items can be used
+ */
+static bool DB_PreloadSubDeviceItems()
+{
+    if (dbSubItemsPreloaded)
+    {
+        if (!dbSubItems.empty() && dbSubItemsAge.elapsed() > DB_SUB_ITEMS_CACHE_TTL)
+        {
+            DB_ReleaseSubDeviceItems();
+        }
+        return !dbSubItems.empty();
+    }
+
+    DeRestPluginPrivate::instance()->openDb();
+    DB_FlushWriteQueue(); // pending writes must be visible
+
+    if (!db)
+    {
+        return false;
+    }
+
+    dbSubItemsPreloaded = true;
+    dbSubItemsAge.start();
+
+    const char *sql = "SELECT sub_devices.uniqueid, item, value, resource_items.timestamp FROM sub_devices"
+                      " LEFT JOIN resource_items ON resource_items.sub_device_id = sub_devices.id"
+                      " ORDER BY sub_devices.id";
+
+    char *errmsg = nullptr;
+    int rc = sqlite3_exec(db, sql, DB_PreloadSubDeviceItemsCallback, nullptr, &errmsg);
+
+    if (errmsg)
+    {
+        DBG_Printf(DBG_ERROR_L2, "SQL exec failed: %s, error: %s (%d)\n", sql, errmsg, rc);
+        sqlite3_free(errmsg);
+    }
+
+    if (rc != SQLITE_OK)
+    {
+        DB_ReleaseSubDeviceItems();
+    }
+    else
+    {
+        DBG_Printf(DBG_INFO, "DB preloaded items of %d sub-devices in %d ms\n", int(dbSubItems.size()), int(dbSubItemsAge.elapsed()));
+    }
+
+    DeRestPluginPrivate::instance()->closeDb();
+
+    return !dbSubItems.empty();
+}
+
 std::vector<DB_ResourceItem> DB_LoadSubDeviceItemsOfDevice(QLatin1String deviceUniqueId)
 {
     DBG_Assert(deviceUniqueId.size() == 23); // 64 bit uniqueId with : after each byte
@@ -7377,7 +8908,21 @@ std::vector<DB_ResourceItem> DB_LoadSubDeviceItemsOfDevice(QLatin1String deviceU
         return result;
     }
 
+    if (DB_PreloadSubDeviceItems())
+    {
+        const auto i = dbSubItemsDevice.find(std::string(deviceUniqueId.data(), size_t(deviceUniqueId.size())));
+        if (i != dbSubItemsDevice.end())
+        {
+            const auto sub = dbSubItems.find(i->second);
+            if (sub != dbSubItems.end())
+            {
+                return sub->second;
+            }
+        }
+    }
+
     DeRestPluginPrivate::instance()->openDb();
+    DB_FlushWriteQueue(); // pending writes must be visible
 
     if (!db)
     {
@@ -7415,6 +8960,8 @@ int DB_GetSubDeviceItemCount(QLatin1String uniqueId)
         return result;
     }
 
+    DB_FlushWriteQueue(); // pending writes must be visible
+
     int rc = snprintf(sqlBuf, sizeof(sqlBuf), "SELECT COUNT(item) FROM resource_items"
                                          " WHERE sub_device_id = (SELECT id FROM sub_devices WHERE uniqueid = '%s')",
                                          uniqueId.data());
@@ -7459,7 +9006,17 @@ std::vector<DB_ResourceItem> DB_LoadSubDeviceItems(QLatin1String uniqueId)
         return result;
     }
 
+    if (DB_PreloadSubDeviceItems())
+    {
+        const auto i = dbSubItems.find(std::string(uniqueId.data(), size_t(uniqueId.size())));
+        if (i != dbSubItems.end())
+        {
+            return i->second;
+        }
+    }
+
     DeRestPluginPrivate::instance()->openDb();
+    DB_FlushWriteQueue(); // pending writes must be visible
 
     if (!db)
     {
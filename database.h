@@ -23,6 +23,7 @@
 
 namespace deCONZ {
     class Address;
+    class Node;
 }
 
 struct DB_Secret
@@ -138,6 +139,93 @@ std::vector<DB_ResourceItem> DB_LoadSubDeviceItems(QLatin1String uniqueId);
 bool DB_LoadLegacySensorValue(DB_LegacyItem *litem);
 std::vector<std::string> DB_LoadLegacySensorUniqueIds(QLatin1String deviceUniqueId, const char *type);
 bool DB_LoadLegacyLightValue(DB_LegacyItem *litem);
+int DB_RestoreZdpDescriptors(const deCONZ::Node *node);
+
+/*! Parameters of a ZCL value history query. */
+struct DB_HistoryQuery
+{
+    int64_t fromTime = 0; // exclusive, with bucket the whole bucket containing it, seconds since Epoch
+    int64_t toTime = INT64_MAX; // inclusive, seconds since Epoch
+    int64_t bucket = 0; // aggregation interval in seconds, 0 for raw samples
+    int max = 0; // max. entries per item
+};
+
+class RestNodeBase;
+void DB_MarkNodeDirty(const RestNodeBase *node);
+void DB_SetFullSaveNeeded();
+
+/*! Durability profiles selected by the 'dbprofile' config parameter.
+
+    safe:       rollback journal and synchronous=FULL (SQLite defaults)
+    balanced:   WAL, synchronous=NORMAL, temp store in memory, checkpoints when idle
+    throughput: as balanced but synchronous=OFF and a larger page cache
+ */
+enum DB_Profile
+{
+    DB_ProfileSafe,
+    DB_ProfileBalanced,
+    DB_ProfileThroughput
+};
+
+/*! Latency of saveDb() transactions. */
+struct DB_CommitStats
+{
+    uint32_t commits = 0;
+    uint32_t failed = 0;
+    int64_t commitTotalMs = 0; // COMMIT statement only
+    int64_t commitMaxMs = 0;
+    int64_t saveTotalMs = 0; // whole transaction
+    int64_t saveMaxMs = 0;
+};
+
+bool DB_SetProfile(QLatin1String name);
+DB_Profile DB_GetProfile();
+const char *DB_ProfileName(DB_Profile profile);
+const DB_CommitStats &DB_GetCommitStats();
+void DB_Checkpoint();
+
+/*! Execution statistics of one kind of statement, e.g. "INSERT resource_items". */
+struct DB_StatementStats
+{
+    std::string op; // SELECT, INSERT, UPDATE, DELETE, PRAGMA, ...
+    std::string table; // main table, empty if not applicable
+    uint64_t count = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+    uint64_t rows = 0; // rows inserted, updated or deleted, including cascades
+};
+
+struct DB_TableStats
+{
+    std::string name;
+    int64_t rows = 0;
+    int64_t bytes = -1; // -1 if SQLite was built without the dbstat table
+};
+
+struct DB_SizeStats
+{
+    int64_t pageCount = 0;
+    int64_t pageSize = 0;
+    int64_t freePages = 0;
+    std::vector<DB_TableStats> tables;
+};
+
+void DB_EnableStatementStats();
+std::vector<DB_StatementStats> DB_GetStatementStats();
+bool DB_GetSizeStats(DB_SizeStats *stats);
+
+/*! A recorded phase of the startup, times in milliseconds since DB_StartupBegin(). */
+struct DB_StartupPhase
+{
+    const char *name;
+    int64_t startMs;
+    int64_t endMs;
+};
+
+void DB_StartupBegin();
+int64_t DB_StartupElapsed();
+int64_t DB_StartupRecord(const char *phase, int64_t startMs);
+const std::vector<DB_StartupPhase> &DB_StartupTimeline();
 
 
 #endif // DATABASE_H
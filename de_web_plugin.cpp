@@ -61,6 +61,7 @@
 #include "read_files.h"
 #include "tuya.h"
 #include "utils/utils.h"
+#include "utils/latency.h"
 #include "utils/scratchmem.h"
 #include "xiaomi.h"
 #include "zcl/zcl.h"
@@ -718,19 +719,27 @@ DeRestPluginPrivate::DeRestPluginPrivate(QObject *parent) :
     searchSensorsTimeout = 0;
 
     ttlDataBaseConnection = 0;
+    DB_StartupBegin();
+    int64_t startupTime = 0;
+    loadStartupSnapshot(); // before the database file is modified
+    startupTime = DB_StartupRecord("snapshot", startupTime);
     openDb();
     initDb();
+    startupTime = DB_StartupRecord("initdb", startupTime);
 
     deviceDescriptions->prepare();
     deviceDescriptions->readAll();
+    startupTime = DB_StartupRecord("ddf", startupTime);
 
     readDb();
+    startupTime = DB_StartupElapsed();
 
     DB_LoadAlarmSystemDevices(alarmSystemDeviceTable.get());
     DB_LoadAlarmSystems(*alarmSystems, alarmSystemDeviceTable.get(), eventEmitter);
     AS_InitDefaultAlarmSystem(*alarmSystems, alarmSystemDeviceTable.get(), eventEmitter);
 
     closeDb();
+    startupTime = DB_StartupRecord("alarmsystems", startupTime);
 
     initTimezone();
 
@@ -886,6 +895,7 @@ DeRestPluginPrivate::DeRestPluginPrivate(QObject *parent) :
     initChangeChannelApi();
     initResetDeviceApi();
     initFirmwareUpdate();
+    initApsReplay();
     //restoreWifiState();
     needRuleCheck = RULE_CHECK_DELAY;
 
@@ -893,7 +903,7 @@ DeRestPluginPrivate::DeRestPluginPrivate(QObject *parent) :
 
     connect(pollManager, &PollManager::done, this, &DeRestPluginPrivate::pollNextDevice);
 
-    auto *deviceTick = new DeviceTick(m_devices, this);
+    deviceTick = new DeviceTick(m_devices, this);
     connect(eventEmitter, &EventEmitter::eventNotify, deviceTick, &DeviceTick::handleEvent);
     connect(deviceTick, &DeviceTick::eventNotify, eventEmitter, &EventEmitter::enqueueEvent);
 
@@ -936,6 +946,8 @@ DeRestPluginPrivate::DeRestPluginPrivate(QObject *parent) :
             break; // only load once
         }
     }
+
+    DB_StartupRecord("ready", startupTime);
 }
 
 /*! Deconstructor for pimpl.
@@ -961,7 +973,142 @@ DeRestPluginPrivate *DeRestPluginPrivate::instance()
     return plugin;
 }
 
-void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndication &ind, Device *device)
+/*! Item changes of a resource collected while an indication is processed. */
+struct ResourceChangeSet
+{
+    Resource *r = nullptr;
+    ResourceItem *reachable = nullptr; //! set if the resource became reachable
+    std::vector<ResourceItem*> items; //! items set by parse functions, without duplicates
+};
+
+/*! Enqueues the item event of \p item, \p inChangeSet marks it as pushed by REventChanged. */
+static void enqueueChangeSetItemEvent(Device *device, Resource *r, const QString &id, ResourceItem *item, bool inChangeSet)
+{
+    Event e(r->prefix(), item->descriptor().suffix, id, item, device->key());
+    e.setInChangeSet(inChangeSet);
+    enqueueEvent(e);
+}
+
+/*! Commits the changes of one resource: reachable, the set items and one state/lastupdated
+    which is emitted after the state items. Non state items are queued for the database.
+
+    Sensors and lights get one REventChanged event after the item events, the websocket
+    notifications of all items which need a push are sent from it. The item events are still
+    handled by rules, the device state machine, the alarm system and the sensor side effects,
+    they are marked by Event::isInChangeSet() to skip the per item push.
+
+    \returns the number of set items which mark the device as awake
+ */
+static int commitResourceChangeSet(Device *device, const deCONZ::ApsDataIndication &ind, const ResourceChangeSet &changes)
+{
+    Resource *r = changes.r;
+    int awake = 0;
+
+    auto *idItem = r->item(RAttrId);
+    if (!idItem)
+    {
+        idItem = r->item(RAttrUniqueId);
+    }
+
+    if (!idItem)
+    {
+        return 0;
+    }
+
+    const QString &id = idItem->toString();
+    const bool inChangeSet = r->prefix() == RSensors || r->prefix() == RLights;
+
+    if (changes.reachable)
+    {
+        enqueueChangeSetItemEvent(device, r, id, changes.reachable, inChangeSet);
+    }
+
+    const ResourceItem *lastStateItem = nullptr;
+
+    for (ResourceItem *i : changes.items)
+    {
+        i->setNeedStore();
+        if (i->awake())
+        {
+            awake++;
+        }
+
+        const bool push = i->pushOnSet() || (i->pushOnChange() && i->lastChanged() == i->lastSet());
+        const char *itemSuffix = i->descriptor().suffix;
+
+        enqueueChangeSetItemEvent(device, r, id, i, inChangeSet);
+
+        if (itemSuffix[0] == 's' && itemSuffix != RStateLastUpdated) // state/*
+        {
+            if (!lastStateItem || lastStateItem->lastSet() < i->lastSet())
+            {
+                lastStateItem = i;
+            }
+        }
+
+        if (push && i->lastChanged() == i->lastSet())
+        {
+            if (itemSuffix[0] == 's') // state/*
+            {
+                // don't store state items within APS indication handler as this can block for >1 sec on slow systems
+            }
+            else if (r->prefix() != RDevices)
+            {
+                DBG_MEASURE_START(DB_StoreSubDeviceItem);
+                const int64_t dbStart = LAT_NowUs();
+                DB_StoreSubDeviceItem(r, i);
+                LAT_Record(LAT_StageDbQueue, dbStart);
+                DBG_MEASURE_END(DB_StoreSubDeviceItem);
+            }
+            else if (r->prefix() == RDevices && ind.clusterId() == BASIC_CLUSTER_ID)
+            {
+                if (itemSuffix == RAttrAppVersion)
+                {
+                    DB_ZclValue dbVal;
+                    dbVal.deviceId = device->deviceId();
+                    dbVal.endpoint = ind.srcEndpoint();
+                    dbVal.clusterId = ind.clusterId();
+                    dbVal.attrId = 0x0001;
+                    dbVal.data = i->toNumber();
+                    DB_StoreZclValue(&dbVal);
+                }
+            }
+            else if (r->prefix() == RDevices && ind.clusterId() == IAS_ZONE_CLUSTER_ID)
+            {
+                if (itemSuffix == RAttrZoneType)
+                {
+                    DB_ZclValue dbVal;
+                    dbVal.deviceId = device->deviceId();
+                    dbVal.endpoint = ind.srcEndpoint();
+                    dbVal.clusterId = ind.clusterId();
+                    dbVal.attrId = 0x0001;
+                    dbVal.data = i->toNumber();
+                    DB_StoreZclValue(&dbVal);
+                }
+            }
+        }
+    }
+
+    ResourceItem *lastUpdated = lastStateItem ? r->item(RStateLastUpdated) : nullptr;
+    if (lastUpdated)
+    {
+        lastUpdated->setValue(lastStateItem->lastSet());
+        enqueueChangeSetItemEvent(device, r, id, lastUpdated, inChangeSet);
+    }
+
+    if (inChangeSet && (changes.reachable || !changes.items.empty()))
+    {
+        // no data, a still queued REventChanged of the resource pushes the later items as well
+        enqueueEvent(Event(r->prefix(), REventChanged, id, device->key()));
+    }
+
+    return awake;
+}
+
+/*! APSDE-DATA.indication handler for Device based processing.
+    \param zclFrame - the already parsed ZCL frame for HA and ZLL profile indications
+ */
+void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndication &ind, const deCONZ::ZclFrame &zclFrame, Device *device)
 {
     if (!device)
     {
@@ -979,14 +1126,8 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
         }
     }
 
-    deCONZ::ZclFrame zclFrame;
-
     if (ind.profileId() == HA_PROFILE_ID || ind.profileId() == ZLL_PROFILE_ID)
     {
-        QDataStream stream(ind.asdu());
-        stream.setByteOrder(QDataStream::LittleEndian);
-        zclFrame.readFromStream(stream);
-
         if (!zclFrame.isProfileWideCommand())
         {
             if (zclFrame.frameControl() & deCONZ::ZclFCDirectionServerToClient)
@@ -999,9 +1140,14 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
         }
         else if (zclFrame.commandId() == deCONZ::ZclReadAttributesResponseId && zclFrame.payload().size() >= 3)
         {
+            DEV_ZclReadAttributesResponse(device, ind.clusterId(), zclFrame.sequenceNumber(), zclFrame.payload());
             const auto status = quint8(zclFrame.payload().at(2));
             enqueueEvent(Event(device->prefix(), REventZclResponse, EventZclResponsePack(ind.clusterId(), zclFrame.sequenceNumber(), status), device->key()));
         }
+        else if (zclFrame.commandId() == deCONZ::ZclReportAttributesId)
+        {
+            DEV_ZclReportAttributes(device, ind.srcEndpoint(), ind.clusterId(), zclFrame.payload());
+        }
         else if (zclFrame.commandId() == deCONZ::ZclConfigureReportingResponseId && zclFrame.payload().size() >= 1)
         {
             const auto status = quint8(zclFrame.payload().at(0));
@@ -1047,8 +1193,18 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
     auto resources = device->subDevices();
     resources.push_back(device); // self reference
 
-    for (auto &r : resources)
+    // only items which can match the cluster and endpoint
+    std::vector<DEV_DispatchItem> dispatchItems;
+    DEV_GetDispatchItems(device, resources, ind.clusterId(), ind.srcEndpoint(), &dispatchItems);
+    auto dispatchItem = dispatchItems.cbegin();
+
+    // changes of the resources are collected first and then committed once per resource
+    std::vector<ResourceChangeSet> changeSets;
+
+    for (size_t resourceIndex = 0; resourceIndex < resources.size(); resourceIndex++)
     {
+        Resource *r = resources[resourceIndex];
+
         if (ind.clusterId() == BASIC_CLUSTER_ID && zclFrame.commandId() == deCONZ::ZclReadAttributesResponseId)
         { }
         else if (!device->managed())
@@ -1073,6 +1229,9 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
             continue;
         }
 
+        ResourceChangeSet changes;
+        changes.r = r;
+
         {   // TODO this is too messy
             ResourceItem *reachable = nullptr;
             if (r->prefix() == RLights)
@@ -1091,18 +1250,15 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
             if (reachable && !reachable->toBool())
             {
                 reachable->setValue(true);
-                enqueueEvent(Event(r->prefix(), reachable->descriptor().suffix, r->item(RAttrId)->toString(), reachable, device->key()));
+                changes.reachable = reachable;
             }
         }
 
-        // for state/* changes, only emit the state/lastupdated event once for the first state/* item.
-        bool eventLastUpdatedEmitted = false;
-
         DeviceJs::instance()->clearItemsSet();
 
-        for (int i = 0; i < r->itemCount(); i++)
+        for (; dispatchItem != dispatchItems.cend() && dispatchItem->resource == resourceIndex; ++dispatchItem)
         {
-            ResourceItem *item = r->itemForIndex(i);
+            ResourceItem *item = r->itemForIndex(dispatchItem->item);
             DBG_Assert(item);
             if (!item)
             {
@@ -1112,20 +1268,15 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
             ParseFunction_t parseFunction = item->parseFunction();
             const auto &ddfItem = DDF_GetItem(item);
 
-            // First call
-            // Init the parse function. Later on this needs to be done by the device description loader.
+            // First call, the parse function was decoded by the device description loader.
             if (!parseFunction && ddfItem.isValid())
             {
-                parseFunction = DA_GetParseFunction(ddfItem.parseParameters);
+                parseFunction = ddfItem.params.parseFunction;
             }
 
             if (!parseFunction)
             {
-                if (!ddfItem.parseParameters.isNull())
-                {
-                    DBG_Printf(DBG_INFO, "parse function for %s not found: %s\n", item->descriptor().suffix, qPrintable(ddfItem.parseParameters.toString()));
-                }
-                continue;
+                continue; // logged when the dispatch index was built
             }
 
             if (parseFunction(r, item, ind, zclFrame, ddfItem.parseParameters))
@@ -1133,80 +1284,20 @@ void DeRestPluginPrivate::apsdeDataIndicationDevice(const deCONZ::ApsDataIndicat
             }
         }
 
-        auto *idItem = r->item(RAttrId);
-        if (!idItem)
-        {
-            idItem = r->item(RAttrUniqueId);
-        }
+        changes.items = DeviceJs::instance()->itemsSet();
 
-        if (idItem)
+        if (changes.reachable || !changes.items.empty())
         {
-            for (ResourceItem *i : DeviceJs::instance()->itemsSet())
-            {
-                i->setNeedStore();
-                if (i->awake())
-                {
-                    awake++;
-                }
-
-                const bool push = i->pushOnSet() || (i->pushOnChange() && i->lastChanged() == i->lastSet());
-
-                enqueueEvent(Event(r->prefix(), i->descriptor().suffix, idItem->toString(), i, device->key()));
-                if (push && i->lastChanged() == i->lastSet())
-                {
-                    const char *itemSuffix = i->descriptor().suffix;
-                    if (itemSuffix[0] == 's') // state/*
-                    {
-                        // don't store state items within APS indication handler as this can block for >1 sec on slow systems
-                    }
-                    else if (r->prefix() != RDevices)
-                    {
-                        DBG_MEASURE_START(DB_StoreSubDeviceItem);
-                        DB_StoreSubDeviceItem(r, i);
-                        DBG_MEASURE_END(DB_StoreSubDeviceItem);
-                    }
-                    else if (r->prefix() == RDevices && ind.clusterId() == BASIC_CLUSTER_ID)
-                    {
-                        if (itemSuffix == RAttrAppVersion)
-                        {
-                            DB_ZclValue dbVal;
-                            dbVal.deviceId = device->deviceId();
-                            dbVal.endpoint = ind.srcEndpoint();
-                            dbVal.clusterId = ind.clusterId();
-                            dbVal.attrId = 0x0001;
-                            dbVal.data = i->toNumber();
-                            DB_StoreZclValue(&dbVal);
-                        }
-                    }
-                    else if (r->prefix() == RDevices && ind.clusterId() == IAS_ZONE_CLUSTER_ID)
-                    {
-                        if (itemSuffix == RAttrZoneType)
-                        {
-                            DB_ZclValue dbVal;
-                            dbVal.deviceId = device->deviceId();
-                            dbVal.endpoint = ind.srcEndpoint();
-                            dbVal.clusterId = ind.clusterId();
-                            dbVal.attrId = 0x0001;
-                            dbVal.data = i->toNumber();
-                            DB_StoreZclValue(&dbVal);
-                        }
-                    }
-                }
-
-                if (!eventLastUpdatedEmitted && i->descriptor().suffix[0] == 's') // state/*
-                {
-                    ResourceItem *lastUpdated = r->item(RStateLastUpdated);
-                    if (lastUpdated)
-                    {
-                        eventLastUpdatedEmitted = true;
-                        lastUpdated->setValue(i->lastSet());
-                        enqueueEvent(Event(r->prefix(), lastUpdated->descriptor().suffix, idItem->toString(), lastUpdated, device->key()));
-                    }
-                }
-            }
+            changeSets.push_back(std::move(changes));
         }
     }
 
+    // commit after all items of the indication are parsed
+    for (const ResourceChangeSet &changes : changeSets)
+    {
+        awake += commitResourceChangeSet(device, ind, changes);
+    }
+
     if (ind.profileId() == ZDP_PROFILE_ID)
     {
 
@@ -1244,18 +1335,42 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
         rStats = { };
     }
 
+    readDeferredDb(); // rules and scenes must be known
+
+    if (apsCaptureFile)
+    {
+        apsCaptureIndication(ind);
+    }
+
+    // latency of the stages below, see GET /config/metrics/indications
+    LAT_SetCluster(ind.clusterId());
+    int64_t stageStart = LAT_NowUs();
+
     auto *device = DEV_GetDevice(m_devices, ind.srcAddress().ext());
+    LAT_Record(LAT_StageDeviceLookup, stageStart);
 
-    apsdeDataIndicationDevice(ind, device);
+    if ((ind.profileId() == HA_PROFILE_ID) || (ind.profileId() == ZLL_PROFILE_ID))
+    {
+        // parsed once for all handlers
+        stageStart = LAT_NowUs();
+        QDataStream stream(ind.asdu());
+        stream.setByteOrder(QDataStream::LittleEndian);
+        zclFrame.readFromStream(stream);
+        LAT_Record(LAT_StageZclDecode, stageStart);
+    }
+
+    stageStart = LAT_NowUs();
+    apsdeDataIndicationDevice(ind, zclFrame, device);
+    LAT_Record(LAT_StageDdfParse, stageStart);
+
+    stageStart = LAT_NowUs();
 
     if ((ind.profileId() == HA_PROFILE_ID) || (ind.profileId() == ZLL_PROFILE_ID))
     {
         const bool devManaged = device && device->managed();
-        {
-            QDataStream stream(ind.asdu());
-            stream.setByteOrder(QDataStream::LittleEndian);
-            zclFrame.readFromStream(stream);
-        }
+        // attribute reports and read responses of clusters parsed by DDF items skip
+        // the legacy handlers which only update resources, cluster commands still pass
+        const bool ddfParsed = devManaged && zclFrame.isProfileWideCommand() && DEV_ParsesCluster(device, ind.clusterId(), ind.srcEndpoint());
 
         switch (ind.clusterId())
         {
@@ -1332,7 +1447,7 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
             break;
 
         case THERMOSTAT_CLUSTER_ID:
-            if (!DEV_TestStrict()) { handleThermostatClusterIndication(ind, zclFrame); }
+            if (!DEV_TestStrict() && !ddfParsed) { handleThermostatClusterIndication(ind, zclFrame); }
             break;
 
         case BASIC_CLUSTER_ID:
@@ -1352,7 +1467,7 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
             break;
 
         case BOSCH_AIR_QUALITY_CLUSTER_ID: // Bosch Air quality sensor
-            if (!DEV_TestStrict()) { handleAirQualityClusterIndication(ind, zclFrame); }
+            if (!DEV_TestStrict() && !ddfParsed) { handleAirQualityClusterIndication(ind, zclFrame); }
             break;
 
         case POLL_CONTROL_CLUSTER_ID:
@@ -1360,7 +1475,7 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
             break;
 
         case FAN_CONTROL_CLUSTER_ID:
-            handleFanControlClusterIndication(ind, zclFrame);
+            if (!ddfParsed) { handleFanControlClusterIndication(ind, zclFrame); }
             break;
 
         case DOOR_LOCK_CLUSTER_ID:
@@ -1368,11 +1483,11 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
             break;
 
         case XIAOMI_CLUSTER_ID:
-            if (!DEV_TestStrict()) { handleXiaomiLumiClusterIndication(ind, zclFrame); }
+            if (!DEV_TestStrict() && !ddfParsed) { handleXiaomiLumiClusterIndication(ind, zclFrame); }
             break;
 
         case OCCUPANCY_SENSING_CLUSTER_ID:
-            if (!DEV_TestStrict()) { handleOccupancySensingClusterIndication(ind, zclFrame); }
+            if (!DEV_TestStrict() && !ddfParsed) { handleOccupancySensingClusterIndication(ind, zclFrame); }
             break;
 
         default:
@@ -1381,32 +1496,44 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
             break;
         }
 
-        handleIndicationSearchSensors(ind, zclFrame);
+        if (!devManaged)
+        {
+            handleIndicationSearchSensors(ind, zclFrame);
+        }
 
         if (ind.dstAddressMode() == deCONZ::ApsGroupAddress || ind.clusterId() == VENDOR_CLUSTER_ID || ind.clusterId() == IAS_ZONE_CLUSTER_ID || zclFrame.manufacturerCode() == VENDOR_XIAOYAN ||
             !(zclFrame.frameControl() & deCONZ::ZclFCDirectionServerToClient) ||
             (zclFrame.isProfileWideCommand() && zclFrame.commandId() == deCONZ::ZclReportAttributesId))
         {
             Sensor *sensorNode = nullptr;
-            quint8 count = 0;
 
-            for (Sensor &sensor: sensors)
+            if (devManaged)
             {
-                if (sensor.deletedState() != Sensor::StateNormal || !sensor.node())                             { continue; }
-                if (!isSameAddress(sensor.address(), ind.srcAddress()))                                         { continue; }
-                if (sensor.type() != QLatin1String("ZHASwitch"))                                                { continue; }
-
-                sensorNode = &sensor;
-                count++;
-            }
-
-            if (count == 1)
-            {
-                // Only 1 switch resource for the indication address found
+                // the sub-devices are the sensors of the address, no need to scan all sensors
+                sensorNode = getButtonSensorForDevice(device, ind.srcEndpoint());
             }
             else
             {
-                sensorNode = getSensorNodeForAddressAndEndpoint(ind.srcAddress(), ind.srcEndpoint());
+                quint8 count = 0;
+
+                for (Sensor &sensor: sensors)
+                {
+                    if (sensor.deletedState() != Sensor::StateNormal || !sensor.node())                             { continue; }
+                    if (!isSameAddress(sensor.address(), ind.srcAddress()))                                         { continue; }
+                    if (sensor.type() != QLatin1String("ZHASwitch"))                                                { continue; }
+
+                    sensorNode = &sensor;
+                    count++;
+                }
+
+                if (count == 1)
+                {
+                    // Only 1 switch resource for the indication address found
+                }
+                else
+                {
+                    sensorNode = getSensorNodeForAddressAndEndpoint(ind.srcAddress(), ind.srcEndpoint());
+                }
             }
 
             if (sensorNode)
@@ -1418,7 +1545,14 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
         if (zclFrame.isProfileWideCommand() && zclFrame.commandId() == deCONZ::ZclReportAttributesId)
         {
             zbConfigGood = QDateTime::currentDateTime();
-            handleZclAttributeReportIndication(ind, zclFrame);
+            if (!devManaged)
+            {
+                handleZclAttributeReportIndication(ind, zclFrame);
+            }
+            else if (ind.clusterId() == BASIC_CLUSTER_ID && existDevicesWithVendorCodeForMacPrefix(ind.srcAddress().ext(), VENDOR_XIAOMI))
+            {
+                handleZclAttributeReportIndicationXiaomiSpecial(ind, zclFrame); // only marks the device awake
+            }
         }
         else if (zclFrame.isProfileWideCommand() && zclFrame.commandId() == deCONZ::ZclReadAttributesResponseId)
         {
@@ -1517,7 +1651,12 @@ void DeRestPluginPrivate::apsdeDataIndication(const deCONZ::ApsDataIndication &i
         }
     }
 
+    LAT_Record(LAT_StageLegacyHandler, stageStart);
+
+    stageStart = LAT_NowUs();
     eventEmitter->process();
+    LAT_Record(LAT_StageEventProcess, stageStart);
+    LAT_SetCluster(LAT_NO_CLUSTER);
 }
 
 /*! APSDE-DATA.confirm callback.
@@ -1626,7 +1765,7 @@ void DeRestPluginPrivate::gpProcessButtonEvent(const deCONZ::GpDataIndication &i
 
      */
 
-    Sensor *sensor = getSensorNodeForAddress(ind.gpdSrcId());
+    Sensor *sensor = getSensorNodeForGpdSrcId(ind.gpdSrcId());
     ResourceItem *item = sensor ? sensor->item(RStateButtonEvent) : nullptr;
 
     if (!sensor || !item || sensor->deletedState() == Sensor::StateDeleted)
@@ -5429,6 +5568,11 @@ void DeRestPluginPrivate::addSensorNode(const deCONZ::Node *node, const deCONZ::
         return;
     }
 
+    if (node->nodeDescriptor().isNull() || node->simpleDescriptors().size() < node->endpoints().size())
+    {
+        DB_RestoreZdpDescriptors(node); // avoid querying descriptors known from a previous run
+    }
+
     { // check existing sensors
         std::vector<Sensor>::iterator i = sensors.begin();
         std::vector<Sensor>::iterator end = sensors.end();
@@ -9405,6 +9549,43 @@ Sensor *DeRestPluginPrivate::getSensorNodeForAddress(quint64 extAddr)
 
 }
 
+/*! Returns the same Sensor as getSensorNodeForAddress(gpdSrcId) via the GPD source id index.
+
+    Sensors are never removed from the vector, so a cached result stays valid until sensors
+    are added. Only non deleted sensors are cached, a deleted one is looked up again each time.
+    Misses aren't cached, otherwise every foreign source id in range would add an entry.
+ */
+Sensor *DeRestPluginPrivate::getSensorNodeForGpdSrcId(quint32 gpdSrcId)
+{
+    auto i = gpSourceIndex.find(gpdSrcId);
+
+    if (i != gpSourceIndex.end() && i->second.sensorCount == sensors.size())
+    {
+        Sensor *sensor = &sensors[i->second.sensorIndex];
+        if (sensor->address().ext() == gpdSrcId && sensor->deletedState() != Sensor::StateDeleted)
+        {
+            return sensor;
+        }
+    }
+
+    Sensor *sensor = getSensorNodeForAddress(quint64(gpdSrcId));
+
+    if (!sensor || sensor->deletedState() == Sensor::StateDeleted)
+    {
+        if (i != gpSourceIndex.end())
+        {
+            gpSourceIndex.erase(i);
+        }
+        return sensor;
+    }
+
+    GP_SourceEntry &entry = gpSourceIndex[gpdSrcId];
+    entry.sensorCount = sensors.size();
+    entry.sensorIndex = size_t(sensor - sensors.data());
+
+    return sensor;
+}
+
 /*! Returns the first Sensor for its given \p addr or 0 if not found.
     \note There might be more sensors with the same address.
  */
@@ -9452,6 +9633,55 @@ Sensor *DeRestPluginPrivate::getSensorNodeForAddressAndEndpoint(const deCONZ::Ad
     return nullptr;
 }
 
+/*! Returns the sensor of a managed \p device which handles button events via the button maps.
+
+    Same selection as for unmanaged devices: the only ZHASwitch or else the first sensor
+    of endpoint \p ep. Returns nullptr if there is none or it has no button map, in which
+    case checkSensorButtonEvent() wouldn't do anything.
+ */
+Sensor *DeRestPluginPrivate::getButtonSensorForDevice(Device *device, quint8 ep)
+{
+    Sensor *switchSensor = nullptr;
+    Sensor *endpointSensor = nullptr;
+    int count = 0;
+
+    for (Resource *r : device->subDevices())
+    {
+        if (r->prefix() != RSensors)
+        {
+            continue;
+        }
+
+        Sensor *sensor = static_cast<Sensor*>(r);
+        if (sensor->deletedState() != Sensor::StateNormal || !sensor->node()) { continue; }
+
+        if (sensor->type() == QLatin1String("ZHASwitch"))
+        {
+            switchSensor = sensor;
+            count++;
+        }
+
+        if (!endpointSensor && sensor->fingerPrint().endpoint == ep)
+        {
+            endpointSensor = sensor;
+        }
+    }
+
+    Sensor *sensor = count == 1 ? switchSensor : endpointSensor;
+
+    if (!sensor)
+    {
+        return nullptr;
+    }
+
+    if (!isValid(sensor->buttonMapRef()) && !BM_ButtonMapForProduct(productHash(sensor), buttonMaps, buttonProductMap))
+    {
+        return nullptr;
+    }
+
+    return sensor;
+}
+
 /*! Returns the first Sensor for its given \p Address and \p Endpoint and \p Cluster or nullptr if not found.
  */
 Sensor *DeRestPluginPrivate::getSensorNodeForAddressEndpointAndCluster(const deCONZ::Address &addr, quint8 ep, quint16 cluster)
@@ -11534,6 +11764,32 @@ bool DeRestPluginPrivate::addTask(const TaskItem &task)
     return false;
 }
 
+/*! Returns true if the task carries a user initiated command rather than background maintenance. */
+static bool isUserTask(const TaskItem &task)
+{
+    switch (task.taskType)
+    {
+    case TaskGetHue:
+    case TaskGetColor:
+    case TaskGetSat:
+    case TaskGetLevel:
+    case TaskGetOnOff:
+    case TaskGetColorLoop:
+    case TaskReadAttributes:
+    case TaskGetGroupMembership:
+    case TaskGetGroupIdentifiers:
+    case TaskGetSceneMembership:
+    case TaskViewScene:
+    case TaskViewGroup:
+    case TaskSyncTime:
+        return false;
+    default:
+        break;
+    }
+
+    return true;
+}
+
 /*! Fires the next APS-DATA.request.
  */
 void DeRestPluginPrivate::processTasks()
@@ -11654,7 +11910,20 @@ void DeRestPluginPrivate::processTasks()
             }
         }
 
-        if (!ok) // destination already busy
+        const DA_ApsPriority priority = isUserTask(*i) ? DA_ApsPriorityUser : DA_ApsPriorityNormal;
+        const uint64_t extAddr = i->req.dstAddressMode() != deCONZ::ApsGroupAddress && i->req.dstAddress().hasExt() ? i->req.dstAddress().ext() : 0;
+
+        if (ok)
+        {
+            ok = DA_ApsCanAdmit(extAddr, priority);
+
+            if (!ok && priority == DA_ApsPriorityUser)
+            {
+                DA_ApsUserRequestPending(extAddr); // hold off polling and binding traffic
+            }
+        }
+
+        if (!ok) // destination or APS queue busy
         {
         }
         else
@@ -11673,8 +11942,10 @@ void DeRestPluginPrivate::processTasks()
                     if (!group->sendTime.isValid() || (diff <= 0) || (diff > gwGroupSendDelay))
                     {
                         i->sendTime = idleTotalCounter;
+                        const uint32_t mark = DA_ApsEnqueueMark();
                         if (apsCtrlWrapper.apsdeDataRequest(i->req) == deCONZ::Success)
                         {
+                            DA_ApsAdmitted(extAddr, mark, priority);
                             group->sendTime = now;
                             if (pushRunning)
                             {
@@ -11709,10 +11980,12 @@ void DeRestPluginPrivate::processTasks()
                 {
 
                     i->sendTime = idleTotalCounter;
+                    const uint32_t mark = DA_ApsEnqueueMark();
                     int ret = apsCtrlWrapper.apsdeDataRequest(i->req);
 
                     if (ret == deCONZ::Success)
                     {
+                        DA_ApsAdmitted(extAddr, mark, priority);
                         if (pushRunning)
                         {
                             runningTasks.push_back(*i);
@@ -12031,7 +12304,7 @@ void DeRestPluginPrivate::processGroupTasks()
         return;
     }
 
-    if (DA_ApsUnconfirmedRequests() > 3)
+    if (!DA_ApsCanAdmit(0, DA_ApsPriorityBackground))
     {
         return;
     }
@@ -14964,6 +15237,8 @@ void DeRestPlugin::idleTimerFired()
         d->idleLimit--;
     }
 
+    d->readDeferredDb(); // no-op once a request or indication needed it earlier
+
     ResourceItem *localTime = d->config.item(RConfigLocalTime);
     if (localTime)
     {
@@ -14980,6 +15255,11 @@ void DeRestPlugin::idleTimerFired()
         }
     }
 
+    if ((d->idleTotalCounter % DB_CHECKPOINT_INTERVAL) == 0)
+    {
+        DB_Checkpoint(); // keep the WAL small, no-op in "safe" profile
+    }
+
     if (d->idleLastActivity < IDLE_USER_LIMIT)
     {
         return;
@@ -15571,8 +15851,8 @@ void DeRestPlugin::appAboutToQuit()
     if (d)
     {
         d->saveDatabaseItems |= (DB_SENSORS | DB_RULES | DB_LIGHTS);
+        DB_SetFullSaveNeeded();
         d->openDb();
-        d->saveDb();
 
 #if 1
         for (auto &dev : d->m_devices)
@@ -15587,8 +15867,11 @@ void DeRestPlugin::appAboutToQuit()
         }
 #endif
 
+        d->saveDb(); // also executes the queued item writes
+
         d->ttlDataBaseConnection = 0;
         d->closeDb();
+        d->writeStartupSnapshot();
 
         d->apsCtrl = nullptr;
         d->apsCtrlWrapper = {nullptr};
@@ -15876,6 +16159,8 @@ int DeRestPlugin::handleHttpRequest(const QHttpRequestHeader &hdr, QTcpSocket *s
 
         if (hdr.pathComponentsCount() >= 2 && (req.auth == ApiAuthFull || req.auth == ApiAuthInternal))
         {
+            d->readDeferredDb();
+
             // GET /api/<apikey>
             if (hdr.pathComponentsCount() == 2 && req.hdr.httpMethod() == HttpGet)
             {
@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <deque>
 #include <memory>
+#include <unordered_map>
 #include <sqlite3.h>
 #include <deconz.h>
 #include "device.h"
@@ -57,6 +58,7 @@ using namespace deCONZ::literals;
 #define BUTTON_ATTR_REPORT_BIND_LIMIT 120
 #define WARMUP_TIME 120
 #define RULE_CHECK_DELAY 4 // seconds
+#define DB_CHECKPOINT_INTERVAL 60 // seconds
 
 #define MAX_UNLOCK_GATEWAY_TIME 600
 #define MAX_RECOVER_ENTRY_AGE 600
@@ -427,6 +429,7 @@ using namespace deCONZ::literals;
 #define DB_QUERY_QUEUE    0x00000800
 #define DB_SYNC           0x00001000
 #define DB_NOSAVE         0x00002000
+#define DB_TIMESERIES     0x00004000
 
 #define DB_HUGE_SAVE_DELAY  (60 * 60 * 1000) // 60 minutes
 #define DB_LONG_SAVE_DELAY  (15 * 60 * 1000) // 15 minutes
@@ -665,6 +668,7 @@ const deCONZ::Node *getCoreNode(uint64_t extAddress);
 
 // Forward declarations
 class DeviceDescriptions;
+class DeviceTick;
 class DeviceWidget;
 class DeviceJs;
 #ifdef USE_GATEWAY_API
@@ -678,8 +682,10 @@ class QHostInfo;
 class QNetworkReply;
 class QNetworkAccessManager;
 class QProcess;
+class QFile;
 class PollManager;
 class RestDevices;
+struct DB_HistoryQuery;
 
 struct Schedule
 {
@@ -987,6 +993,9 @@ public:
     int getConfig(const ApiRequest &req, ApiResponse &rsp);
     int getBasicConfig(const ApiRequest &req, ApiResponse &rsp);
     int getZigbeeConfig(const ApiRequest &req, ApiResponse &rsp);
+    int getMetrics(const ApiRequest &req, ApiResponse &rsp);
+    int getDatabaseMetrics(const ApiRequest &req, ApiResponse &rsp);
+    int getIndicationMetrics(const ApiRequest &req, ApiResponse &rsp);
     int putZigbeeConfig(const ApiRequest &req, ApiResponse &rsp);
     int getChallenge(const ApiRequest &req, ApiResponse &rsp);
     int modifyConfig(const ApiRequest &req, ApiResponse &rsp);
@@ -1038,6 +1047,7 @@ public:
     int removeAllScenes(const ApiRequest &req, ApiResponse &rsp);
     int removeAllGroups(const ApiRequest &req, ApiResponse &rsp);
     void handleLightEvent(const Event &e);
+    void notifyLightItemChange(LightNode *lightNode, ResourceItem *item);
 
     bool lightToMap(const ApiRequest &req, LightNode *webNode, QVariantMap &map, const char *event = nullptr);
 
@@ -1099,6 +1109,7 @@ public:
     int recoverSensor(const ApiRequest &req, ApiResponse &rsp);
     bool sensorToMap(Sensor *sensor, QVariantMap &map, const ApiRequest &req, const char *event = nullptr);
     void handleSensorEvent(const Event &e);
+    void notifySensorItemChange(Sensor *sensor, ResourceItem *item);
 
     // REST API resourcelinks
     int handleResourcelinksApi(const ApiRequest &req, ApiResponse &rsp);
@@ -1159,6 +1170,12 @@ public:
     //reset Device
     void initResetDeviceApi();
 
+    // APS capture and replay
+    void initApsReplay();
+    void apsCaptureIndication(const deCONZ::ApsDataIndication &ind);
+    void replayApsCapture();
+    void apsReplayDumpState(const QString &path);
+
     //Timezone
     QVariantList getTimezones();
 
@@ -1169,7 +1186,7 @@ public Q_SLOTS:
     Resource *getResource(const char *resource, const QString &id = QString());
     void announceUpnp();
     void upnpReadyRead();
-    void apsdeDataIndicationDevice(const deCONZ::ApsDataIndication &ind, Device *device);
+    void apsdeDataIndicationDevice(const deCONZ::ApsDataIndication &ind, const deCONZ::ZclFrame &zclFrame, Device *device);
     void apsdeDataIndication(const deCONZ::ApsDataIndication &ind);
     void apsdeDataConfirm(const deCONZ::ApsDataConfirm &conf);
     void apsdeDataRequestEnqueued(const deCONZ::ApsDataRequest &req);
@@ -1344,7 +1361,9 @@ public:
     Sensor *getSensorNodeForAddressEndpointAndCluster(const deCONZ::Address &addr, quint8 ep, quint16 cluster);
     Sensor *getSensorNodeForAddressAndEndpoint(const deCONZ::Address &addr, quint8 ep, const QString &type);
     Sensor *getSensorNodeForAddressAndEndpoint(const deCONZ::Address &addr, quint8 ep);
+    Sensor *getButtonSensorForDevice(Device *device, quint8 ep);
     Sensor *getSensorNodeForAddress(quint64 extAddr);
+    Sensor *getSensorNodeForGpdSrcId(quint32 gpdSrcId);
     Sensor *getSensorNodeForAddress(const deCONZ::Address &addr);
     Sensor *getSensorNodeForFingerPrint(quint64 extAddr, const SensorFingerprint &fingerPrint, const QString &type);
     Sensor *getSensorNodeForUniqueId(const QString &uniqueId);
@@ -1529,6 +1548,9 @@ public:
     bool dbIsOpen() const;
     void openDb();
     void readDb();
+    void readDeferredDb();
+    void loadStartupSnapshot();
+    void writeStartupSnapshot();
     void loadAuthFromDb();
     void loadConfigFromDb();
     void loadUserparameterFromDb();
@@ -1544,8 +1566,8 @@ public:
     void loadWifiInformationFromDb();
     void loadAllRulesFromDb();
     void loadAllSensorsFromDb();
-    void loadSensorDataFromDb(Sensor *sensor, QVariantList &ls, qint64 fromTime, int max);
-    void loadLightDataFromDb(LightNode *lightNode, QVariantList &ls, qint64 fromTime, int max);
+    void loadSensorDataFromDb(Sensor *sensor, QVariantList &ls, const DB_HistoryQuery &query);
+    void loadLightDataFromDb(LightNode *lightNode, QVariantList &ls, const DB_HistoryQuery &query);
 #ifdef USE_GATEWAY_API
     void loadAllGatewaysFromDb();
 #endif // USE_GATEWAY_API
@@ -1564,7 +1586,6 @@ public:
     int saveDatabaseItems;
     int saveDatabaseIdleTotalCounter;
     QString sqliteDatabaseName;
-    std::vector<QString> dbQueryQueue;
     qint64 dbZclValueMaxAge;
     QTimer *databaseTimer;
     QString emptyString;
@@ -1967,6 +1988,9 @@ public:
     QTime queryTime;
     ApsControllerWrapper apsCtrlWrapper;
     deCONZ::ApsController *apsCtrl = nullptr;
+    QFile *apsCaptureFile = nullptr;
+    QElapsedTimer apsCaptureTime;
+    QString apsReplayPath;
     uint groupTaskNodeIter; // Iterates through nodes array
     QElapsedTimer idleTimer;
     int idleTotalCounter; // sys timer
@@ -1980,6 +2004,7 @@ public:
     size_t sensorCheckIter;
     int sensorCheckFast;
     DeviceContainer m_devices;
+    std::unordered_map<quint32, GP_SourceEntry> gpSourceIndex;
     std::vector<Group> groups;
     std::vector<LightNode> nodes;
     std::vector<Rule> rules;
@@ -2001,6 +2026,7 @@ public:
 
     // events
     EventEmitter *eventEmitter = nullptr;
+    DeviceTick *deviceTick = nullptr;
 
     // bindings
     bool gwReportingEnabled;
@@ -16,12 +16,14 @@
 #include <array>
 #include <deconz/dbg_trace.h>
 #include <deconz/node.h>
+#include "database.h"
 #include "device.h"
 #include "device_access_fn.h"
 #include "device_descriptions.h"
 #include "event.h"
 #include "event_emitter.h"
 #include "utils/utils.h"
+#include "utils/zcl_records.h"
 #include "zcl/zcl.h"
 #include "zdp/zdp.h"
 
@@ -72,6 +74,7 @@ constexpr int RxOffWhenIdleResponseTime = 8000; // 7680 ms + some space for time
 constexpr int MaxConfirmTimeout = 20000; // If for some reason no APS-DATA.confirm is received (should almost
 constexpr int BindingAutoCheckInterval = 1000 * 60 * 60;
 constexpr int MaxPollItemRetries = 3;
+constexpr int64_t MinAdaptivePollInterval = 30; // seconds, lower limit when polling is tightened for stale reports
 constexpr int MaxIdleApsConfirmErrors = 16;
 constexpr int MaxSubResources = 8;
 
@@ -79,12 +82,17 @@ static int devManaged = -1;
 
 struct DEV_PollItem
 {
-    explicit DEV_PollItem(const Resource *r, const ResourceItem *i, const QVariant &p) :
-        resource(r), item(i), readParameters(p) {}
+    explicit DEV_PollItem(const Resource *r, const ResourceItem *i, const QVariant &p, const DA_ItemParams &params) :
+        resource(r), item(i), readParameters(p), readFunction(params.readFunction), readZcl(params.readZcl) {}
     size_t retry = 0;
+    bool coalesced = false; //! attributes are read together with the last item in the queue
+    bool zclResolved = false; //! zclParam is set
     const Resource *resource = nullptr;
     const ResourceItem *item = nullptr;
     QVariant readParameters;
+    ReadFunction_t readFunction = nullptr;
+    ZCL_Param readZcl{}; //! pre-decoded "zcl:attr" read parameters, endpoint not resolved
+    ZCL_Param zclParam{}; //! readZcl with resolved endpoint, see DEV_PollItemZclParam()
 };
 
 // special value for ReportTracker::lastConfigureCheck during zcl configure reporting step
@@ -94,6 +102,7 @@ struct ReportTracker
 {
     deCONZ::SteadyTimeRef lastReport;
     deCONZ::SteadyTimeRef lastConfigureCheck;
+    int64_t reportInterval = 0; //! smoothed interval between observed reports in ms, 0 if unknown
     uint16_t clusterId = 0;
     uint16_t attributeId = 0;
     uint8_t endpoint = 0;
@@ -118,10 +127,17 @@ struct BindingContext
     ZCL_ReadReportConfigurationParam readReportParam;
     ZCL_Result zclResult;
     ZDP_Result zdpResult;
+    DA_ApsPriority priority = DA_ApsPriorityBackground; //! lane of the running binding check
 };
 
 static ReportTracker &DEV_GetOrCreateReportTracker(Device *device, uint16_t clusterId, uint16_t attrId, uint8_t endpoint);
 
+struct DEV_DispatchEntry
+{
+    DA_ParseFilter filter;
+    DEV_DispatchItem pos;
+};
+
 class DevicePrivate
 {
 public:
@@ -152,6 +168,12 @@ public:
     QElapsedTimer awake; //! time to track when an end-device was last awake
     BindingContext binding; //! only used by binding sub state machine
     std::vector<DEV_PollItem> pollItems; //! queue of items to poll
+    size_t pollCoalesced = 0; //! number of items read together with pollItems.back()
+    DA_ApsPriority pollPriority = DA_ApsPriorityBackground; //! lane of the running poll
+    DEV_PollStats pollStats;
+    std::vector<DEV_DispatchEntry> dispatchIndex; //! items with a parse function, see DEV_GetDispatchItems()
+    size_t dispatchSignature = 0; //! item counts of the resources when dispatchIndex was built, 0 if invalid
+    DEV_DispatchStats dispatchStats;
     int idleApsConfirmErrors = 0;
     /*! True while a new state waits for the state enter event, which must arrive first.
         This is for debug asserting that the order of events is valid - it doesn't drive logic. */
@@ -349,6 +371,11 @@ void DEV_NodeDescriptorStateHandler(Device *device, const Event &event)
 
     if (event.what() == REventStateEnter)
     {
+        if (device->node()->nodeDescriptor().isNull())
+        {
+            DB_RestoreZdpDescriptors(device->node()); // known from a previous run?
+        }
+
         if (!device->node()->nodeDescriptor().isNull())
         {
             DBG_Printf(DBG_DEV, "DEV ZDP node descriptor verified: " FMT_MAC "\n", FMT_MAC_CAST(device->key()));
@@ -474,6 +501,32 @@ void DEV_ActiveEndpointsStateHandler(Device *device, const Event &event)
 }
 
 
+/*! Returns the first active endpoint without a valid simple descriptor, or 0x00 if all are known.
+ */
+static quint8 DEV_MissingSimpleDescriptorEndpoint(const deCONZ::Node *node)
+{
+    for (uint8_t ep : node->endpoints())
+    {
+        bool ok = false;
+        for (size_t i = 0; i < node->simpleDescriptors().size(); i++)
+        {
+            const deCONZ::SimpleDescriptor &sd = node->simpleDescriptors()[i];
+            if (sd.endpoint() == ep && sd.deviceId() != 0xffff)
+            {
+                ok = true;
+                break;
+            }
+        }
+
+        if (!ok)
+        {
+            return ep;
+        }
+    }
+
+    return 0x00;
+}
+
 /*! #4 This state checks that for all active endpoints simple descriptors are known.
  */
 void DEV_SimpleDescriptorStateHandler(Device *device, const Event &event)
@@ -493,24 +546,11 @@ void DEV_SimpleDescriptorStateHandler(Device *device, const Event &event)
         }
         else
         {
-            for (uint8_t ep : device->node()->endpoints())
-            {
-                bool ok = false;
-                for (size_t i = 0; i < device->node()->simpleDescriptors().size(); i++)
-                {
-                    const deCONZ::SimpleDescriptor &sd = device->node()->simpleDescriptors()[i];
-                    if (sd.endpoint() == ep && sd.deviceId() != 0xffff)
-                    {
-                        ok = true;
-                        break;
-                    }
-                }
+            needFetchEp = DEV_MissingSimpleDescriptorEndpoint(device->node());
 
-                if (!ok)
-                {
-                    needFetchEp = ep;
-                    break;
-                }
+            if (needFetchEp != 0x00 && DB_RestoreZdpDescriptors(device->node()) > 0)
+            {
+                needFetchEp = DEV_MissingSimpleDescriptorEndpoint(device->node());
             }
         }
 
@@ -981,12 +1021,14 @@ void DEV_BindingHandler(Device *device, const Event &event)
         {
             // nothing todo
         }
-        else if (DA_ApsUnconfirmedRequests() > 4)
+        else if (event.what() != REventAwake && !DA_ApsCanAdmit(device->key(), DA_ApsPriorityBackground))
         {
             // wait
         }
         else
         {
+            // sleeping devices are only shortly awake, don't hold their requests back
+            d->binding.priority = event.what() == REventAwake ? DA_ApsPriorityNormal : DA_ApsPriorityBackground;
             d->binding.bindingIter = 0;
             if (d->binding.mgmtBindSupported == MGMT_BIND_NOT_SUPPORTED)
             {
@@ -1038,10 +1080,12 @@ void DEV_BindingTableReadHandler(Device *device, const Event &event)
     }
     else if (event.what() == REventBindingTick)
     {
+        const uint32_t mark = DA_ApsEnqueueMark();
         d->zdpResult = ZDP_MgmtBindReq(d->binding.mgmtBindStartIndex, d->node->address(), d->apsCtrl);
 
         if (d->zdpResult.isEnqueued)
         {
+            DA_ApsAdmitted(d->deviceKey, mark, d->binding.priority);
             d->startStateTimer(MaxConfirmTimeout, STATE_LEVEL_BINDING);
         }
         else
@@ -1278,10 +1322,12 @@ void DEV_BindingCreateHandler(Device *device, const Event &event)
 
         const auto bnd = DEV_ToCoreBinding(ddfBinding, d->deviceKey);
 
+        const uint32_t mark = DA_ApsEnqueueMark();
         d->zdpResult = ZDP_BindReq(bnd, d->apsCtrl);
 
         if (d->zdpResult.isEnqueued)
         {
+            DA_ApsAdmitted(d->deviceKey, mark, d->binding.priority);
             d->startStateTimer(MaxConfirmTimeout, STATE_LEVEL_BINDING);
         }
         else
@@ -1385,10 +1431,12 @@ void DEV_BindingRemoveHandler(Device *device, const Event &event)
             return;
         }
 
+        const uint32_t mark = DA_ApsEnqueueMark();
         d->zdpResult = ZDP_UnbindReq(*i, d->apsCtrl);
 
         if (d->zdpResult.isEnqueued)
         {
+            DA_ApsAdmitted(d->deviceKey, mark, d->binding.priority);
             d->startStateTimer(MaxConfirmTimeout, STATE_LEVEL_BINDING);
         }
         else
@@ -1556,10 +1604,12 @@ void DEV_ReadReportConfigurationHandler(Device *device, const Event &event)
             return;
         }
 
+        const uint32_t mark = DA_ApsEnqueueMark();
         d->binding.zclResult = ZCL_ReadReportConfiguration(param, d->apsCtrl);
 
         if (d->binding.zclResult.isEnqueued)
         {
+            DA_ApsAdmitted(d->deviceKey, mark, d->binding.priority);
             d->startStateTimer(MaxConfirmTimeout, STATE_LEVEL_BINDING);
         }
         else
@@ -1690,6 +1740,7 @@ void DEV_ConfigureReportingHandler(Device *device, const Event &event)
             }
         }
 
+        const uint32_t mark = DA_ApsEnqueueMark();
         d->binding.zclResult.isEnqueued = false;
 
         if (!param.records.empty())
@@ -1699,6 +1750,7 @@ void DEV_ConfigureReportingHandler(Device *device, const Event &event)
 
         if (d->binding.zclResult.isEnqueued)
         {
+            DA_ApsAdmitted(d->deviceKey, mark, d->binding.priority);
             d->startStateTimer(MaxConfirmTimeout, STATE_LEVEL_BINDING);
         }
         else
@@ -1807,30 +1859,64 @@ static ReportTracker &DEV_GetOrCreateReportTracker(Device *device, uint16_t clus
     return d->binding.reportTrackers.back();
 }
 
-static void DEV_UpdateReportTracker(Device *device, const ResourceItem *item)
+/*! Learns the interval in which reports arrive from the records of a ZCL Report Attributes \p payload.
+    Called for each received report, so the interval is the smoothed gap between two reports.
+ */
+void DEV_ZclReportAttributes(Device *device, uint8_t endpoint, uint16_t clusterId, const QByteArray &payload)
 {
-    if (!isValid(item->lastZclReport()))
+    std::vector<ZCL_AttributeRecord> records;
+    // records before a malformed or unsupported one are still valid
+    ZCL_IndexAttributeRecords(reinterpret_cast<const uint8_t*>(payload.constData()), size_t(payload.size()), false, &records);
+
+    const auto tnow = deCONZ::steadyTimeRef();
+
+    for (const ZCL_AttributeRecord &record : records)
     {
-        return;
+        ReportTracker &tracker = DEV_GetOrCreateReportTracker(device, clusterId, record.id, endpoint);
+
+        if (isValid(tracker.lastReport) && tracker.lastReport.ref < tnow.ref)
+        {
+            const int64_t dt = (tnow - tracker.lastReport).val;
+            tracker.reportInterval = tracker.reportInterval == 0 ? dt : (tracker.reportInterval * 3 + dt) / 4;
+        }
+
+        tracker.lastReport = tnow;
     }
+}
 
+/*! Returns the report tracker of the first attribute of \p item or nullptr if no report arrived yet. */
+static const ReportTracker *DEV_GetReportTracker(const Device *device, const ResourceItem *item)
+{
     const ZCL_Param &zclParam = item->zclParam();
     if (!isValid(zclParam) || zclParam.attributeCount == 0)
     {
-        return;
+        return nullptr;
     }
 
-    Q_ASSERT(zclParam.attributeCount < zclParam.attributes.size());
+    const auto &trackers = device->d->binding.reportTrackers;
+    const auto i = std::find_if(trackers.cbegin(), trackers.cend(), [&](const ReportTracker &tracker) {
+        return tracker.endpoint == zclParam.endpoint &&
+               tracker.clusterId == zclParam.clusterId &&
+               tracker.attributeId == zclParam.attributes[0];
+    });
 
-    for (size_t i = 0; i < zclParam.attributeCount && i < zclParam.attributes.size(); i++)
+    if (i != trackers.cend() && isValid(i->lastReport))
     {
-        ReportTracker &tracker = DEV_GetOrCreateReportTracker(device, zclParam.clusterId, zclParam.attributes[i], zclParam.endpoint);
-        tracker.lastReport = item->lastZclReport();
+        return &*i;
     }
+
+    return nullptr;
 }
 
 /*! Returns all items wich are ready for polling.
     The returned vector is reversed to use std::vector::pop_back() when processing the queue.
+
+    Polling adapts to ZCL reports tracked per attribute, see DEV_ZclReportAttributes():
+
+    - While reports arrive within max(refresh interval, 2x learned report interval) the item isn't polled.
+    - When reports went stale the item is polled in 2x learned report interval spacing
+      (bounded by MinAdaptivePollInterval and the refresh interval) until reports arrive again.
+    - Without reports the refresh interval of the DDF applies.
  */
 std::vector<DEV_PollItem> DEV_GetPollItems(Device *device)
 {
@@ -1850,7 +1936,7 @@ std::vector<DEV_PollItem> DEV_GetPollItems(Device *device)
                 continue;
             }
 
-            DEV_UpdateReportTracker(device, item);
+            const ReportTracker *tracker = DEV_GetReportTracker(device, item);
 
             const auto &ddfItem = DDF_GetItem(item);
 
@@ -1860,6 +1946,7 @@ std::vector<DEV_PollItem> DEV_GetPollItems(Device *device)
             }
 
             int64_t dt = -1;
+            bool stale = false;
 
             if (item->refreshInterval().val == 0)
             {
@@ -1867,19 +1954,30 @@ std::vector<DEV_PollItem> DEV_GetPollItems(Device *device)
             }
             else
             {
+                int64_t interval = item->refreshInterval().val;
+
                 if (isValid(item->lastZclReport()))
                 {
+                    const int64_t reportInterval = tracker ? tracker->reportInterval / 1000 : 0;
+
                     dt = (tnow - item->lastZclReport()).val / 1000;
-                    if (dt < item->refreshInterval().val)
+                    if (dt < std::max(interval, reportInterval * 2))
                     {
+                        d->pollStats.suppressed++;
                         continue;
                     }
+
+                    if (reportInterval > 0)
+                    {
+                        interval = std::min(interval, std::max(MinAdaptivePollInterval, reportInterval * 2));
+                        stale = true;
+                    }
                 }
 
                 if (item->lastSet().isValid() && (item->valueSource() == ResourceItem::SourceDevice || item->valueSource() == ResourceItem::SourceUnknown))
                 {
                     const auto dt2 = item->lastSet().secsTo(now);
-                    if (dt2  < item->refreshInterval().val)
+                    if (dt2  < interval)
                     {
                         continue;
                     }
@@ -1888,19 +1986,18 @@ std::vector<DEV_PollItem> DEV_GetPollItems(Device *device)
                 }
             }
 
-            const auto m = ddfItem.readParameters.toMap();
-            if (m.empty())
+            if (!ddfItem.params.hasRead)
             {
                 continue;
             }
 
-            if (m.contains(QLatin1String("fn")) && m.value(QLatin1String("fn")).toString() == QLatin1String("none"))
+            DBG_Printf(DBG_DEV, "DEV " FMT_MAC " read %s, dt %d sec%s\n", FMT_MAC_CAST(d->deviceKey), item->descriptor().suffix, int(dt), stale ? ", reports stale" : "");
+            result.emplace_back(DEV_PollItem{r, item, ddfItem.readParameters, ddfItem.params});
+            d->pollStats.polled++;
+            if (stale)
             {
-                continue;
+                d->pollStats.stale++;
             }
-
-            DBG_Printf(DBG_DEV, "DEV " FMT_MAC " read %s, dt %d sec\n", FMT_MAC_CAST(d->deviceKey), item->descriptor().suffix, int(dt));
-            result.emplace_back(DEV_PollItem{r, item, ddfItem.readParameters});
         }
     }
 
@@ -1921,12 +2018,15 @@ void DEV_PollIdleStateHandler(Device *device, const Event &event)
     }
     else if (event.what() == REventPoll || event.what() == REventAwake)
     {
-        if (DA_ApsUnconfirmedRequests() > 4)
+        // sleeping devices are only shortly awake, don't hold their polls back
+        if (event.what() != REventAwake && !DA_ApsCanAdmit(device->key(), DA_ApsPriorityBackground))
         {
             // wait
             return;
         }
 
+        d->pollPriority = event.what() == REventAwake ? DA_ApsPriorityNormal : DA_ApsPriorityBackground;
+
         if (device->node()) // update nwk address if needed
         {
             const auto &addr = device->node()->address();
@@ -1977,6 +2077,180 @@ void DEV_PollIdleStateHandler(Device *device, const Event &event)
     }
 }
 
+/*! Returns the "zcl:attr" read parameters of \p pollItem with resolved endpoint.
+    They are resolved once per poll item, not on each PollNext.
+ */
+static const ZCL_Param &DEV_PollItemZclParam(DEV_PollItem &pollItem)
+{
+    if (!pollItem.zclResolved)
+    {
+        pollItem.zclParam = DA_ResolveZclReadParam(pollItem.resource, pollItem.readZcl);
+        pollItem.zclResolved = true;
+    }
+
+    return pollItem.zclParam;
+}
+
+/*! Merges pending "zcl:attr" reads for the same endpoint, cluster and manufacturer code
+    into the read of the last poll item, up to ZCL_Param::MaxAttributes attributes.
+
+    The merged items are moved directly in front of the last item so that they can be popped
+    together when the response arrives. Since the response is processed by the parse functions
+    of all items, each merged item gets its value from the single response.
+
+    \returns the merged parameters, or invalid parameters if nothing could be merged.
+ */
+static ZCL_Param DEV_CoalesceZclReads(DevicePrivate *d)
+{
+    d->pollCoalesced = 0;
+
+    if (d->pollItems.size() < 2)
+    {
+        return {};
+    }
+
+    for (auto &pollItem : d->pollItems)
+    {
+        pollItem.coalesced = false;
+    }
+
+    ZCL_Param param = DEV_PollItemZclParam(d->pollItems.back());
+
+    if (!isValid(param))
+    {
+        return {};
+    }
+
+    for (size_t i = d->pollItems.size() - 1; i-- > 0; )
+    {
+        auto &pollItem = d->pollItems[i];
+        const ZCL_Param &param2 = DEV_PollItemZclParam(pollItem);
+
+        if (!isValid(param2) ||
+            param2.endpoint != param.endpoint ||
+            param2.clusterId != param.clusterId ||
+            param2.manufacturerCode != param.manufacturerCode ||
+            param2.ignoreResponseSeq != param.ignoreResponseSeq)
+        {
+            continue;
+        }
+
+        if (param.attributeCount + param2.attributeCount > ZCL_Param::MaxAttributes)
+        {
+            continue;
+        }
+
+        for (size_t j = 0; j < param2.attributeCount; j++)
+        {
+            const auto end = param.attributes.begin() + param.attributeCount;
+            if (std::find(param.attributes.begin(), end, param2.attributes[j]) == end)
+            {
+                param.attributes[param.attributeCount] = param2.attributes[j];
+                param.attributeCount++;
+            }
+        }
+
+        pollItem.coalesced = true;
+        d->pollCoalesced++;
+    }
+
+    if (d->pollCoalesced == 0)
+    {
+        return {};
+    }
+
+    std::stable_partition(d->pollItems.begin(), d->pollItems.end() - 1, [](const DEV_PollItem &pollItem)
+    {
+        return !pollItem.coalesced;
+    });
+
+    d->pollStats.coalesced += d->pollCoalesced;
+
+    return param;
+}
+
+/*! Marks \p pollItem as unsupported when the status record of its first attribute is UNSUPPORTED_ATTRIBUTE.
+    Items without "zcl:attr" read parameters use the first record, like the single status of REventZclResponse.
+ */
+static void DEV_CheckPollItemStatus(DEV_PollItem &pollItem, const std::vector<ZCL_AttributeRecord> &records)
+{
+    if (records.empty())
+    {
+        return;
+    }
+
+    const ZCL_Param &param = DEV_PollItemZclParam(pollItem);
+    auto rec = records.cbegin();
+
+    if (isValid(param) && param.attributeCount > 0)
+    {
+        rec = std::find_if(records.cbegin(), records.cend(), [&param](const ZCL_AttributeRecord &x)
+        {
+            return x.id == param.attributes[0];
+        });
+    }
+
+    if (rec == records.cend() || rec->status != deCONZ::ZclUnsupportedAttributeStatus)
+    {
+        return;
+    }
+
+    Resource *r = DEV_GetResource(pollItem.resource->handle());
+    ResourceItem *item = r ? r->item(pollItem.item->descriptor().suffix) : nullptr;
+
+    if (item)
+    {
+        item->setZclUnsupportedAttribute();
+    }
+}
+
+/*! Handles the status records of a ZCL Read Attributes Response \p payload before the related
+    REventZclResponse is processed, which only carries the status of the first record.
+    For a coalesced read each of the items read together gets the status of its own attribute.
+ */
+void DEV_ZclReadAttributesResponse(Device *device, uint16_t clusterId, uint8_t seq, const QByteArray &payload)
+{
+    DevicePrivate *d = device->d;
+
+    if (d->state[STATE_LEVEL_POLL] != DEV_PollBusyStateHandler || d->pollItems.empty())
+    {
+        return;
+    }
+
+    if (d->readResult.clusterId != clusterId ||
+        (d->readResult.sequenceNumber != seq && !d->readResult.ignoreResponseSequenceNumber))
+    {
+        return;
+    }
+
+    std::vector<ZCL_AttributeRecord> records;
+    // records before a malformed or unsupported one are still valid
+    ZCL_IndexAttributeRecords(reinterpret_cast<const uint8_t*>(payload.constData()), size_t(payload.size()), true, &records);
+
+    const size_t count = std::min(d->pollItems.size(), d->pollCoalesced + 1);
+
+    for (size_t i = d->pollItems.size() - count; i < d->pollItems.size(); i++)
+    {
+        DEV_CheckPollItemStatus(d->pollItems[i], records);
+    }
+}
+
+/*! Removes the last poll item and the items which were read together with it. */
+static void DEV_PopPollItem(DevicePrivate *d)
+{
+    if (!d->pollItems.empty())
+    {
+        d->pollItems.pop_back();
+    }
+
+    for (;d->pollCoalesced > 0 && !d->pollItems.empty(); d->pollCoalesced--)
+    {
+        d->pollItems.pop_back();
+    }
+
+    d->pollCoalesced = 0;
+}
+
 /*! This state processes the next DEV_PollItem and moves to the PollBusy state.
     If no more items are in the queue it moves back to PollIdle state.
  */
@@ -1995,16 +2269,23 @@ void DEV_PollNextStateHandler(Device *device, const Event &event)
         if (d->pollItems.empty())
         {
             d->setState(DEV_PollIdleStateHandler, STATE_LEVEL_POLL);
-            // notify DeviceTick to proceed
-            DEV_EnqueueEvent(device, REventPollDone);
+            // notify DeviceTick to proceed, num = 1 signals that requests were sent
+            emit device->eventNotify(Event(device->prefix(), REventPollDone, 1, device->key()));
             return;
         }
 
+        const ZCL_Param coalescedParam = DEV_CoalesceZclReads(d);
         auto &poll = d->pollItems.back();
-        const auto readFunction = DA_GetReadFunction(poll.readParameters);
+        const auto readFunction = poll.readFunction;
 
+        const uint32_t mark = DA_ApsEnqueueMark();
         d->readResult = { };
-        if (readFunction)
+        if (readFunction && isValid(coalescedParam))
+        {
+            DBG_Printf(DBG_DEV, "DEV Poll Next read %s / " FMT_MAC " with %u more items, cluster: 0x%04X\n", poll.item->descriptor().suffix, FMT_MAC_CAST(device->key()), unsigned(d->pollCoalesced), coalescedParam.clusterId);
+            d->readResult = DA_ReadZclAttributes(poll.resource, coalescedParam, d->apsCtrl);
+        }
+        else if (readFunction)
         {
             d->readResult = readFunction(poll.resource, poll.item, d->apsCtrl, poll.readParameters);
         }
@@ -2018,6 +2299,7 @@ void DEV_PollNextStateHandler(Device *device, const Event &event)
 
         if (d->readResult.isEnqueued)
         {
+            DA_ApsAdmitted(device->key(), mark, d->pollPriority);
             d->setState(DEV_PollBusyStateHandler, STATE_LEVEL_POLL);
         }
         else
@@ -2096,22 +2378,11 @@ void DEV_PollBusyStateHandler(Device *device, const Event &event)
             DBG_Printf(DBG_DEV, "DEV Poll Busy %s/" FMT_MAC " ZCL response seq: %u, status: 0x%02X, cluster: 0x%04X\n",
                    event.resource(), FMT_MAC_CAST(event.deviceKey()), d->readResult.sequenceNumber, status, d->readResult.clusterId);
 
+            // unsupported attributes are already marked by DEV_ZclReadAttributesResponse()
             DBG_Assert(!d->pollItems.empty());
             if (!d->pollItems.empty())
             {
-                if (status == deCONZ::ZclUnsupportedAttributeStatus)
-                {
-                    const auto &pi = d->pollItems.back();
-                    Resource *r = DEV_GetResource(pi.resource->handle());
-                    ResourceItem *item = r ? r->item(pi.item->descriptor().suffix) : nullptr;
-
-                    if (item)
-                    {
-                        item->setZclUnsupportedAttribute();
-                    }
-                }
-
-                d->pollItems.pop_back();
+                DEV_PopPollItem(d);
             }
             d->setState(DEV_PollNextStateHandler, STATE_LEVEL_POLL);
         }
@@ -2304,6 +2575,7 @@ void Device::addSubDevice(Resource *sub)
         if (!isValid(hnd))
         {
             hnd = sub->handle();
+            DEV_InvalidateDispatchIndex(this);
             DEV_CheckReachable(this);
 
             std::sort(d->subResourceHandles.begin(), d->subResourceHandles.end(), [](const auto &a, const auto &b)
@@ -2464,6 +2736,152 @@ qint64 Device::lastAwakeMs() const
     return d->awake.isValid() ? d->awake.elapsed() : 8640000;
 }
 
+const DEV_PollStats &Device::pollStats() const
+{
+    return d->pollStats;
+}
+
+const DEV_DispatchStats &Device::dispatchStats() const
+{
+    return d->dispatchStats;
+}
+
+/*! Forces a rebuild of the dispatch index on the next indication, e.g. after the DDF was (re)loaded.
+ */
+void DEV_InvalidateDispatchIndex(Device *device)
+{
+    device->d->dispatchSignature = 0;
+}
+
+static size_t DEV_DispatchSignature(const std::vector<Resource*> &resources)
+{
+    size_t result = resources.size() + 1;
+
+    for (const Resource *r : resources)
+    {
+        result = result * 31 + size_t(r->itemCount());
+    }
+
+    return result;
+}
+
+/*! Collects the items of all \p resources with a parse function, together with the clusters and endpoint they match.
+ */
+static void DEV_BuildDispatchIndex(DevicePrivate *d, const std::vector<Resource*> &resources)
+{
+    d->dispatchIndex.clear();
+    d->dispatchSignature = DEV_DispatchSignature(resources);
+    d->dispatchStats.rebuilds++;
+
+    for (size_t ri = 0; ri < resources.size(); ri++)
+    {
+        Resource *r = resources[ri];
+
+        for (int i = 0; i < r->itemCount(); i++)
+        {
+            const ResourceItem *item = r->itemForIndex(size_t(i));
+            if (!item)
+            {
+                continue;
+            }
+
+            ParseFunction_t parseFunction = item->parseFunction();
+            const auto &ddfItem = DDF_GetItem(item);
+
+            if (!parseFunction && ddfItem.isValid())
+            {
+                parseFunction = ddfItem.params.parseFunction;
+            }
+
+            if (!parseFunction)
+            {
+                if (!ddfItem.parseParameters.isNull())
+                {
+                    DBG_Printf(DBG_INFO, "parse function for %s not found: %s\n", item->descriptor().suffix, qPrintable(ddfItem.parseParameters.toString()));
+                }
+                continue;
+            }
+
+            DA_ItemParams params = ddfItem.params;
+            params.parseFunction = parseFunction;
+
+            DEV_DispatchEntry entry;
+            entry.filter = DA_GetParseFilter(r, params);
+            entry.pos.resource = uint16_t(ri);
+            entry.pos.item = uint16_t(i);
+            d->dispatchIndex.push_back(entry);
+        }
+    }
+}
+
+/*! Returns the items of \p resources which may parse an indication of \p clusterId from \p endpoint.
+
+    The index is rebuilt when resources or items were added. The returned items are
+    ordered by resource and item index.
+ */
+void DEV_GetDispatchItems(Device *device, const std::vector<Resource*> &resources, uint16_t clusterId, uint8_t endpoint, std::vector<DEV_DispatchItem> *items)
+{
+    DevicePrivate *d = device->d;
+    items->clear();
+
+    if (d->dispatchSignature != DEV_DispatchSignature(resources))
+    {
+        DEV_BuildDispatchIndex(d, resources);
+    }
+
+    size_t itemCount = 0;
+    for (const Resource *r : resources)
+    {
+        itemCount += size_t(r->itemCount());
+    }
+
+    for (const DEV_DispatchEntry &entry : d->dispatchIndex)
+    {
+        const DA_ParseFilter &f = entry.filter;
+
+        if (f.endpoint != 255 && f.endpoint != endpoint)
+        {
+            continue;
+        }
+
+        if (f.clusterCount == 0 ||
+            f.clusters[0] == clusterId ||
+            (f.clusterCount == 2 && f.clusters[1] == clusterId))
+        {
+            items->push_back(entry.pos);
+        }
+    }
+
+    d->dispatchStats.dispatched += uint32_t(items->size());
+    d->dispatchStats.skipped += uint32_t(itemCount - items->size());
+}
+
+/*! Returns true if items of the device description explicitly parse \p clusterId from \p endpoint.
+
+    Items without a cluster in their parse filter don't count. Uses the dispatch index of the
+    last DEV_GetDispatchItems() call, for an index which wasn't built yet false is returned.
+ */
+bool DEV_ParsesCluster(Device *device, uint16_t clusterId, uint8_t endpoint)
+{
+    for (const DEV_DispatchEntry &entry : device->d->dispatchIndex)
+    {
+        const DA_ParseFilter &f = entry.filter;
+
+        if (f.endpoint != 255 && f.endpoint != endpoint)
+        {
+            continue;
+        }
+
+        if ((f.clusterCount >= 1 && f.clusters[0] == clusterId) ||
+            (f.clusterCount == 2 && f.clusters[1] == clusterId))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool Device::reachable() const
 {
     if (lastAwakeMs() < RxOffWhenIdleResponseTime)
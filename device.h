@@ -87,6 +87,30 @@ enum DEV_StateLevel {
 
 class DevicePrivate;
 
+/*! Per device statistics of the adaptive polling in DEV_GetPollItems().
+ */
+struct DEV_PollStats
+{
+    uint32_t polled = 0;     //! items queued for polling
+    uint32_t suppressed = 0; //! items skipped since fresh ZCL reports arrive
+    uint32_t stale = 0;      //! items polled with a tightened interval since ZCL reports went stale
+    uint32_t coalesced = 0;  //! items read within the ZCL Read Attributes request of another item
+};
+
+struct DEV_DispatchStats
+{
+    uint32_t dispatched = 0; //! items whose parse function was called for an indication
+    uint32_t skipped = 0;    //! items skipped since they can't match the cluster or endpoint
+    uint32_t rebuilds = 0;   //! dispatch index (re)builds
+};
+
+/*! An item which may parse an indication, as index into the resources given to DEV_GetDispatchItems(). */
+struct DEV_DispatchItem
+{
+    uint16_t resource;
+    uint16_t item;
+};
+
 class Device : public QObject,
                public Resource
 {
@@ -113,6 +137,8 @@ public:
     void timerEvent(QTimerEvent *event) override;
     qint64 lastAwakeMs() const;
     bool reachable() const;
+    const DEV_PollStats &pollStats() const;
+    const DEV_DispatchStats &dispatchStats() const;
     const std::vector<Resource *> &subDevices();
     void clearBindings();
     void addBinding(const DDF_Binding &bnd);
@@ -123,6 +149,11 @@ Q_SIGNALS:
 };
 
 Device *DEV_ParentDevice(Resource *r);
+void DEV_GetDispatchItems(Device *device, const std::vector<Resource*> &resources, uint16_t clusterId, uint8_t endpoint, std::vector<DEV_DispatchItem> *items);
+void DEV_InvalidateDispatchIndex(Device *device);
+bool DEV_ParsesCluster(Device *device, uint16_t clusterId, uint8_t endpoint);
+void DEV_ZclReadAttributesResponse(Device *device, uint16_t clusterId, uint8_t seq, const QByteArray &payload);
+void DEV_ZclReportAttributes(Device *device, uint8_t endpoint, uint16_t clusterId, const QByteArray &payload);
 
 /*! Helper to forward attributes to core (modelid, battery, etc.). */
 void DEV_ForwardNodeChange(Device *device, const QString &key, const QString &value);
@@ -8,6 +8,7 @@
  *
  */
 
+#include <algorithm>
 #include <QIODevice>
 #include <QTimeZone>
 #include "deconz/u_assert.h"
@@ -17,6 +18,8 @@
 #include "ias_zone.h"
 #include "resource.h"
 #include "zcl/zcl.h"
+#include "utils/tuya_dp.h"
+#include "utils/zcl_records.h"
 
 
 #define CMD_ID_ANY 0x100
@@ -280,6 +283,14 @@ static ZCL_Param getZclParam(const QVariantMap &param)
     return result;
 }
 
+/*! Returns the pre-decoded parameters of the DDF item of \p item, or nullptr if there is none.
+ */
+static const DA_ItemParams *DA_GetItemParams(const ResourceItem *item)
+{
+    const auto &ddfItem = DDF_GetItem(item);
+    return ddfItem.isValid() ? &ddfItem.params : nullptr;
+}
+
 quint8 resolveAutoEndpoint(const Resource *r)
 {
     quint8 result = AutoEndpoint;
@@ -330,7 +341,8 @@ bool evalZclAttribute(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndi
         return false;
     }
 
-    const auto expr = parseParameters.toMap()["eval"].toString();
+    const DA_ItemParams *params = DA_GetItemParams(item);
+    const QString expr = params ? params->parseEval : parseParameters.toMap().value(QLatin1String("eval")).toString();
 
     if (!expr.isEmpty())
     {
@@ -365,7 +377,8 @@ bool evalZclAttribute(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndi
  */
 bool evalZclFrame(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndication &ind, const deCONZ::ZclFrame &zclFrame, const QVariant &parseParameters)
 {
-    const auto expr = parseParameters.toMap()["eval"].toString();
+    const DA_ItemParams *params = DA_GetItemParams(item);
+    const QString expr = params ? params->parseEval : parseParameters.toMap().value(QLatin1String("eval")).toString();
 
     if (!expr.isEmpty())
     {
@@ -512,6 +525,95 @@ bool parseNumericToString(Resource *r, ResourceItem *item, const deCONZ::ApsData
     return result;
 }
 
+/*! Attribute records of the last parsed ZCL frame. All items of a device parse the same
+    frame, so the payload is indexed only once per indication instead of once per item.
+ */
+struct DA_FrameRecords
+{
+    QByteArray payload;
+    bool hasStatus = false;
+    ZCL_RecordsResult result = ZCL_RecordsOk;
+    std::vector<ZCL_AttributeRecord> records;
+};
+
+static DA_FrameRecords _DA_FrameRecords;
+
+static const DA_FrameRecords &DA_GetFrameRecords(const deCONZ::ZclFrame &zclFrame)
+{
+    DA_FrameRecords &frame = _DA_FrameRecords;
+    const bool hasStatus = zclFrame.commandId() == deCONZ::ZclReadAttributesResponseId;
+
+    if (frame.hasStatus != hasStatus || frame.payload != zclFrame.payload())
+    {
+        frame.payload = zclFrame.payload();
+        frame.hasStatus = hasStatus;
+        frame.result = ZCL_IndexAttributeRecords(reinterpret_cast<const uint8_t*>(frame.payload.constData()), size_t(frame.payload.size()), hasStatus, &frame.records);
+    }
+
+    return frame;
+}
+
+static bool DA_HasZclAttribute(const ZCL_Param &param, uint16_t attrId)
+{
+    for (size_t i = 0; i < param.attributeCount; i++)
+    {
+        if (param.attributes[i] == attrId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*! Decodes all attributes of the payload, used for frames with data types ZCL_IndexAttributeRecords() can't skip.
+ */
+static bool parseZclAttributeStream(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndication &ind, const deCONZ::ZclFrame &zclFrame, const QVariant &parseParameters)
+{
+    bool result = false;
+
+    QDataStream stream(zclFrame.payload());
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    int attrIndex = -1;
+    while (!stream.atEnd())
+    {
+        quint16 attrId;
+        quint8 status;
+        quint8 dataType;
+
+        stream >> attrId;
+        attrIndex++;
+
+        if (zclFrame.commandId() == deCONZ::ZclReadAttributesResponseId)
+        {
+            stream >> status;
+            if (status != deCONZ::ZclSuccessStatus)
+            {
+                continue;
+            }
+        }
+
+        stream >> dataType;
+        deCONZ::ZclAttribute attr(attrId, dataType, QLatin1String(""), deCONZ::ZclReadWrite, true);
+
+        if (!attr.readFromStream(stream))
+        {
+            break;
+        }
+
+        if (evalZclAttribute(r, item, ind, zclFrame, attrIndex, attr, parseParameters))
+        {
+            if (zclFrame.commandId() == deCONZ::ZclReportAttributesId)
+            {
+                item->setLastZclReport(deCONZ::steadyTimeRef().ref);
+            }
+            result = true;
+        }
+    }
+
+    return result;
+}
+
 /*! A generic function to parse ZCL values from read/report commands.
     The item->parseParameters() is expected to be an object (given in the device description file).
 
@@ -541,7 +643,8 @@ bool parseZclAttribute(Resource *r, ResourceItem *item, const deCONZ::ApsDataInd
             return result;
         }
 
-        ZCL_Param param = getZclParam(parseParameters.toMap());
+        const DA_ItemParams *params = DA_GetItemParams(item);
+        ZCL_Param param = params ? params->parseZcl : getZclParam(parseParameters.toMap());
 
         Q_ASSERT(param.valid);
         if (!param.valid)
@@ -639,37 +742,32 @@ bool parseZclAttribute(Resource *r, ResourceItem *item, const deCONZ::ApsDataInd
         return result;
     }
 
-    QDataStream stream(zclFrame.payload());
-    stream.setByteOrder(QDataStream::LittleEndian);
+    const DA_FrameRecords &frame = DA_GetFrameRecords(zclFrame);
 
-    int attrIndex = -1;
-    while (!stream.atEnd())
+    if (frame.result == ZCL_RecordsUnsupported)
     {
-        quint16 attrId;
-        quint8 status;
-        quint8 dataType;
-
-        stream >> attrId;
-        attrIndex++;
+        return parseZclAttributeStream(r, item, ind, zclFrame, parseParameters);
+    }
 
-        if (zclFrame.commandId() == deCONZ::ZclReadAttributesResponseId)
+    // only decode the values of attributes this item is interested in
+    for (const ZCL_AttributeRecord &rec : frame.records)
+    {
+        if (rec.status != deCONZ::ZclSuccessStatus || !DA_HasZclAttribute(zclParam, rec.id))
         {
-            stream >> status;
-            if (status != deCONZ::ZclSuccessStatus)
-            {
-                continue;
-            }
+            continue;
         }
 
-        stream >> dataType;
-        deCONZ::ZclAttribute attr(attrId, dataType, QLatin1String(""), deCONZ::ZclReadWrite, true);
+        QDataStream stream(QByteArray::fromRawData(frame.payload.constData() + rec.offset, rec.size));
+        stream.setByteOrder(QDataStream::LittleEndian);
+
+        deCONZ::ZclAttribute attr(rec.id, rec.dataType, QLatin1String(""), deCONZ::ZclReadWrite, true);
 
         if (!attr.readFromStream(stream))
         {
             break;
         }
 
-        if (evalZclAttribute(r, item, ind, zclFrame, attrIndex, attr, parseParameters))
+        if (evalZclAttribute(r, item, ind, zclFrame, rec.index, attr, parseParameters))
         {
             if (zclFrame.commandId() == deCONZ::ZclReportAttributesId)
             {
@@ -682,6 +780,41 @@ bool parseZclAttribute(Resource *r, ResourceItem *item, const deCONZ::ApsDataInd
     return result;
 }
 
+/*! Datapoints of the last Tuya frame, shared by all items of a device which parse it.
+ */
+struct DA_TuyaFrame
+{
+    QByteArray payload;
+    TY_Frame frame;
+};
+
+static DA_TuyaFrame _DA_TuyaFrame;
+
+static const TY_Frame &DA_GetTuyaFrame(const deCONZ::ZclFrame &zclFrame)
+{
+    DA_TuyaFrame &tf = _DA_TuyaFrame;
+
+    if (tf.payload != zclFrame.payload())
+    {
+        tf.payload = zclFrame.payload();
+        TY_DecodeFrame(reinterpret_cast<const uint8_t*>(tf.payload.constData()), size_t(tf.payload.size()), &tf.frame);
+
+        if (DBG_IsEnabled(DBG_INFO))
+        {
+            const char *rt = zclFrame.commandId() == TY_DATA_REPORT ? "REPORT" : "RESPONSE";
+
+            for (unsigned i = 0; i < tf.frame.count; i++)
+            {
+                const TY_Datapoint &dp = tf.frame.dp[i];
+                DBG_Printf(DBG_INFO, "TY_DATA_%s: seq %u, dpid: 0x%02X, type: 0x%02X, length: %u, val: %d\n",
+                           rt, tf.frame.seq, dp.dpid, dp.type, dp.length, int(dp.value));
+            }
+        }
+    }
+
+    return tf.frame;
+}
+
 /*! A generic function to parse Tuya private cluster values from response/report commands.
     The item->parseParameters() is expected to be an object (given in the device description file).
 
@@ -730,99 +863,59 @@ bool parseTuyaData(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndicat
         item->setZclProperties(param);
     }
 
-    quint16 seq;
-    quint8 dpid;
-    quint8 dataType;
-    quint16 dataLength;
-    quint8 zclDataType = 0;
     const auto &zclParam = item->zclParam();
+    const TY_Frame &frame = DA_GetTuyaFrame(zclFrame);
 
-    QDataStream stream(zclFrame.payload());
-    stream.setByteOrder(QDataStream::BigEndian); // tuya is big endian!
-
-    stream >> seq;
-
-    int attrIndex = 0;
-    while (!stream.atEnd()) // a message can contain multiple datapoints
+    // only the datapoints of this item, a message can contain multiple datapoints
+    for (const TY_Datapoint *dp = TY_FindDatapoint(frame, uint8_t(zclParam.attributes[0]), 0); dp;
+         dp = TY_FindDatapoint(frame, dp->dpid, dp->index + 1U))
     {
-        stream >> dpid;
-        stream >> dataType;
-        stream >> dataLength;
+        quint8 zclDataType = 0;
 
-        if (stream.status() != QDataStream::Ok)
+        switch (dp->type)
         {
-            return result;
-        }
-
-        deCONZ::NumericUnion num;
-        num.u64 = 0;
-
-        switch (dataType)
-        {
-        case TuyaDataTypeRaw:
-        {
-            // Not setting value because need to much ressource.
-            zclDataType = deCONZ::ZclCharacterString;
-        }
-        break;
-            
-        case TuyaDataTypeString:
-            return result; // TODO implement?
-
-        case TuyaDataTypeBool:
-        { stream >> num.u8; zclDataType = deCONZ::ZclBoolean; }
-            break;
-
-        case TuyaDataTypeEnum:
-        { stream >> num.u8; zclDataType = deCONZ::Zcl8BitUint; }
-            break;
-
-        case TuyaDataTypeValue: // docs aren't clear, assume signed
-        {  stream >> num.s32; zclDataType = deCONZ::Zcl32BitInt; }
-            break;
+        case TuyaDataTypeRaw: zclDataType = deCONZ::ZclCharacterString; break; // value isn't set, needs too much resources
+        case TuyaDataTypeBool: zclDataType = deCONZ::ZclBoolean; break;
+        case TuyaDataTypeEnum: zclDataType = deCONZ::Zcl8BitUint; break;
+        case TuyaDataTypeValue: zclDataType = deCONZ::Zcl32BitInt; break; // docs aren't clear, assume signed
 
         case TuyaDataTypeBitmap:
         {
-            switch (dataLength)
+            switch (dp->length)
             {
-            case 1: { stream >> num.u8;  zclDataType = deCONZ::Zcl8BitUint; } break;
-            case 2: { stream >> num.u16; zclDataType = deCONZ::Zcl16BitUint; } break;
-            case 4: { stream >> num.u32; zclDataType = deCONZ::Zcl32BitUint; } break;
+            case 1: zclDataType = deCONZ::Zcl8BitUint; break;
+            case 2: zclDataType = deCONZ::Zcl16BitUint; break;
+            case 4: zclDataType = deCONZ::Zcl32BitUint; break;
             }
         }
             break;
 
-        default:
-            return result; // unkown datatype
+        default: // string (TODO implement?) and unknown datatypes
+            break;
         }
 
-        if (dpid == zclParam.attributes[0])
+        if (zclDataType == 0 || (zclDataType != deCONZ::ZclCharacterString && !dp->hasValue))
         {
-            // map datapoint into ZCL attribute
-            deCONZ::ZclAttribute attr(dpid, zclDataType, QLatin1String(""), deCONZ::ZclReadWrite, true);
-
-            if (zclDataType == deCONZ::Zcl32BitInt)
-            {
-                attr.setValue(qint64(num.s32));
-            }
-            else
-            {
-                attr.setValue(quint64(num.u32));
-            }
-
-            if (evalZclAttribute(r, item, ind, zclFrame, attrIndex, attr, parseParameters))
-            {
-                item->setLastZclReport(deCONZ::steadyTimeRef().ref);
-                result = true;
-            }
+            continue;
         }
 
-        attrIndex++;
+        // map datapoint into ZCL attribute
+        deCONZ::ZclAttribute attr(dp->dpid, zclDataType, QLatin1String(""), deCONZ::ZclReadWrite, true);
 
-        const char *rt = zclFrame.commandId() == TY_DATA_REPORT ? "REPORT" : "RESPONSE";
+        if (zclDataType == deCONZ::Zcl32BitInt)
+        {
+            attr.setValue(qint64(dp->value));
+        }
+        else
+        {
+            attr.setValue(quint64(dp->value));
+        }
 
-        DBG_Printf(DBG_INFO, "TY_DATA_%s: seq %u, dpid: 0x%02X, type: 0x%02X, length: %u, val: %d\n",
-                   rt, seq, dpid, dataType, dataLength, num.s32);
+        if (evalZclAttribute(r, item, ind, zclFrame, dp->index, attr, parseParameters))
+        {
+            item->setLastZclReport(deCONZ::steadyTimeRef().ref);
+            result = true;
+        }
     }
 
     return result;
@@ -1090,8 +1183,21 @@ bool writeTuyaData(const Resource *r, const ResourceItem *item, deCONZ::ApsContr
     return result;
 }
 
+/*! Tagged values of the Xiaomi special attribute in the last report, shared by all items which parse it.
+ */
+struct DA_XiaomiFrame
+{
+    QByteArray payload;
+    uint16_t attrId = 0;
+    std::vector<ZCL_AttributeRecord> tags;
+};
+
+static DA_XiaomiFrame _DA_XiaomiFrame;
+
 /*! Extracts manufacturer specific Xiaomi ZCL attribute from report commands to basic cluster.
 
+    The special attribute is indexed once per frame, further calls for other tags only decode the requested value.
+
     \param zclFrame - Contains the special report with attribute 0xff01, 0xff02 or 0x00f7.
     \param rtag - The tag or struct index of the attribute to return.
     \returns Parsed attribute, use attr.id() != 0xffff to check for valid result.
@@ -1099,84 +1205,32 @@ bool writeTuyaData(const Resource *r, const ResourceItem *item, deCONZ::ApsContr
 deCONZ::ZclAttribute parseXiaomiZclTag(const quint8 rtag, const deCONZ::ZclFrame &zclFrame)
 {
     deCONZ::ZclAttribute result;
+    DA_XiaomiFrame &frame = _DA_XiaomiFrame;
 
-    quint16 attrId = 0;
-    quint8 dataType = 0;
-    quint8 length = 0;
-    quint16 structElements = 0;
-
-    QDataStream stream(zclFrame.payload());
-    stream.setByteOrder(QDataStream::LittleEndian);
-    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-    while (attrId == 0 && !stream.atEnd())
+    if (frame.payload != zclFrame.payload())
     {
-        quint16 a;
-        stream >> a;
-        stream >> dataType;
-
-        if (dataType == deCONZ::ZclCharacterString || dataType == deCONZ::ZclOctedString)
-        {
-            stream >> length;
-        }
-
-        if (a == 0xff01 && dataType == deCONZ::ZclCharacterString)
-        {
-            attrId = a;
-        }
-        else if (a == 0xff02 && dataType == 0x4c /*deCONZ::ZclStruct*/)
-        {
-            attrId = a;
-            stream >> structElements;
-        }
-        else if (a == 0x00f7 && dataType == deCONZ::ZclOctedString)
-        {
-            attrId = a;
-        }
-
-        if (dataType == deCONZ::ZclCharacterString && attrId != 0xff01)
-        {
-            for (; length > 0; length--) // skip string attribute
-            {
-                quint8 dummy;
-                stream >> dummy;
-            }
-        }
+        frame.payload = zclFrame.payload();
+        ZCL_IndexXiaomiTags(reinterpret_cast<const uint8_t*>(frame.payload.constData()), size_t(frame.payload.size()), &frame.attrId, &frame.tags);
     }
 
-    if (stream.atEnd() || attrId == 0)
+    for (const ZCL_AttributeRecord &tag : frame.tags)
     {
-        return result;
-    }
-
-    quint8 tag = 0;
-
-    while (!stream.atEnd())
-    {
-        if (attrId == 0xff01 || attrId == 0x00f7)
+        if (tag.id != rtag)
         {
-            stream >> tag;
+            continue;
         }
 
-        stream >> dataType;
-
-        deCONZ::ZclAttribute atmp(tag, dataType, QLatin1String(""), deCONZ::ZclRead, true);
+        QDataStream stream(QByteArray::fromRawData(frame.payload.constData() + tag.offset, tag.size));
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-        if (!atmp.readFromStream(stream))
-        {
-            return result;
-        }
+        deCONZ::ZclAttribute atmp(rtag, tag.dataType, QLatin1String(""), deCONZ::ZclRead, true);
 
-        if (tag == rtag)
+        if (atmp.readFromStream(stream))
         {
             result = atmp;
-            break;
-        }
-
-        if (structElements > 0)
-        {
-            tag++; // running struct index
         }
+        break;
     }
 
     return result;
@@ -1636,7 +1690,7 @@ bool parseAndSyncTime(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndi
                     {
                         // Check if drift got eliminated
                         const auto &ddfItem = DDF_GetItem(item);
-                        const auto readFunction = DA_GetReadFunction(ddfItem.readParameters);
+                        const auto readFunction = ddfItem.params.readFunction;
                         auto res = readFunction(r, item, apsCtrl, ddfItem.readParameters);
 
                         if (res.isEnqueued)
@@ -1718,44 +1772,94 @@ bool parseAndSyncTime(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndi
  */
 static DA_ReadResult readZclAttribute(const Resource *r, const ResourceItem *item, deCONZ::ApsController *apsCtrl, const QVariant &readParameters)
 {
-    Q_UNUSED(item)
-
-    DA_ReadResult result{};
-
     Q_ASSERT(!readParameters.isNull());
     if (readParameters.isNull())
     {
-        return result;
+        return {};
     }
 
-    auto *rTop = r->parentResource() ? r->parentResource() : r;
+    const DA_ItemParams *params = DA_GetItemParams(item);
+    const auto param = params ? DA_ResolveZclReadParam(r, params->readZcl) : DA_GetZclReadParam(r, readParameters);
 
-    const auto *extAddr = rTop->item(RAttrExtAddress);
-    const auto *nwkAddr = rTop->item(RAttrNwkAddress);
+    if (!param.valid)
+    {
+        return {};
+    }
 
-    if (!extAddr || !nwkAddr)
+    return DA_ReadZclAttributes(r, param, apsCtrl);
+}
+
+/*! Returns the ZCL_Param of a "zcl:attr" read function with the endpoint already resolved.
+    The result is invalid for other read functions or if the endpoint can't be resolved.
+ */
+ZCL_Param DA_GetZclReadParam(const Resource *r, const QVariant &readParameters)
+{
+    ZCL_Param result{};
+
+    if (readParameters.type() != QVariant::Map)
     {
         return result;
     }
 
-    auto param = getZclParam(readParameters.toMap());
+    const auto map = readParameters.toMap();
+    const auto fn = map.value(QLatin1String("fn")).toString();
 
-    if (!param.valid)
+    if (!fn.isEmpty() && fn != QLatin1String("zcl:attr") && fn != QLatin1String("zcl"))
     {
         return result;
     }
 
-    if (param.endpoint == AutoEndpoint)
+    return DA_ResolveZclReadParam(r, getZclParam(map));
+}
+
+/*! Resolves the endpoint of the pre-decoded "zcl:attr" read parameters \p param for resource \p r.
+    The result is invalid if \p param is invalid or the endpoint can't be resolved.
+ */
+ZCL_Param DA_ResolveZclReadParam(const Resource *r, ZCL_Param param)
+{
+    ZCL_Param result{};
+
+    const auto *rTop = r->parentResource() ? r->parentResource() : r;
+    const auto *extAddr = rTop->item(RAttrExtAddress);
+
+    if (!extAddr)
     {
-        param.endpoint = resolveAutoEndpoint(r);
-        param.endpoint = DEV_ResolveDestinationEndpoint(extAddr->toNumber(), param.endpoint, param.clusterId, param.frameControl);
+        return result;
+    }
 
-        if (param.endpoint == AutoEndpoint)
+    result = param;
+
+    if (result.valid && result.endpoint == AutoEndpoint)
+    {
+        result.endpoint = resolveAutoEndpoint(r);
+        result.endpoint = DEV_ResolveDestinationEndpoint(extAddr->toNumber(), result.endpoint, result.clusterId, result.frameControl);
+
+        if (result.endpoint == AutoEndpoint)
         {
-            return result;
+            result.valid = 0;
         }
     }
 
+    return result;
+}
+
+/*! Sends a ZCL Read Attributes request for all attributes in \p param.
+    \p param must be resolved via DA_GetZclReadParam().
+ */
+DA_ReadResult DA_ReadZclAttributes(const Resource *r, const ZCL_Param &param, deCONZ::ApsController *apsCtrl)
+{
+    DA_ReadResult result{};
+
+    const auto *rTop = r->parentResource() ? r->parentResource() : r;
+
+    const auto *extAddr = rTop->item(RAttrExtAddress);
+    const auto *nwkAddr = rTop->item(RAttrNwkAddress);
+
+    if (!extAddr || !nwkAddr || !param.valid)
+    {
+        return result;
+    }
+
     const auto zclResult = ZCL_ReadAttributes(param, extAddr->toNumber(), nwkAddr->toNumber(), apsCtrl);
 
     result.isEnqueued = zclResult.isEnqueued;
@@ -2022,6 +2126,56 @@ ParseFunction_t DA_GetParseFunction(const QVariant &params)
     return result;
 }
 
+/*! Returns the clusters and endpoint \p fn checks before it parses a frame.
+    Functions which don't depend on the cluster match any indication.
+ */
+DA_ParseFilter DA_GetParseFilter(const Resource *r, const DA_ItemParams &params)
+{
+    DA_ParseFilter result{};
+    result.endpoint = BroadcastEndpoint;
+
+    const ParseFunction_t fn = params.parseFunction;
+
+    if (fn == parseZclAttribute)
+    {
+        const ZCL_Param &param = params.parseZcl;
+        if (param.valid)
+        {
+            result.clusters[0] = param.clusterId;
+            result.clusterCount = 1;
+            result.endpoint = param.endpoint == AutoEndpoint ? resolveAutoEndpoint(r) : param.endpoint;
+
+            if (result.endpoint == AutoEndpoint)
+            {
+                result.endpoint = BroadcastEndpoint;
+            }
+        }
+    }
+    else if (fn == parseXiaomiSpecial)
+    {
+        result.clusters[0] = 0x0000;
+        result.clusters[1] = 0xfcc0;
+        result.clusterCount = 2;
+    }
+    else if (fn == parseIasZoneNotificationAndStatus)
+    {
+        result.clusters[0] = IAS_ZONE_CLUSTER_ID;
+        result.clusterCount = 1;
+    }
+    else if (fn == parseTuyaData)
+    {
+        result.clusters[0] = TUYA_CLUSTER_ID;
+        result.clusterCount = 1;
+    }
+    else if (fn == parseAndSyncTime)
+    {
+        result.clusters[0] = TIME_CLUSTER_ID;
+        result.clusterCount = 1;
+    }
+
+    return result;
+}
+
 ReadFunction_t DA_GetReadFunction(const QVariant &params)
 {
     ReadFunction_t result = nullptr;
@@ -2104,6 +2258,35 @@ WriteFunction_t DA_GetWriteFunction(const QVariant &params)
     return result;
 }
 
+/*! Decodes the DDF item parameters into \p params, called once when a DDF is loaded.
+ */
+void DA_DecodeItemParams(const QVariant &parseParameters, const QVariant &readParameters, const QVariant &writeParameters, DA_ItemParams *params)
+{
+    *params = {};
+
+    params->parseFunction = DA_GetParseFunction(parseParameters);
+    params->readFunction = DA_GetReadFunction(readParameters);
+    params->writeFunction = DA_GetWriteFunction(writeParameters);
+
+    const auto parseMap = parseParameters.toMap();
+    params->parseEval = parseMap.value(QLatin1String("eval")).toString();
+
+    if (params->parseFunction == parseZclAttribute)
+    {
+        params->parseZcl = getZclParam(parseMap);
+    }
+
+    const auto readMap = readParameters.toMap();
+    const auto readFn = readMap.value(QLatin1String("fn")).toString();
+
+    params->hasRead = !readMap.isEmpty() && readFn != QLatin1String("none");
+
+    if (readFn.isEmpty() || readFn == QLatin1String("zcl:attr") || readFn == QLatin1String("zcl"))
+    {
+        params->readZcl = getZclParam(readMap);
+    }
+}
+
 /* APS core queue tracking
 
    Track the running APS queue to aid scheduling of new APS requests
@@ -2113,18 +2296,51 @@ WriteFunction_t DA_GetWriteFunction(const QVariant &params)
    without waiting for low priority APS request to be finished.
  */
 #define APS_BUSY_TABLE_SIZE 32
+#define APS_CONFIRM_TIMEOUT_MS (60 * 1000)
+#define APS_USER_HOLD_OFF_MS 750
+#define APS_BG_TOKENS_PER_SECOND 8
+#define APS_BG_TOKENS_MAX 8
 
 struct DA_ReqBusy
 {
-    uint64_t dstExtAddr;
-    int64_t tref;
+    uint64_t dstExtAddr; // 0 for group and broadcast requests
+    int64_t tref; // ms
+    uint32_t serial; // see DA_ApsEnqueueMark()
     uint16_t clusterId;
     uint8_t dstEndpoint;
     uint8_t apsRequestId;
+    uint8_t priority;
+};
+
+/*! Admission limits per priority lane.
+    \c maxUnconfirmed - the lane is admitted while fewer requests are in the core APS queue
+    \c maxPerNode - in-flight window per destination node
+ */
+struct DA_LaneLimits
+{
+    unsigned maxUnconfirmed;
+    unsigned maxPerNode;
+};
+
+static const DA_LaneLimits _DA_LaneLimits[DA_ApsPriorityMax] = {
+    { APS_BUSY_TABLE_SIZE - 4, 3 }, // DA_ApsPriorityUser
+    { 6, 2 },                       // DA_ApsPriorityNormal
+    { 4, 1 }                        // DA_ApsPriorityBackground
 };
 
 static unsigned _DA_ApsUnconfirmedCount = 0;
+static unsigned _DA_ApsUnconfirmedLane[DA_ApsPriorityMax] = {};
 static DA_ReqBusy _DA_BusyTable[APS_BUSY_TABLE_SIZE];
+static DA_ApsLaneStats _DA_LaneStats[DA_ApsPriorityMax];
+static int64_t _DA_UserHoldOffUntil = 0;
+static uint32_t _DA_EnqueueSerial = 0;
+static int64_t _DA_BgTokenTime = 0;
+static int _DA_BgTokens = APS_BG_TOKENS_MAX;
+
+static int64_t DA_NowMs()
+{
+    return deCONZ::steadyTimeRef().ref;
+}
 
 /*! Returns number of APS requests busy in the core APS queue. */
 unsigned DA_ApsUnconfirmedRequests()
@@ -2158,46 +2374,257 @@ unsigned DA_ApsUnconfirmedRequestsForExtAddress(uint64_t extAddr)
     return result;
 }
 
+/*! Returns the background tokens available at \p now without refilling the bucket. */
+static int DA_AvailableBackgroundTokens(int64_t now)
+{
+    if (_DA_BgTokenTime == 0 || now <= _DA_BgTokenTime)
+    {
+        return _DA_BgTokens;
+    }
+
+    const int64_t tokens = (now - _DA_BgTokenTime) * APS_BG_TOKENS_PER_SECOND / 1000;
+    return static_cast<int>(std::min<int64_t>(APS_BG_TOKENS_MAX, _DA_BgTokens + tokens));
+}
+
+/*! Refills the background token bucket according to the elapsed time. */
+static void DA_RefillBackgroundTokens(int64_t now)
+{
+    if (_DA_BgTokenTime == 0)
+    {
+        _DA_BgTokenTime = now;
+        return;
+    }
+
+    const int64_t dt = now - _DA_BgTokenTime;
+    const int64_t tokens = dt * APS_BG_TOKENS_PER_SECOND / 1000;
+
+    if (tokens > 0)
+    {
+        _DA_BgTokens = static_cast<int>(std::min<int64_t>(APS_BG_TOKENS_MAX, _DA_BgTokens + tokens));
+        _DA_BgTokenTime += tokens * 1000 / APS_BG_TOKENS_PER_SECOND;
+    }
+    else if (dt < 0)
+    {
+        _DA_BgTokenTime = now;
+    }
+}
+
+/*! Admission control for outgoing APS requests.
+
+    Should be called before an APS request is sent, it has no side effects. Each priority
+    lane has a limit for the total number of unconfirmed requests in the core APS queue
+    and an in-flight window per destination node. Background traffic is further rate
+    limited by a token bucket and yields while user initiated requests are pending or
+    in flight. Once the request is enqueued DA_ApsAdmitted() must be called.
+
+    \param extAddr - destination node, or 0 for group and broadcast requests
+    \param priority - the lane of the request
+    \returns true if the request may be sent now
+ */
+bool DA_ApsCanAdmit(uint64_t extAddr, DA_ApsPriority priority)
+{
+    U_ASSERT(priority < DA_ApsPriorityMax);
+    if (priority >= DA_ApsPriorityMax)
+    {
+        priority = DA_ApsPriorityNormal;
+    }
+
+    const DA_LaneLimits &limits = _DA_LaneLimits[priority];
+
+    if (_DA_ApsUnconfirmedCount >= limits.maxUnconfirmed)
+    {
+        return false;
+    }
+
+    if (priority == DA_ApsPriorityBackground)
+    {
+        const int64_t now = DA_NowMs();
+
+        if (DA_AvailableBackgroundTokens(now) <= 0)
+        {
+            return false;
+        }
+
+        if (_DA_ApsUnconfirmedLane[DA_ApsPriorityUser] != 0 || now < _DA_UserHoldOffUntil)
+        {
+            return false;
+        }
+    }
+
+    if (extAddr != 0 && DA_ApsUnconfirmedRequestsForExtAddress(extAddr) >= limits.maxPerNode)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*! Returns a mark to be taken before APS requests are sent, see DA_ApsAdmitted(). */
+uint32_t DA_ApsEnqueueMark()
+{
+    return _DA_EnqueueSerial;
+}
+
+/*! Accounts the APS requests to \p extAddr which were enqueued after \p mark to the lane \p priority.
+
+    Should be called once requests admitted by DA_ApsCanAdmit() are enqueued. DA_ApsRequestEnqueued()
+    puts each request in the normal lane, here it is moved to the lane with which it was admitted.
+    Background requests consume a token.
+
+    \param extAddr - destination node, or 0 for group and broadcast requests
+    \param mark - the value of DA_ApsEnqueueMark() before the requests were sent
+ */
+void DA_ApsAdmitted(uint64_t extAddr, uint32_t mark, DA_ApsPriority priority)
+{
+    U_ASSERT(priority < DA_ApsPriorityMax);
+    if (priority >= DA_ApsPriorityMax)
+    {
+        priority = DA_ApsPriorityNormal;
+    }
+
+    _DA_LaneStats[priority].admitted++;
+
+    if (priority == DA_ApsPriorityBackground)
+    {
+        DA_RefillBackgroundTokens(DA_NowMs());
+        if (_DA_BgTokens > 0)
+        {
+            _DA_BgTokens--;
+        }
+    }
+
+    for (DA_ReqBusy &e : _DA_BusyTable)
+    {
+        if (e.tref == 0 || e.dstExtAddr != extAddr || int32_t(e.serial - mark) <= 0)
+        {
+            continue;
+        }
+
+        if (e.priority != priority && e.priority < DA_ApsPriorityMax)
+        {
+            if (_DA_ApsUnconfirmedLane[e.priority] > 0)
+            {
+                _DA_ApsUnconfirmedLane[e.priority]--;
+            }
+
+            if (_DA_LaneStats[e.priority].enqueued > 0)
+            {
+                _DA_LaneStats[e.priority].enqueued--;
+            }
+
+            e.priority = priority;
+            _DA_ApsUnconfirmedLane[priority]++;
+            _DA_LaneStats[priority].enqueued++;
+        }
+    }
+}
+
+/*! Signals that DA_ApsCanAdmit() deferred a user initiated request to \p extAddr.
+    Background traffic is held off for a short period to let it pass. Nothing is held off
+    when the in-flight window of the destination node is full, since background traffic
+    doesn't delay a busy or unreachable node.
+
+    \param extAddr - destination node, or 0 for group and broadcast requests
+ */
+void DA_ApsUserRequestPending(uint64_t extAddr)
+{
+    if (extAddr != 0 && DA_ApsUnconfirmedRequestsForExtAddress(extAddr) >= _DA_LaneLimits[DA_ApsPriorityUser].maxPerNode)
+    {
+        return;
+    }
+
+    _DA_UserHoldOffUntil = DA_NowMs() + APS_USER_HOLD_OFF_MS;
+}
+
+/*! Returns the statistics of a priority lane. */
+const DA_ApsLaneStats &DA_ApsGetLaneStats(DA_ApsPriority priority)
+{
+    U_ASSERT(priority < DA_ApsPriorityMax);
+    return _DA_LaneStats[priority < DA_ApsPriorityMax ? priority : DA_ApsPriorityNormal];
+}
+
+/*! Prints the lane statistics to the debug log. */
+void DA_ApsPrintLaneStats()
+{
+    static const char *laneNames[DA_ApsPriorityMax] = { "user", "normal", "background" };
+
+    for (int i = 0; i < DA_ApsPriorityMax; i++)
+    {
+        const DA_ApsLaneStats &s = _DA_LaneStats[i];
+        if (s.admitted == 0 && s.enqueued == 0)
+        {
+            continue;
+        }
+
+        DBG_Printf(DBG_DEV, "APS lane %s: admitted %u, enqueued %u, confirmed %u (timeout %u), in flight %u, avg confirm %lld ms, max confirm %lld ms\n",
+                   laneNames[i], s.admitted, s.enqueued, s.confirmed, s.timeouts, _DA_ApsUnconfirmedLane[i],
+                   (long long)(s.confirmed ? s.confirmTotalMs / s.confirmed : 0), (long long)s.confirmMaxMs);
+    }
+}
+
+static void DA_ReleaseBusyEntry(DA_ReqBusy *e)
+{
+    DBG_Assert(_DA_ApsUnconfirmedCount > 0);
+    if (_DA_ApsUnconfirmedCount > 0)
+    {
+        _DA_ApsUnconfirmedCount--;
+    }
+
+    if (e->priority < DA_ApsPriorityMax && _DA_ApsUnconfirmedLane[e->priority] > 0)
+    {
+        _DA_ApsUnconfirmedLane[e->priority]--;
+    }
+
+    memset(e, 0, sizeof(*e));
+}
+
 /*! Call back when an APS request is put in the core APS queue.
     Record it here to track it until it's confirmed aka done.
  */
 void DA_ApsRequestEnqueued(const deCONZ::ApsDataRequest &req)
 {
-    if (!req.dstAddress().hasExt())
+    if (!req.dstAddress().hasExt() && req.dstAddressMode() != deCONZ::ApsGroupAddress && req.dstAddress().isNwkUnicast())
     {
-        DBG_Assert(!req.dstAddress().isNwkUnicast());
-        return;
+        return; // can't be matched with the confirm
     }
 
-    const int64_t now = deCONZ::steadyTimeRef().ref / 1000;
+    const int64_t now = DA_NowMs();
+    const uint64_t extAddr = req.dstAddress().hasExt() ? req.dstAddress().ext() : 0;
 
     for (unsigned i = 0; i < APS_BUSY_TABLE_SIZE; i++)
     {
         DA_ReqBusy *e = &_DA_BusyTable[i];
 
-        if (e->tref != 0 && ((now - e->tref) > 60))
+        if (e->tref != 0 && ((now - e->tref) > APS_CONFIRM_TIMEOUT_MS))
         {
             // confirm timeout, should normally not happen
-            DBG_Assert(_DA_ApsUnconfirmedCount > 0);
-            if (_DA_ApsUnconfirmedCount > 0)
+            if (e->priority < DA_ApsPriorityMax)
             {
-                _DA_ApsUnconfirmedCount--;
+                _DA_LaneStats[e->priority].timeouts++;
             }
-            memset(e, 0, sizeof(*e));
+            DA_ReleaseBusyEntry(e);
         }
 
         if (e->tref == 0)
         {
-            e->dstExtAddr = req.dstAddress().ext();
+            const DA_ApsPriority priority = DA_ApsPriorityNormal; // moved by DA_ApsAdmitted()
+
+            _DA_EnqueueSerial++;
+            e->dstExtAddr = extAddr;
+            e->serial = _DA_EnqueueSerial;
             e->dstEndpoint = req.dstEndpoint();
             e->apsRequestId = req.id();
             e->clusterId = req.clusterId();
+            e->priority = priority;
             e->tref = now;
             DBG_Assert(_DA_ApsUnconfirmedCount < APS_BUSY_TABLE_SIZE);
             if (_DA_ApsUnconfirmedCount < APS_BUSY_TABLE_SIZE)
             {
                 _DA_ApsUnconfirmedCount++;
             }
+
+            _DA_ApsUnconfirmedLane[priority]++;
+            _DA_LaneStats[priority].enqueued++;
             return;
         }
     }
@@ -2209,22 +2636,28 @@ void DA_ApsRequestEnqueued(const deCONZ::ApsDataRequest &req)
  */
 void DA_ApsRequestConfirmed(const deCONZ::ApsDataConfirm &conf)
 {
-    if (!conf.dstAddress().hasExt())
-    {
-        return;
-    }
+    const uint64_t extAddr = conf.dstAddress().hasExt() ? conf.dstAddress().ext() : 0;
 
     if (_DA_ApsUnconfirmedCount != 0)
     {
         for (unsigned i = 0; i < APS_BUSY_TABLE_SIZE; i++)
         {
             DA_ReqBusy *e = &_DA_BusyTable[i];
+            if (e->tref == 0) continue;
             if (e->apsRequestId != conf.id()) continue;
-            if (e->dstExtAddr != conf.dstAddress().ext()) continue;
+            if (e->dstExtAddr != extAddr) continue;
             if (e->dstEndpoint != conf.dstEndpoint()) continue;
 
-            memset(e, 0, sizeof(*e));
-            _DA_ApsUnconfirmedCount--;
+            if (e->priority < DA_ApsPriorityMax)
+            {
+                DA_ApsLaneStats &stats = _DA_LaneStats[e->priority];
+                const int64_t dt = DA_NowMs() - e->tref;
+                stats.confirmed++;
+                stats.confirmTotalMs += dt;
+                stats.confirmMaxMs = std::max(stats.confirmMaxMs, dt);
+            }
+
+            DA_ReleaseBusyEntry(e);
             return;
         }
     }
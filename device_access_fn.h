@@ -14,6 +14,7 @@
 #include <QString>
 #include <QVariant>
 #include <vector>
+#include "zcl/zcl.h"
 
 class Resource;
 class ResourceItem;
@@ -35,19 +36,72 @@ struct DA_ReadResult
     quint16 clusterId = 0;
 };
 
+/*! Clusters and endpoint a parse function can match, used to skip items which can't parse an indication. */
+struct DA_ParseFilter
+{
+    uint16_t clusters[2];
+    uint8_t clusterCount = 0; //! 0: any cluster
+    uint8_t endpoint = 255; //! 255: any endpoint
+};
+
 typedef bool (*ParseFunction_t)(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndication &ind, const deCONZ::ZclFrame &zclFrame, const QVariant &parseParameters);
 typedef DA_ReadResult (*ReadFunction_t)(const Resource *r, const ResourceItem *item, deCONZ::ApsController *apsCtrl, const QVariant &readParameters);
 typedef bool (*WriteFunction_t)(const Resource *r, const ResourceItem *item, deCONZ::ApsController *apsCtrl, const QVariant &writeParameters);
 
+/*! Typed form of the DDF item "parse", "read" and "write" parameters.
+    Decoded once by DA_DecodeItemParams() when a DDF is loaded, so that parsing, reading
+    and writing doesn't need to look up keys in the QVariantMap for each frame.
+ */
+struct DA_ItemParams
+{
+    ParseFunction_t parseFunction = nullptr;
+    ReadFunction_t readFunction = nullptr;
+    WriteFunction_t writeFunction = nullptr;
+    ZCL_Param parseZcl{}; //! parseZclAttribute() parameters, endpoint not resolved
+    ZCL_Param readZcl{}; //! "zcl:attr" read parameters, endpoint not resolved
+    QString parseEval; //! Javascript expression of the parse parameters
+    bool hasRead = false; //! read parameters are present and not {"fn": "none"}
+};
+
 // temporary expose parseTuyaData for check in tuya.cpp
 bool parseTuyaData(Resource *r, ResourceItem *item, const deCONZ::ApsDataIndication &ind, const deCONZ::ZclFrame &zclFrame, const QVariant &parseParameters);
 ParseFunction_t DA_GetParseFunction(const QVariant &params);
+DA_ParseFilter DA_GetParseFilter(const Resource *r, const DA_ItemParams &params);
 ReadFunction_t DA_GetReadFunction(const QVariant &params);
 WriteFunction_t DA_GetWriteFunction(const QVariant &params);
+void DA_DecodeItemParams(const QVariant &parseParameters, const QVariant &readParameters, const QVariant &writeParameters, DA_ItemParams *params);
+ZCL_Param DA_GetZclReadParam(const Resource *r, const QVariant &readParameters);
+ZCL_Param DA_ResolveZclReadParam(const Resource *r, ZCL_Param param);
+DA_ReadResult DA_ReadZclAttributes(const Resource *r, const ZCL_Param &param, deCONZ::ApsController *apsCtrl);
+
+/*! Priority lanes for APS request admission, see DA_ApsCanAdmit(). */
+enum DA_ApsPriority
+{
+    DA_ApsPriorityUser = 0,       //!< user initiated commands
+    DA_ApsPriorityNormal = 1,     //!< verification reads, legacy tasks
+    DA_ApsPriorityBackground = 2, //!< polling and binding maintenance
+    DA_ApsPriorityMax = 3
+};
+
+struct DA_ApsLaneStats
+{
+    unsigned admitted = 0;
+    unsigned enqueued = 0;
+    unsigned confirmed = 0;
+    unsigned timeouts = 0;
+    int64_t confirmTotalMs = 0; //!< sum of enqueue to confirm times
+    int64_t confirmMaxMs = 0;
+};
 
 unsigned DA_ApsUnconfirmedRequests();
 unsigned DA_ApsUnconfirmedRequestsForExtAddress(uint64_t extAddr);
 void DA_ApsRequestEnqueued(const deCONZ::ApsDataRequest &req);
 void DA_ApsRequestConfirmed(const deCONZ::ApsDataConfirm &conf);
+bool DA_ApsCanAdmit(uint64_t extAddr, DA_ApsPriority priority);
+uint32_t DA_ApsEnqueueMark();
+void DA_ApsAdmitted(uint64_t extAddr, uint32_t mark, DA_ApsPriority priority);
+void DA_ApsUserRequestPending(uint64_t extAddr);
+const DA_ApsLaneStats &DA_ApsGetLaneStats(DA_ApsPriority priority);
+void DA_ApsPrintLaneStats();
 
 #endif // DEVICE_ACCESS_FN_H
@@ -357,6 +357,8 @@ bool DEV_InitDeviceFromDescription(Device *device, const DeviceDescription &ddf)
         device->addBinding(bnd);
     }
 
+    DEV_InvalidateDispatchIndex(device); // parse parameters might have changed
+
     return subCount == ddf.subDevices.size();
 }
 
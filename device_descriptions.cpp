@@ -163,6 +163,7 @@ static int DDF_MergeGenericBundleItems(DeviceDescription &ddf, DDF_ParseContext
 static int DDF_ProcessSignatures(DDF_ParseContext *pctx, std::vector<U_ECC_PublicKeySecp256k1> &publicKeys, U_BStream *bs, uint32_t *bundleHash);
 static DeviceDescription::Item *DDF_GetItemMutable(const ResourceItem *item);
 static void DDF_UpdateItemHandlesForIndex(std::vector<DeviceDescription> &descriptions, uint loadCounter, size_t index);
+static void DDF_DecodeItemParams(DeviceDescription::Item &item);
 static void DDF_TryCompileAndFixJavascript(QString *expr, const QString &path);
 DeviceDescription DDF_LoadScripts(const DeviceDescription &ddf);
 
@@ -1080,6 +1081,7 @@ void DDF_AnnoteZclParse1(int line, const char *file, const Resource *resource, R
                 param[QLatin1String("cppsrc")] = QLatin1String(buf);
 
                 ddfItem->parseParameters = param;
+                DDF_DecodeItemParams(*ddfItem);
 
                 DBG_Printf(DBG_DDF, "DDF %s:%d: %s updated ZCL function cl: 0x%04X, at: 0x%04X, eval: %s\n", fileName, line, qPrintable(resource->item(RAttrUniqueId)->toString()), clusterId, attributeId, eval);
             }
@@ -1838,6 +1840,14 @@ const std::vector<DDF_SubDeviceDescriptor> &DeviceDescriptions::getSubDevices()
     return d_ptr2->subDevices;
 }
 
+/*! Decodes the QVariant parse, read and write parameters of \p item into DeviceDescription::Item::params.
+    Needs to be called whenever one of the parameters changed.
+ */
+static void DDF_DecodeItemParams(DeviceDescription::Item &item)
+{
+    DA_DecodeItemParams(item.parseParameters, item.readParameters, item.writeParameters, &item.params);
+}
+
 static void DDF_UpdateItemHandlesForIndex(std::vector<DeviceDescription> &descriptions, uint loadCounter, size_t index)
 {
     U_ASSERT(index < descriptions.size());
@@ -1866,6 +1876,7 @@ static void DDF_UpdateItemHandlesForIndex(std::vector<DeviceDescription> &descri
         for (DeviceDescription::Item &item : sub.items)
         {
             item.handle = handle.handle;
+            DDF_DecodeItemParams(item);
             U_ASSERT(handle.item < HND_MAX_ITEMS);
             handle.item++;
         }
@@ -2125,6 +2136,7 @@ void DeviceDescriptions::readAllRawJson()
                             result.isGenericRead = !result.readParameters.isNull() ? 1 : 0;
                             result.isGenericWrite = !result.writeParameters.isNull() ? 1 : 0;
                             result.isGenericParse = !result.parseParameters.isNull() ? 1 : 0;
+                            DDF_DecodeItemParams(result);
 
                             size_t j = 0;
                             for (j = 0; j < d->genericItems.size(); j++)
@@ -2330,6 +2342,14 @@ void DeviceDescriptions::readAllRawJson()
         {
             ddf = DDF_MergeGenericItems(d->genericItems, ddf);
             ddf = DDF_LoadScripts(ddf);
+
+            for (auto &sub : ddf.subDevices)
+            {
+                for (auto &item : sub.items)
+                {
+                    DDF_DecodeItemParams(item);
+                }
+            }
         }
 
         DBG_Printf(DBG_DDF, "DDF loaded %d raw JSON DDFs\n", (int)d->descriptions.size());
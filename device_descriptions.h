@@ -13,6 +13,7 @@
 
 #include <QObject>
 #include <QVariantMap>
+#include "device_access_fn.h"
 #include "resource.h"
 #include "sensor.h"
 
@@ -176,6 +177,7 @@ public:
         QVariant parseParameters;
         QVariant readParameters;
         QVariant writeParameters;
+        DA_ItemParams params; // decoded parse, read and write parameters
         QVariant defaultValue;
         QString description;
     };
@@ -8,6 +8,7 @@
  *
  */
 
+#include <algorithm>
 #include <QElapsedTimer>
 #include <QTimer>
 #include <deconz/dbg_trace.h>
@@ -20,7 +21,9 @@
 #define TICK_INTERVAL_JOIN 500
 #define TICK_INTERVAL_IDLE 1000
 #define TICK_INTERVAL_IDLE_OTAU 6000
+#define TICK_INTERVAL_IDLE_FAST 20 // next tick after a device had nothing to poll
 #define TICK_INTERVAL_POLL_TIMOUT 10000
+#define TICK_BUDGET_MS 4 // max. time per tick to look for the next device
 
 extern int DEV_ApsQueueSize();
 extern bool DEV_OtauBusy();
@@ -46,10 +49,18 @@ public:
     DT_StateHandler stateHandler = DT_StateInit;
     std::vector<JoinDevice> joinDevices;
     deCONZ::SteadyTimeRef joinDisabledTime;
+    std::vector<DeviceKey> readyQueue; // devices which are polled before the round-robin walk
     DeviceTick *q = nullptr;
     QTimer *timer = nullptr;
     size_t devIter = 0;
     const DeviceContainer *devices = nullptr;
+    int nextIdleInterval = TICK_INTERVAL_IDLE;
+    // for metrics
+    DeviceTickStats stats;
+    QElapsedTimer pollTime;
+    QElapsedTimer roundTime;
+    QElapsedTimer timerStarted;
+    int timerInterval = 0;
     // for logging
     DeviceKey curDeviceKey = 0;
     bool curDeviceManaged = false;
@@ -78,6 +89,13 @@ DeviceTick::~DeviceTick()
     d = nullptr;
 }
 
+/*! Returns runtime statistics.
+ */
+const DeviceTickStats &DeviceTick::stats() const
+{
+    return d->stats;
+}
+
 /*! Public event entry.
  */
 void DeviceTick::handleEvent(const Event &event)
@@ -89,6 +107,12 @@ void DeviceTick::handleEvent(const Event &event)
  */
 void DeviceTick::timoutFired()
 {
+    if (d->timerStarted.isValid())
+    {
+        const auto latency = d->timerStarted.elapsed() - d->timerInterval;
+        d->stats.tickMaxLatencyMs = std::max(d->stats.tickMaxLatencyMs, int64_t(latency));
+    }
+
     d->stateHandler(d, Event(RLocal, REventStateTimeout, 0));
 }
 
@@ -109,6 +133,8 @@ static void DT_SetState(DeviceTickPrivate *d, DT_StateHandler state)
  */
 static void DT_StartTimer(DeviceTickPrivate *d, int timeoutMs)
 {
+    d->timerInterval = timeoutMs;
+    d->timerStarted.start();
     d->timer->start(timeoutMs);
 }
 
@@ -130,7 +156,57 @@ static void DT_StateInit(DeviceTickPrivate *d, const Event &event)
     }
 }
 
+/*! Adds a device to the ready queue if not already present.
+ */
+static void DT_EnqueueReadyDevice(DeviceTickPrivate *d, DeviceKey deviceKey)
+{
+    if (deviceKey == 0)
+    {
+        return;
+    }
+
+    const auto i = std::find(d->readyQueue.cbegin(), d->readyQueue.cend(), deviceKey);
+
+    if (i == d->readyQueue.cend())
+    {
+        d->readyQueue.push_back(deviceKey);
+    }
+}
+
+/*! Emits REventPoll to \p device.
+ */
+static void DT_PollDevice(DeviceTickPrivate *d, const Device *device)
+{
+    d->curDeviceKey = device->key();
+    d->curDeviceManaged = device->managed();
+    d->stats.polls++;
+    d->pollTime.start();
+    emit d->q->eventNotify(Event(device->prefix(), REventPoll, 0, device->key()));
+}
+
+/*! Called when DT_PollNextIdleDevice() wrapped around all devices.
+ */
+static void DT_RoundDone(DeviceTickPrivate *d)
+{
+    if (d->roundTime.isValid())
+    {
+        d->stats.rounds++;
+        d->stats.lastRoundMs = d->roundTime.elapsed();
+
+        DBG_Printf(DBG_DEV, "DEV Tick: round %llu done in %lld ms, polls: %llu (idle %llu, timeout %llu), max poll: %lld ms, max tick latency: %lld ms\n",
+                   (unsigned long long)d->stats.rounds, (long long)d->stats.lastRoundMs,
+                   (unsigned long long)d->stats.polls, (unsigned long long)d->stats.pollsIdle, (unsigned long long)d->stats.pollTimeouts,
+                   (long long)d->stats.pollMaxMs, (long long)d->stats.tickMaxLatencyMs);
+        DA_ApsPrintLaneStats();
+    }
+
+    d->roundTime.start();
+}
+
 /*! Emits REventPoll to the next device in DT_StateIdle.
+
+    Devices in the ready queue are processed first, then the round-robin walk continues.
+    Not reachable devices are skipped until TICK_BUDGET_MS is exhausted.
  */
 static bool DT_PollNextIdleDevice(DeviceTickPrivate *d)
 {
@@ -141,18 +217,50 @@ static bool DT_PollNextIdleDevice(DeviceTickPrivate *d)
         return false;
     }
 
-    d->devIter %= devCount;
+    while (!d->readyQueue.empty())
+    {
+        const DeviceKey deviceKey = d->readyQueue.front();
+        d->readyQueue.erase(d->readyQueue.begin());
 
-    const auto &device = d->devices->at(d->devIter);
-    d->devIter++;
-    Q_ASSERT(device);
+        const auto i = std::find_if(d->devices->cbegin(), d->devices->cend(), [deviceKey](const auto &device)
+        {
+            return device->key() == deviceKey;
+        });
 
-    if (device->reachable())
+        if (i != d->devices->cend() && (*i)->reachable())
+        {
+            DT_PollDevice(d, i->get());
+            return true;
+        }
+    }
+
+    QElapsedTimer budget;
+    budget.start();
+
+    for (size_t n = 0; n < devCount; n++)
     {
-        d->curDeviceKey = device->key();
-        d->curDeviceManaged = device->managed();
-        emit d->q->eventNotify(Event(device->prefix(), REventPoll, 0, device->key()));
-        return true;
+        if (d->devIter >= devCount)
+        {
+            d->devIter = 0;
+            DT_RoundDone(d);
+        }
+
+        const auto &device = d->devices->at(d->devIter);
+        d->devIter++;
+        Q_ASSERT(device);
+
+        if (device->reachable())
+        {
+            DT_PollDevice(d, device.get());
+            return true;
+        }
+
+        d->stats.skipped++;
+
+        if (budget.elapsed() >= TICK_BUDGET_MS)
+        {
+            break;
+        }
     }
 
     return false;
@@ -169,6 +277,10 @@ static void DT_StateIdle(DeviceTickPrivate *d, const Event &event)
     {
         DT_SetState(d, DT_StateJoin);
     }
+    else if (event.what() == REventDeviceAnnounce)
+    {
+        DT_EnqueueReadyDevice(d, event.deviceKey());
+    }
     else if (event.resource() == RLocal)
     {
         if (event.what() == REventStateTimeout)
@@ -186,7 +298,8 @@ static void DT_StateIdle(DeviceTickPrivate *d, const Event &event)
         }
         else if (event.what() == REventStateEnter)
         {
-            DT_StartTimer(d, TICK_INTERVAL_IDLE);
+            DT_StartTimer(d, d->nextIdleInterval);
+            d->nextIdleInterval = TICK_INTERVAL_IDLE;
         }
         else if (event.what() == REventStateLeave)
         {
@@ -195,6 +308,31 @@ static void DT_StateIdle(DeviceTickPrivate *d, const Event &event)
     }
 }
 
+/*! Updates poll statistics and the spacing to the next tick when a poll has finished.
+    A device signals with REventPollDone num = 0 that it had nothing to poll.
+ */
+static void DT_PollFinished(DeviceTickPrivate *d, const Event &event)
+{
+    const auto dt = d->pollTime.isValid() ? d->pollTime.elapsed() : 0;
+    d->stats.pollMaxMs = std::max(d->stats.pollMaxMs, int64_t(dt));
+    d->stats.pollTotalMs += dt;
+
+    if (event.resource() == RLocal)
+    {
+        d->stats.pollTimeouts++;
+        d->nextIdleInterval = TICK_INTERVAL_IDLE;
+    }
+    else if (event.num() == 0)
+    {
+        d->stats.pollsIdle++;
+        d->nextIdleInterval = TICK_INTERVAL_IDLE_FAST;
+    }
+    else
+    {
+        d->nextIdleInterval = DEV_OtauBusy() ? TICK_INTERVAL_IDLE_OTAU : TICK_INTERVAL_IDLE;
+    }
+}
+
 /*! Wait for poll state to finish either by timeout or device signaling that nothing needs to be polled.
  */
 static void DT_StatePoll(DeviceTickPrivate *d, const Event &event)
@@ -207,6 +345,7 @@ static void DT_StatePoll(DeviceTickPrivate *d, const Event &event)
     {
         if (event.what() == REventStateTimeout)
         {
+            DT_PollFinished(d, event);
             DT_SetState(d, DT_StateIdle);
         }
         else if (event.what() == REventStateEnter)
@@ -220,9 +359,14 @@ static void DT_StatePoll(DeviceTickPrivate *d, const Event &event)
             DT_StopTimer(d);
         }
     }
-    else if (event.resource() == RDevices && event.what() == REventPollDone)
+    else if (event.what() == REventDeviceAnnounce)
+    {
+        DT_EnqueueReadyDevice(d, event.deviceKey());
+    }
+    else if (event.resource() == RDevices && event.what() == REventPollDone && event.deviceKey() == d->curDeviceKey)
     {
-        DBG_Printf(DBG_DEV, "DEV Tick: poll done " FMT_MAC "\n", FMT_MAC_CAST(d->curDeviceKey));
+        DBG_Printf(DBG_DEV, "DEV Tick: poll done " FMT_MAC ", %lld ms\n", FMT_MAC_CAST(d->curDeviceKey), (long long)d->pollTime.elapsed());
+        DT_PollFinished(d, event);
         DT_SetState(d, DT_StateIdle);
     }
 }
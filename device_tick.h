@@ -19,6 +19,21 @@ class Device;
 
 class DeviceTickPrivate;
 
+/*! Runtime statistics of DeviceTick, available via GET /api/<apikey>/config/metrics.
+ */
+struct DeviceTickStats
+{
+    uint64_t polls = 0;          //! REventPoll emitted
+    uint64_t pollsIdle = 0;      //! REventPollDone received without the device doing any work
+    uint64_t pollTimeouts = 0;   //! polls which ended by TICK_INTERVAL_POLL_TIMOUT
+    uint64_t skipped = 0;        //! not reachable devices skipped
+    uint64_t rounds = 0;         //! completed walks over all devices
+    int64_t pollMaxMs = 0;       //! max. duration of a single device poll
+    int64_t pollTotalMs = 0;     //! summed duration of all device polls
+    int64_t tickMaxLatencyMs = 0; //! max. delay of a timer tick compared to its schedule
+    int64_t lastRoundMs = 0;     //! duration of the last completed round
+};
+
 
 /*! \class DeviceTick
 
@@ -27,6 +42,12 @@ class DeviceTickPrivate;
     It differentiates between normal idle operation and device pairing while
     Permit Join is enabled. While during pairing a faster pace is applied.
 
+    In idle operation each timer tick has a small time budget in which not reachable
+    devices are skipped, so they don't cost a full tick each. Devices which were
+    announced are queued in a ready queue and polled before the round-robin walk.
+    When a device had nothing to poll the next tick follows quickly, the normal
+    TICK_INTERVAL_IDLE spacing only applies after a device actually sent requests.
+
     TODO
 
     Take task queue and APS-DATA.request queue into account.
@@ -38,6 +59,7 @@ class DeviceTick : public QObject
 public:
     explicit DeviceTick(const DeviceContainer &devices, QObject *parent = nullptr);
     ~DeviceTick();
+    const DeviceTickStats &stats() const;
 
 Q_SIGNALS:
     void eventNotify(const Event&); //! Emitted \p Event needs to be enqueued in a higher layer.
@@ -48,6 +48,7 @@ Event::Event()
     m_numPrev = 0;
     m_hasData = 0;
     m_urgent = 0;
+    m_inChangeSet = 0;
 }
 
 Event::Event(const char *resource, const char *what, const QString &id, ResourceItem *item, DeviceKey deviceKey) :
@@ -58,7 +59,8 @@ Event::Event(const char *resource, const char *what, const QString &id, Resource
     m_numPrev(0),
     m_deviceKey(deviceKey),
     m_hasData(0),
-    m_urgent(0)
+    m_urgent(0),
+    m_inChangeSet(0)
 {
     DBG_Assert(item != 0);
     if (item)
@@ -78,7 +80,8 @@ Event::Event(const char *resource, const char *what, const QString &id, DeviceKe
     m_numPrev(0),
     m_deviceKey(deviceKey),
     m_hasData(0),
-    m_urgent(0)
+    m_urgent(0),
+    m_inChangeSet(0)
 {
 
 }
@@ -93,7 +96,8 @@ Event::Event(const char *resource, const char *what, const QString &id, int num,
     m_numPrev(0),
     m_deviceKey(deviceKey),
     m_hasData(0),
-    m_urgent(0)
+    m_urgent(0),
+    m_inChangeSet(0)
 {
 
 }
@@ -107,7 +111,8 @@ Event::Event(const char *resource, const char *what, int num, DeviceKey deviceKe
     m_numPrev(0),
     m_deviceKey(deviceKey),
     m_hasData(0),
-    m_urgent(0)
+    m_urgent(0),
+    m_inChangeSet(0)
 {
     if (resource == RGroups)
     {
@@ -120,7 +125,8 @@ Event::Event(const char *resource, const char *what, const void *data, size_t si
     m_what(what),
     m_deviceKey(deviceKey),
     m_hasData(1),
-    m_urgent(0)
+    m_urgent(0),
+    m_inChangeSet(0)
 {
     Q_ASSERT(data);
     Q_ASSERT(size > 0 && size <= MaxEventDataSize);
@@ -32,6 +32,9 @@ public:
     bool getData(void *dst, size_t size) const;
     bool isUrgent() const { return m_urgent == 1; }
     void setUrgent(bool urgent) { m_urgent = urgent ? 1 : 0; }
+    //! True for item events whose websocket push is done by the REventChanged event of the same resource.
+    bool isInChangeSet() const { return m_inChangeSet == 1; }
+    void setInChangeSet(bool inChangeSet) { m_inChangeSet = inChangeSet ? 1 : 0; }
 
 private:
     const char *m_resource = nullptr;
@@ -57,7 +60,8 @@ private:
     {
         unsigned char m_hasData : 1;
         unsigned char m_urgent : 1;
-        unsigned char _pad : 6;
+        unsigned char m_inChangeSet : 1;
+        unsigned char _pad : 5;
     };
 };
 
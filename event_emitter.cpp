@@ -13,6 +13,7 @@
 #include "event_emitter.h"
 #include "rest_node_base.h"
 #include "de_web_plugin_private.h"
+#include "utils/latency.h"
 
 static EventEmitter *instance_ = nullptr;
 
@@ -28,6 +29,7 @@ static bool isDuplicate(size_t pos, const std::vector<Event> &queue, const Event
         if (e.num() != x.num()) continue;
         if (e.id() != x.id()) continue;
         if (e.hasData() != x.hasData()) continue;
+        if (e.isInChangeSet() != x.isInChangeSet()) continue;
         if (e.hasData() && e.dataSize() != x.dataSize()) continue;
 
         return true;
@@ -52,6 +54,7 @@ EventEmitter::EventEmitter(QObject *parent) :
 
 void EventEmitter::enqueueEvent(const Event &event)
 {
+    const int64_t startUs = LAT_NowUs();
     RestNodeBase *restNode = nullptr;
 
     // workaround to attach DeviceKey to an event
@@ -97,6 +100,8 @@ void EventEmitter::enqueueEvent(const Event &event)
     {
         m_timer->start();
     }
+
+    LAT_Record(LAT_StageEventEnqueue, startUs);
 }
 
 EventEmitter::~EventEmitter()
@@ -42,6 +42,19 @@
 #define AES_BLOCK_SIZE 16
 
 
+#define GP_KEY_CACHE_SIZE 8
+
+/*! Recently decrypted keys, GPDs repeat the commissioning frame several times. */
+struct GP_KeyCacheEntry
+{
+    quint32 sourceID;
+    GpKey_t securityKey;
+    GpKey_t key;
+};
+
+static std::array<GP_KeyCacheEntry, GP_KEY_CACHE_SIZE> gpKeyCache{};
+static size_t gpKeyCacheCount = 0; // total number of inserted entries
+
 // From https://github.com/Koenkk/zigbee-herdsman/blob/master/src/controller/greenPower.ts
 /*!
  */
@@ -49,6 +62,14 @@ GpKey_t GP_DecryptSecurityKey(quint32 sourceID, const GpKey_t &securityKey)
 {
     GpKey_t result = { 0 };
 
+    for (size_t i = 0; i < gpKeyCacheCount && i < gpKeyCache.size(); i++)
+    {
+        if (gpKeyCache[i].sourceID == sourceID && gpKeyCache[i].securityKey == securityKey)
+        {
+            return gpKeyCache[i].key;
+        }
+    }
+
 #ifdef HAS_RECENT_OPENSSL
     void *libCrypto = nullptr;
     void *libSsl = nullptr;
@@ -134,6 +155,14 @@ GpKey_t GP_DecryptSecurityKey(quint32 sourceID, const GpKey_t &securityKey)
 
     std::copy(encryptBuf.begin(), encryptBuf.begin() + result.size(), result.begin());
 
+    { // replace the oldest entry
+        GP_KeyCacheEntry &entry = gpKeyCache[gpKeyCacheCount % gpKeyCache.size()];
+        entry.sourceID = sourceID;
+        entry.securityKey = securityKey;
+        entry.key = result;
+        gpKeyCacheCount++;
+    }
+
 #else
     Q_UNUSED(securityKey)
     DBG_Printf(DBG_ERROR, "[ZGP] failed to decrypt GPDKey for 0x%08X, OpenSSL is not available or too old\n", unsigned(sourceID));
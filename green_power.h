@@ -12,6 +12,7 @@
 #define GREEN_POWER_H
 
 #include <array>
+#include <cstdint>
 #include <QtGlobal>
 
 #define GREEN_POWER_CLUSTER_ID  0x0021
@@ -34,6 +35,13 @@ class Resource;
 
 using GpKey_t = std::array<unsigned char, GP_SECURITY_KEY_SIZE>;
 
+/*! Cached sensor lookup of a GPD source id, see DeRestPluginPrivate::getSensorNodeForGpdSrcId(). */
+struct GP_SourceEntry
+{
+    size_t sensorIndex = 0; //! index into the sensors vector
+    size_t sensorCount = 0; //! size of the sensors vector at lookup, the entry is invalid when it changed
+};
+
 GpKey_t GP_DecryptSecurityKey(quint32 sourceID, const GpKey_t &securityKey);
 bool GP_SendProxyCommissioningMode(deCONZ::ApsController *apsCtrl, quint8 zclSeqNo);
 bool GP_SendPairing(quint32 gpdSrcId, quint16 sinkGroupId, quint8 deviceId, quint32 frameCounter, const GpKey_t &key, deCONZ::ApsController *apsCtrl, quint8 zclSeqNo, quint16 gppShortAddress);
@@ -126,6 +126,8 @@ void PollManager::poll(RestNodeBase *restNode, const QDateTime &tStart)
         if (i.prefix == r->prefix() && i.id == restNode->id())
         {
             i.items = pitem.items; // update
+            i.address = pitem.address; // the NWK address might have changed
+            pollAddr = pitem.address;
             if (tStart.isValid())
             {
                 i.tStart = tStart;
@@ -135,6 +137,7 @@ void PollManager::poll(RestNodeBase *restNode, const QDateTime &tStart)
     }
 
     items.push_back(pitem);
+    pollAddr = pitem.address;
 
     if (!timer->isActive())
     {
@@ -199,12 +202,14 @@ void PollManager::pollTimerFired()
         pollState = StateIdle;
         timer->start(50);
 
-        // Notify the DeviceTick manager that legacy code is done polling.
-        Device *device = DEV_GetDevice(plugin->m_devices, dstAddr.ext());
+        // Notify the DeviceTick manager that legacy code is done polling,
+        // num = 1 signals that requests were sent.
+        Device *device = DEV_GetDevice(plugin->m_devices, pollAddr.ext());
         if (device)
         {
-            emit device->eventNotify(Event(device->prefix(), REventPollDone, 0, device->key()));
+            emit device->eventNotify(Event(device->prefix(), REventPollDone, sentRequests > 0 ? 1 : 0, device->key()));
         }
+        sentRequests = 0;
         emit done();
         return;
     }
@@ -560,6 +565,7 @@ void PollManager::pollTimerFired()
         DBG_Assert(plugin->tasks.back().taskType == TaskReadAttributes);
         apsReqId = plugin->tasks.back().req.id();
         dstAddr = pitem.address;
+        sentRequests++;
         timer->start(60 * 1000); // wait for confirm
         suffix = nullptr; // clear
         DBG_Printf(DBG_INFO_L2, "Poll APS request %u to 0x%016llX cluster: 0x%04X\n", apsReqId, dstAddr.ext(), clusterId);
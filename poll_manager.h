@@ -69,6 +69,8 @@ private:
     PollState pollState;
     quint8 apsReqId;
     deCONZ::Address dstAddr;
+    deCONZ::Address pollAddr; // address of the last queued node
+    int sentRequests = 0; // read requests sent since the last done() signal
 };
 
 #endif // POLL_MANAGER_H
@@ -8,6 +8,7 @@
  *
  */
 
+#include <string.h>
 #include <QString>
 
 #include <deconz/u_assert.h>
@@ -29,6 +30,7 @@ const char *REventApsConfirm = "event/aps.confirm";
 const char *REventAwake = "event/awake";
 const char *REventBindingTable = "event/binding.table";
 const char *REventBindingTick = "event/binding.tick";
+const char *REventChanged = "event/changed";
 const char *REventCheckGroupAnyOn = "event/checkgroupanyon";
 const char *REventDDFInitRequest = "event/ddf.init.req";
 const char *REventDDFInitResponse = "event/ddf.init.rsp";
@@ -377,8 +379,149 @@ const QStringList RConfigLastChangeSourceValues({
 static std::vector<ResourceItemDescriptor> rItemDescriptors;
 static const QString rInvalidString; // is returned when string is asked but not available
 
+/*
+    Suffix lookup tables, both are open addressing hash tables with linear probing.
+    Each slot contains the index + 1 into rItemDescriptors[], 0 marks an empty slot.
+
+    rSuffixPtrTable    keyed by the suffix pointer, used by Resource::item() and friends
+    rSuffixStrTable    keyed by the suffix string, used when parsing suffixes from text (REST API, DDF, rules)
+ */
+static std::vector<uint16_t> rSuffixPtrTable;
+static std::vector<uint16_t> rSuffixStrTable;
+
 R_Stats rStats;
 
+static unsigned R_IndexHash(unsigned idx)
+{
+    return idx * 2654435761U; // Knuth multiplicative hash
+}
+
+static unsigned R_PointerHash(const char *ptr)
+{
+    const auto val = reinterpret_cast<quintptr>(ptr);
+    return R_IndexHash(unsigned(val >> 3) ^ unsigned(val >> 19));
+}
+
+static unsigned R_StringHash(const char *str, size_t len)
+{
+    unsigned hash = 2166136261U; // FNV-1a
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/*! Returns the table size for \p count entries, keeps the load factor <= 0.5. */
+static size_t R_HashTableSize(size_t count)
+{
+    size_t size = 8;
+    while (size < count * 2)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+static void R_InsertDescriptorIndex(size_t idx)
+{
+    U_ASSERT(idx < UINT16_MAX);
+    const char *suffix = rItemDescriptors[idx].suffix;
+
+    {
+        const size_t mask = rSuffixPtrTable.size() - 1;
+        size_t pos = R_PointerHash(suffix) & mask;
+
+        for (;rSuffixPtrTable[pos] != 0; pos = (pos + 1) & mask)
+        {
+            if (rItemDescriptors[rSuffixPtrTable[pos] - 1].suffix == suffix)
+            {
+                return; // first one wins, same as the linear search before
+            }
+        }
+
+        rSuffixPtrTable[pos] = static_cast<uint16_t>(idx + 1);
+    }
+
+    {
+        const size_t len = strlen(suffix);
+        const size_t mask = rSuffixStrTable.size() - 1;
+        size_t pos = R_StringHash(suffix, len) & mask;
+
+        for (;rSuffixStrTable[pos] != 0; pos = (pos + 1) & mask)
+        {
+            if (strcmp(rItemDescriptors[rSuffixStrTable[pos] - 1].suffix, suffix) == 0)
+            {
+                return;
+            }
+        }
+
+        rSuffixStrTable[pos] = static_cast<uint16_t>(idx + 1);
+    }
+}
+
+/*! (Re)builds the suffix lookup tables, needs to be called whenever rItemDescriptors[] changes. */
+static void R_RebuildDescriptorIndex()
+{
+    const size_t size = R_HashTableSize(rItemDescriptors.size());
+
+    rSuffixPtrTable.assign(size, 0);
+    rSuffixStrTable.assign(size, 0);
+
+    for (size_t i = 0; i < rItemDescriptors.size(); i++)
+    {
+        R_InsertDescriptorIndex(i);
+    }
+}
+
+/*! Returns the index into rItemDescriptors[] for the suffix pointer \p suffix, or -1 if not known. */
+static int R_DescriptorIndexForSuffix(const char *suffix)
+{
+    if (rSuffixPtrTable.empty() || !suffix)
+    {
+        return -1;
+    }
+
+    const size_t mask = rSuffixPtrTable.size() - 1;
+
+    for (size_t pos = R_PointerHash(suffix) & mask; rSuffixPtrTable[pos] != 0; pos = (pos + 1) & mask)
+    {
+        const int idx = rSuffixPtrTable[pos] - 1;
+        if (rItemDescriptors[idx].suffix == suffix)
+        {
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
+/*! Returns the index into rItemDescriptors[] for the suffix string \p str of length \p len, or -1 if not known. */
+static int R_DescriptorIndexForString(const char *str, size_t len)
+{
+    if (rSuffixStrTable.empty())
+    {
+        return -1;
+    }
+
+    const size_t mask = rSuffixStrTable.size() - 1;
+
+    for (size_t pos = R_StringHash(str, len) & mask; rSuffixStrTable[pos] != 0; pos = (pos + 1) & mask)
+    {
+        const int idx = rSuffixStrTable[pos] - 1;
+        const char *suffix = rItemDescriptors[idx].suffix;
+        if (strncmp(suffix, str, len) == 0 && suffix[len] == '\0')
+        {
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
 void initResourceDescriptors()
 {
     rItemDescriptors.clear();
@@ -679,6 +822,8 @@ void initResourceDescriptors()
     rItemDescriptors.emplace_back(ResourceItemDescriptor(DataTypeUInt8, QVariant::Double, RConfigWindowCoveringType));
     rItemDescriptors.emplace_back(ResourceItemDescriptor(DataTypeBool, QVariant::Bool, RConfigWindowOpen));
     rItemDescriptors.emplace_back(ResourceItemDescriptor(DataTypeBool, QVariant::Bool, RConfigWindowOpenDetectionEnabled));
+
+    R_RebuildDescriptorIndex();
 }
 
 const char *getResourcePrefix(const QString &str)
@@ -687,12 +832,37 @@ const char *getResourcePrefix(const QString &str)
     return nullptr;
 }
 
+/*! Looks up the descriptor of a suffix given as text.
+
+    \p str may be a plain suffix like "state/on" or a full path which ends with a suffix
+    like "/sensors/1/state/on" (used in rule conditions). The hash lookup is tried for each
+    path segment boundary, the linear search only serves as fallback for odd input.
+ */
 bool getResourceItemDescriptor(const QString &str, ResourceItemDescriptor &descr)
 {
+    const QByteArray str1 = str.toLatin1();
+    const char *beg = str1.constData();
+    const char *end = beg + str1.size();
+
+    for (const char *p = beg; p < end; p++)
+    {
+        if (p != beg && p[-1] != '/')
+        {
+            continue;
+        }
+
+        const int idx = R_DescriptorIndexForString(p, size_t(end - p));
+        if (idx >= 0)
+        {
+            descr = rItemDescriptors[idx];
+            return true;
+        }
+    }
+
     auto i = rItemDescriptors.begin();
-    const auto end = rItemDescriptors.end();
+    const auto iend = rItemDescriptors.end();
 
-    for (; i != end; ++i)
+    for (; i != iend; ++i)
     {
         if (str.endsWith(QLatin1String(i->suffix)))
         {
@@ -708,22 +878,21 @@ bool R_AddResourceItemDescriptor(const ResourceItemDescriptor &rid)
 {
     if (rid.isValid())
     {
-        QLatin1String str1(rid.suffix);
-
-        auto i = rItemDescriptors.begin();
-        const auto end = rItemDescriptors.end();
-
-        for (; i != end; ++i)
+        if (R_DescriptorIndexForString(rid.suffix, strlen(rid.suffix)) >= 0)
         {
-            QLatin1String str2(i->suffix);
-
-            if (str1 == str2)
-            {
-                return false; //already known
-            }
+            return false; //already known
         }
 
         rItemDescriptors.push_back(rid);
+
+        if (rItemDescriptors.size() * 2 > rSuffixPtrTable.size())
+        {
+            R_RebuildDescriptorIndex();
+        }
+        else
+        {
+            R_InsertDescriptorIndex(rItemDescriptors.size() - 1);
+        }
         return true;
     }
 
@@ -1040,16 +1209,8 @@ ResourceItem &ResourceItem::operator=(ResourceItem &&other) noexcept
 /*! Initial main constructor to create a valid ResourceItem. */
 ResourceItem::ResourceItem(const ResourceItemDescriptor &rid)
 {
-    m_ridIndex = 0;
-
-    for (size_t i = 0; i < rItemDescriptors.size(); i++)
-    {
-        if (rItemDescriptors[i].suffix == rid.suffix)
-        {
-            m_ridIndex = static_cast<uint16_t>(i);
-            break;
-        }
-    }
+    const int idx = R_DescriptorIndexForSuffix(rid.suffix);
+    m_ridIndex = idx > 0 ? static_cast<uint16_t>(idx) : 0;
 
     if (rid.type == DataTypeString ||
         rid.type == DataTypeTime ||
@@ -1605,7 +1766,8 @@ Resource::Resource(const Resource &other) :
     m_handle(other.m_handle),
     m_prefix(other.m_prefix),
     m_parent(other.m_parent),
-    m_rItems(other.m_rItems)
+    m_rItems(other.m_rItems),
+    m_itemLookup(other.m_itemLookup)
 {
 }
 
@@ -1624,6 +1786,7 @@ Resource &Resource::operator=(const Resource &other)
         m_prefix = other.m_prefix;
         m_parent = other.m_parent;
         m_rItems = other.m_rItems;
+        m_itemLookup = other.m_itemLookup;
     }
     return *this;
 }
@@ -1637,6 +1800,7 @@ Resource &Resource::operator=(Resource &&other) noexcept
         m_prefix = other.m_prefix;
         m_parent = other.m_parent;
         m_rItems = std::move(other.m_rItems);
+        m_itemLookup = std::move(other.m_itemLookup);
     }
     return *this;
 }
@@ -1652,16 +1816,21 @@ ResourceItem *Resource::addItem(ApiDataType type, const char *suffix)
     ResourceItem *it = item(suffix);
     if (!it) // prevent double insertion
     {
-        std::vector<ResourceItemDescriptor>::const_iterator i = rItemDescriptors.begin();
-        std::vector<ResourceItemDescriptor>::const_iterator end = rItemDescriptors.end();
+        const int idx = R_DescriptorIndexForSuffix(suffix);
 
-        for (; i != end; ++i)
+        if (idx >= 0 && rItemDescriptors[idx].type == type)
         {
-            if (i->suffix == suffix && i->type == type)
+            m_rItems.emplace_back(rItemDescriptors[idx]);
+
+            if (m_rItems.size() * 2 > m_itemLookup.size())
+            {
+                rebuildItemLookup();
+            }
+            else
             {
-                m_rItems.emplace_back(*i);
-                return &m_rItems.back();
+                insertItemLookup(m_rItems.size() - 1);
             }
+            return &m_rItems.back();
         }
 
         DBG_Assert(0);
@@ -1685,38 +1854,82 @@ void Resource::removeItem(const char *suffix)
 
         *i = std::move(m_rItems.back());
         m_rItems.pop_back();
+        rebuildItemLookup();
         break;
     }
 }
 
-ResourceItem *Resource::item(const char *suffix)
+/*! Adds the item at \p idx in m_rItems to the lookup table. */
+void Resource::insertItemLookup(size_t idx)
 {
-    rStats.item++;
+    Q_ASSERT(idx < m_rItems.size());
+    Q_ASSERT(!m_itemLookup.empty());
 
-    for (size_t i = 0; i < m_rItems.size(); i++)
+    const size_t mask = m_itemLookup.size() - 1;
+    size_t pos = R_IndexHash(m_rItems[idx].descriptorIndex()) & mask;
+
+    while (m_itemLookup[pos] != 0)
     {
-        if (m_rItems[i].descriptor().suffix == suffix)
-        {
-            return &m_rItems[i];
-        }
+        pos = (pos + 1) & mask;
     }
 
-    return nullptr;
+    m_itemLookup[pos] = static_cast<uint16_t>(idx + 1);
 }
 
-const ResourceItem *Resource::item(const char *suffix) const
+/*! Rebuilds the descriptor index -> item index lookup table. */
+void Resource::rebuildItemLookup()
 {
-    rStats.item++;
+    m_itemLookup.assign(R_HashTableSize(m_rItems.size()), 0);
 
     for (size_t i = 0; i < m_rItems.size(); i++)
     {
-        if (m_rItems[i].descriptor().suffix == suffix)
+        insertItemLookup(i);
+    }
+}
+
+/*! Returns the index into m_rItems for \p suffix or -1 if the resource has no such item.
+    This is O(1): the suffix pointer is mapped to its global descriptor index which is
+    then looked up in the per resource hash table.
+ */
+int Resource::itemIndex(const char *suffix) const
+{
+    rStats.item++;
+
+    if (m_itemLookup.empty())
+    {
+        return -1;
+    }
+
+    const int rid = R_DescriptorIndexForSuffix(suffix);
+    if (rid < 0)
+    {
+        return -1;
+    }
+
+    const size_t mask = m_itemLookup.size() - 1;
+
+    for (size_t pos = R_IndexHash(unsigned(rid)) & mask; m_itemLookup[pos] != 0; pos = (pos + 1) & mask)
+    {
+        const int idx = m_itemLookup[pos] - 1;
+        if (m_rItems[idx].descriptorIndex() == rid)
         {
-            return &m_rItems[i];
+            return idx;
         }
     }
 
-    return nullptr;
+    return -1;
+}
+
+ResourceItem *Resource::item(const char *suffix)
+{
+    const int idx = itemIndex(suffix);
+    return idx >= 0 ? &m_rItems[idx] : nullptr;
+}
+
+const ResourceItem *Resource::item(const char *suffix) const
+{
+    const int idx = itemIndex(suffix);
+    return idx >= 0 ? &m_rItems[idx] : nullptr;
 }
 
 bool Resource::toBool(const char *suffix) const
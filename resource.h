@@ -65,6 +65,7 @@ extern const char *REventApsConfirm;
 extern const char *REventAwake;
 extern const char *REventBindingTable;
 extern const char *REventBindingTick;
+extern const char *REventChanged;
 extern const char *REventDeleted;
 extern const char *REventDeviceAlarm;
 extern const char *REventDeviceAnnounce;
@@ -529,6 +530,7 @@ public:
     ValueSource valueSource() const { return m_valueSource; }
     void setDdfItemHandle(quint32 handle) { m_ddfItemHandle = handle; }
     quint32 ddfItemHandle() const { return m_ddfItemHandle; }
+    int descriptorIndex() const { return m_ridIndex; }
 
 private:
     ResourceItem() = delete;
@@ -626,10 +628,14 @@ public:
 
 private:
     Resource() = delete;
+    int itemIndex(const char *suffix) const;
+    void insertItemLookup(size_t idx);
+    void rebuildItemLookup();
     Handle m_handle{};
     const char *m_prefix = nullptr;
     Resource *m_parent = nullptr;
     std::vector<ResourceItem> m_rItems;
+    std::vector<uint16_t> m_itemLookup; // open addressing: descriptor index -> index + 1 in m_rItems
     std::vector<StateChange> m_stateChanges;
 };
 
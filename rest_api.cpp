@@ -8,7 +8,11 @@
  *
  */
 
+#include <QDateTime>
+#include <QUrl>
+#include <QUrlQuery>
 #include <deconz/dbg_trace.h>
+#include "database.h"
 #include "rest_api.h"
 
 const char *HttpStatusOk           = "200 OK"; // OK
@@ -48,3 +52,61 @@ QVariantMap errorToMap(int id, const QString &ressource, const QString &descript
 
     return map;
 }
+
+/*! Parses the parameters of a value history request into \p query:
+    maxrecords=<maxrecords>&fromtime=<ISO 8601>[&totime=<ISO 8601>][&bucket=<seconds>]
+    \return true on success, otherwise an error is added to \p rsp
+ */
+bool historyQueryFromRequest(const ApiRequest &req, ApiResponse &rsp, DB_HistoryQuery *query)
+{
+    bool ok;
+    const QUrl url(req.hdr.url());
+    const QUrlQuery urlQuery(url);
+
+    const int maxRecords = urlQuery.queryItemValue(QLatin1String("maxrecords")).toInt(&ok);
+    if (!ok || maxRecords <= 0)
+    {
+        rsp.list.append(errorToMap(ERR_INVALID_VALUE, QLatin1String("/maxrecords"), QString("invalid value, %1, for parameter, maxrecords").arg(urlQuery.queryItemValue("maxrecords"))));
+        rsp.httpStatus = HttpStatusNotFound;
+        return false;
+    }
+
+    QString t = urlQuery.queryItemValue(QLatin1String("fromtime"));
+    const QDateTime dt = QDateTime::fromString(t, QLatin1String("yyyy-MM-ddTHH:mm:ss"));
+    if (!dt.isValid())
+    {
+        rsp.list.append(errorToMap(ERR_INVALID_VALUE, QLatin1String("/fromtime"), QString("invalid value, %1, for parameter, fromtime").arg(t)));
+        rsp.httpStatus = HttpStatusNotFound;
+        return false;
+    }
+
+    query->fromTime = dt.toMSecsSinceEpoch() / 1000;
+    query->max = maxRecords;
+
+    if (urlQuery.hasQueryItem(QLatin1String("totime")))
+    {
+        t = urlQuery.queryItemValue(QLatin1String("totime"));
+        const QDateTime toDt = QDateTime::fromString(t, QLatin1String("yyyy-MM-ddTHH:mm:ss"));
+        if (!toDt.isValid() || toDt < dt)
+        {
+            rsp.list.append(errorToMap(ERR_INVALID_VALUE, QLatin1String("/totime"), QString("invalid value, %1, for parameter, totime").arg(t)));
+            rsp.httpStatus = HttpStatusNotFound;
+            return false;
+        }
+        query->toTime = toDt.toMSecsSinceEpoch() / 1000;
+    }
+
+    if (urlQuery.hasQueryItem(QLatin1String("bucket")))
+    {
+        const int bucket = urlQuery.queryItemValue(QLatin1String("bucket")).toInt(&ok);
+        if (!ok || bucket <= 0)
+        {
+            rsp.list.append(errorToMap(ERR_INVALID_VALUE, QLatin1String("/bucket"), QString("invalid value, %1, for parameter, bucket").arg(urlQuery.queryItemValue("bucket"))));
+            rsp.httpStatus = HttpStatusNotFound;
+            return false;
+        }
+        query->bucket = bucket;
+    }
+
+    return true;
+}
@@ -134,7 +134,10 @@ public:
     char *bin = nullptr;
 };
 
+struct DB_HistoryQuery;
+
 // REST API common
 QVariantMap errorToMap(int id, const QString &ressource, const QString &description);
+bool historyQueryFromRequest(const ApiRequest &req, ApiResponse &rsp, DB_HistoryQuery *query);
 
 #endif // REST_API_H
@@ -30,7 +30,10 @@
 #include "backup.h"
 #include "crypto/password.h"
 #include "crypto/random.h"
+#include "database.h"
+#include "device_tick.h"
 #include "gateway.h"
+#include "utils/latency.h"
 #include "utils/utils.h"
 #ifdef Q_OS_LINUX
   #include <unistd.h>
@@ -748,6 +751,28 @@ int DeRestPluginPrivate::handleConfigFullApi(const ApiRequest &req, ApiResponse
     {
         return getZigbeeConfig(req, rsp);
     }
+    // GET /api/<apikey>/config/metrics
+    else if ((req.path.size() == 4) && (req.hdr.method() == QLatin1String("GET")) && (req.path[2] == QLatin1String("config")) && (req.path[3] == QLatin1String("metrics")))
+    {
+        return getMetrics(req, rsp);
+    }
+    // GET /api/<apikey>/config/metrics/database
+    else if ((req.path.size() == 5) && (req.hdr.method() == QLatin1String("GET")) && (req.path[2] == QLatin1String("config")) && (req.path[3] == QLatin1String("metrics")) && (req.path[4] == QLatin1String("database")))
+    {
+        return getDatabaseMetrics(req, rsp);
+    }
+    // GET /api/<apikey>/config/metrics/indications
+    else if ((req.path.size() == 5) && (req.hdr.method() == QLatin1String("GET")) && (req.path[2] == QLatin1String("config")) && (req.path[3] == QLatin1String("metrics")) && (req.path[4] == QLatin1String("indications")))
+    {
+        return getIndicationMetrics(req, rsp);
+    }
+    // DELETE /api/<apikey>/config/metrics/indications
+    else if ((req.path.size() == 5) && (req.hdr.method() == QLatin1String("DELETE")) && (req.path[2] == QLatin1String("config")) && (req.path[3] == QLatin1String("metrics")) && (req.path[4] == QLatin1String("indications")))
+    {
+        LAT_Reset();
+        rsp.httpStatus = HttpStatusOk;
+        return REQ_READY_SEND;
+    }
     // PUT /api/config/zigbee/<id>
     else if ((req.path.size() == 5) && (req.hdr.method() == QLatin1String("PUT")) && (req.path[2] == QLatin1String("config")) && (req.path[3] == QLatin1String("zigbee")))
     {
@@ -1140,6 +1165,7 @@ void DeRestPluginPrivate::configToMap(const ApiRequest &req, QVariantMap &map)
 #endif
     }
     map["websocketnotifyall"] = gwWebSocketNotifyAll;
+    map["dbprofile"] = QLatin1String(DB_ProfileName(DB_GetProfile()));
     map["disablePermitJoinAutoOff"] = gwdisablePermitJoinAutoOff;
 
     QStringList ipv4 = gwIPAddress.split(".");
@@ -1458,6 +1484,199 @@ int DeRestPluginPrivate::getZigbeeConfig(const ApiRequest &req, ApiResponse &rsp
     return REQ_READY_SEND;
 }
 
+/*! GET /api/<apikey>/config/metrics
+
+    Runtime metrics of the gateway: the startup timeline, the latency of
+    database transactions and the device polling of the DeviceTick. Times are in
+    milliseconds, startup times are relative to the start of the plugin.
+
+    \return REQ_READY_SEND
+ */
+int DeRestPluginPrivate::getMetrics(const ApiRequest &req, ApiResponse &rsp)
+{
+    Q_UNUSED(req)
+
+    QVariantList phases;
+
+    for (const DB_StartupPhase &phase : DB_StartupTimeline())
+    {
+        QVariantMap p;
+        p[QLatin1String("name")] = QLatin1String(phase.name);
+        p[QLatin1String("start")] = double(phase.startMs);
+        p[QLatin1String("duration")] = double(phase.endMs - phase.startMs);
+        phases.push_back(p);
+    }
+
+    QVariantMap startup;
+    startup[QLatin1String("phases")] = phases;
+
+    const DB_CommitStats &commits = DB_GetCommitStats();
+    QVariantMap database;
+    database[QLatin1String("profile")] = QLatin1String(DB_ProfileName(DB_GetProfile()));
+    database[QLatin1String("commits")] = double(commits.commits);
+    database[QLatin1String("failed")] = double(commits.failed);
+    database[QLatin1String("commitavg")] = commits.commits ? double(commits.commitTotalMs) / commits.commits : 0.0;
+    database[QLatin1String("commitmax")] = double(commits.commitMaxMs);
+    database[QLatin1String("saveavg")] = commits.commits ? double(commits.saveTotalMs) / commits.commits : 0.0;
+    database[QLatin1String("savemax")] = double(commits.saveMaxMs);
+
+    rsp.map[QLatin1String("startup")] = startup;
+    rsp.map[QLatin1String("database")] = database;
+
+    if (deviceTick)
+    {
+        const DeviceTickStats &ts = deviceTick->stats();
+        QVariantMap tick;
+        tick[QLatin1String("polls")] = double(ts.polls);
+        tick[QLatin1String("pollsidle")] = double(ts.pollsIdle);
+        tick[QLatin1String("polltimeouts")] = double(ts.pollTimeouts);
+        tick[QLatin1String("skipped")] = double(ts.skipped);
+        tick[QLatin1String("rounds")] = double(ts.rounds);
+        tick[QLatin1String("pollavg")] = ts.polls ? double(ts.pollTotalMs) / ts.polls : 0.0;
+        tick[QLatin1String("pollmax")] = double(ts.pollMaxMs);
+        tick[QLatin1String("ticklatencymax")] = double(ts.tickMaxLatencyMs);
+        tick[QLatin1String("lastround")] = double(ts.lastRoundMs);
+        rsp.map[QLatin1String("devicetick")] = tick;
+    }
+    rsp.httpStatus = HttpStatusOk;
+    return REQ_READY_SEND;
+}
+
+/*! GET /api/<apikey>/config/metrics/database
+
+    Database profile: file and table sizes and per statement type the number of
+    executions, execution time in microseconds and rows changed.
+    Statements are sorted by total execution time, transaction times are milliseconds.
+    The statement statistics are collected after the first request to this endpoint.
+
+    \return REQ_READY_SEND
+ */
+int DeRestPluginPrivate::getDatabaseMetrics(const ApiRequest &req, ApiResponse &rsp)
+{
+    Q_UNUSED(req)
+
+    DB_EnableStatementStats();
+
+    DB_SizeStats size;
+    if (DB_GetSizeStats(&size))
+    {
+        QVariantMap file;
+        file[QLatin1String("pagesize")] = double(size.pageSize);
+        file[QLatin1String("pages")] = double(size.pageCount);
+        file[QLatin1String("freepages")] = double(size.freePages);
+        file[QLatin1String("bytes")] = double(size.pageCount * size.pageSize);
+
+        QVariantMap tables;
+        for (const DB_TableStats &table : size.tables)
+        {
+            QVariantMap t;
+            t[QLatin1String("rows")] = double(table.rows);
+            if (table.bytes >= 0)
+            {
+                t[QLatin1String("bytes")] = double(table.bytes);
+            }
+            tables[QString::fromStdString(table.name)] = t;
+        }
+
+        rsp.map[QLatin1String("file")] = file;
+        rsp.map[QLatin1String("tables")] = tables;
+    }
+
+    QVariantList statements;
+    for (const DB_StatementStats &stats : DB_GetStatementStats())
+    {
+        QVariantMap s;
+        s[QLatin1String("op")] = QString::fromStdString(stats.op);
+        if (!stats.table.empty())
+        {
+            s[QLatin1String("table")] = QString::fromStdString(stats.table);
+        }
+        s[QLatin1String("count")] = double(stats.count);
+        s[QLatin1String("time")] = double(stats.totalUs);
+        s[QLatin1String("maxtime")] = double(stats.maxUs);
+        s[QLatin1String("rows")] = double(stats.rows);
+        statements.push_back(s);
+    }
+
+    const DB_CommitStats &commits = DB_GetCommitStats();
+    QVariantMap transactions;
+    transactions[QLatin1String("count")] = double(commits.commits);
+    transactions[QLatin1String("failed")] = double(commits.failed);
+    transactions[QLatin1String("time")] = double(commits.saveTotalMs);
+    transactions[QLatin1String("maxtime")] = double(commits.saveMaxMs);
+    transactions[QLatin1String("committime")] = double(commits.commitTotalMs);
+
+    rsp.map[QLatin1String("statements")] = statements;
+    rsp.map[QLatin1String("transactions")] = transactions;
+    rsp.httpStatus = HttpStatusOk;
+    return REQ_READY_SEND;
+}
+
+static QVariantMap latencyToMap(const LAT_Histogram &hist)
+{
+    QVariantMap map;
+    map[QLatin1String("count")] = double(hist.count);
+    map[QLatin1String("avg")] = hist.count ? double(hist.totalUs) / hist.count : 0.0;
+    map[QLatin1String("max")] = double(hist.maxUs);
+    map[QLatin1String("p50")] = double(LAT_Percentile(hist, 50));
+    map[QLatin1String("p90")] = double(LAT_Percentile(hist, 90));
+    map[QLatin1String("p99")] = double(LAT_Percentile(hist, 99));
+
+    QVariantList buckets;
+    for (unsigned i = 0; i < LAT_BUCKETS; i++)
+    {
+        buckets.push_back(double(hist.buckets[i]));
+    }
+    map[QLatin1String("buckets")] = buckets;
+
+    return map;
+}
+
+/*! GET /api/<apikey>/config/metrics/indications
+
+    Latency histograms of the APS indication processing stages since the start or the
+    last DELETE on this resource, per stage in total and per ZCL cluster ("none" for time
+    spent outside of an indication). Times are in microseconds, bucket n counts the
+    latencies in [2^n, 2^(n+1)) us. Stages can be nested: "ddfparse" includes the
+    "dbqueue" and "eventenqueue" times of the items it updates.
+
+    \return REQ_READY_SEND
+ */
+int DeRestPluginPrivate::getIndicationMetrics(const ApiRequest &req, ApiResponse &rsp)
+{
+    Q_UNUSED(req)
+
+    std::vector<LAT_Entry> entries;
+    LAT_GetStats(&entries);
+
+    QVariantMap stages;
+
+    for (size_t i = 0; i < entries.size(); )
+    {
+        const LAT_Stage stage = entries[i].stage;
+        LAT_Histogram total;
+        QVariantMap clusters;
+
+        for (; i < entries.size() && entries[i].stage == stage; i++)
+        {
+            const LAT_Entry &e = entries[i];
+            LAT_Merge(&total, e.hist);
+
+            const QString cluster = e.clusterId == LAT_NO_CLUSTER ? QString(QLatin1String("none"))
+                                                                  : QString("0x%1").arg(e.clusterId, 4, 16, QLatin1Char('0'));
+            clusters[cluster] = latencyToMap(e.hist);
+        }
+
+        QVariantMap s = latencyToMap(total);
+        s[QLatin1String("clusters")] = clusters;
+        stages[QLatin1String(LAT_StageName(stage))] = s;
+    }
+
+    rsp.map[QLatin1String("stages")] = stages;
+    rsp.httpStatus = HttpStatusOk;
+    return REQ_READY_SEND;
+}
+
 /*! PUT /api/config/zigbee/<id>
 
     Activates a certain known zigbee configuration.
@@ -2242,6 +2461,30 @@ int DeRestPluginPrivate::modifyConfig(const ApiRequest &req, ApiResponse &rsp)
         rsp.list.append(rspItem);
     }
 
+    if (map.contains("dbprofile")) // optional
+    {
+        const QString profile = map["dbprofile"].toString();
+
+        if (map["dbprofile"].type() != QVariant::String || !DB_SetProfile(QLatin1String(qPrintable(profile))))
+        {
+            rsp.list.append(errorToMap(ERR_INVALID_VALUE, QString("/config/dbprofile"), QString("invalid value, %1, for parameter, dbprofile").arg(profile)));
+            rsp.httpStatus = HttpStatusBadRequest;
+            return REQ_READY_SEND;
+        }
+
+        if (gwConfig.value("dbprofile").toString() != profile)
+        {
+            gwConfig["dbprofile"] = profile;
+            changed = true;
+            queSaveDb(DB_CONFIG, DB_SHORT_SAVE_DELAY);
+        }
+        QVariantMap rspItem;
+        QVariantMap rspItemState;
+        rspItemState["/config/dbprofile"] = profile;
+        rspItem["success"] = rspItemState;
+        rsp.list.append(rspItem);
+    }
+
     if (map.contains("websocketnotifyall")) // optional
     {
         bool notifyAll = map["websocketnotifyall"].toBool();
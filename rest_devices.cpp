@@ -312,6 +312,25 @@ int RestDevices::getDevice(const ApiRequest &req, ApiResponse &rsp)
         }
     }
 
+    {
+        const DEV_PollStats &pollStats = device->pollStats();
+        QVariantMap poll;
+        poll["polled"] = double(pollStats.polled);
+        poll["suppressed"] = double(pollStats.suppressed);
+        poll["stale"] = double(pollStats.stale);
+        poll["coalesced"] = double(pollStats.coalesced);
+        rsp.map["poll"] = poll;
+    }
+
+    {
+        const DEV_DispatchStats &dispatchStats = device->dispatchStats();
+        QVariantMap dispatch;
+        dispatch["dispatched"] = double(dispatchStats.dispatched);
+        dispatch["skipped"] = double(dispatchStats.skipped);
+        dispatch["rebuilds"] = double(dispatchStats.rebuilds);
+        rsp.map["dispatch"] = dispatch;
+    }
+
     QVariantList subDevices;
 
     for (const auto &sub : device->subDevices())
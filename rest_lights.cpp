@@ -10,7 +10,6 @@
 
 #include <QString>
 #include <QTcpSocket>
-#include <QUrlQuery>
 #include <QVariantMap>
 #include <math.h>
 #include "database.h"
@@ -622,7 +621,12 @@ bool DeRestPluginPrivate::lightToMap(const ApiRequest &req, LightNode *lightNode
     return true;
 }
 
-/*! GET /api/<apikey>/lights/<id>/data?maxrecords=<maxrecords>&fromtime=<ISO 8601>
+/*! GET /api/<apikey>/lights/<id>/data?maxrecords=<maxrecords>&fromtime=<ISO 8601>[&totime=<ISO 8601>][&bucket=<seconds>]
+
+    Without bucket the raw samples are returned. With bucket the samples are aggregated
+    per bucket (min, max, avg, sum, last, count) in the history store.
+    For paging the next request uses the last returned "t" as fromtime.
+
     \return REQ_READY_SEND
             REQ_NOT_HANDLED
  */
@@ -645,31 +649,15 @@ int DeRestPluginPrivate::getLightData(const ApiRequest &req, ApiResponse &rsp)
         return REQ_READY_SEND;
     }
 
-    bool ok;
-    QUrl url(req.hdr.url());
-    QUrlQuery query(url);
-
-    const int maxRecords = query.queryItemValue(QLatin1String("maxrecords")).toInt(&ok);
-    if (!ok || maxRecords <= 0)
-    {
-        rsp.list.append(errorToMap(ERR_INVALID_VALUE, QString("/maxrecords"), QString("invalid value, %1, for parameter, maxrecords").arg(query.queryItemValue("maxrecords"))));
-        rsp.httpStatus = HttpStatusNotFound;
-        return REQ_READY_SEND;
-    }
+    DB_HistoryQuery historyQuery;
 
-    QString t = query.queryItemValue(QLatin1String("fromtime"));
-    QDateTime dt = QDateTime::fromString(t, QLatin1String("yyyy-MM-ddTHH:mm:ss"));
-    if (!dt.isValid())
+    if (!historyQueryFromRequest(req, rsp, &historyQuery))
     {
-        rsp.list.append(errorToMap(ERR_INVALID_VALUE, QString("/fromtime"), QString("invalid value, %1, for parameter, fromtime").arg(query.queryItemValue("fromtime"))));
-        rsp.httpStatus = HttpStatusNotFound;
         return REQ_READY_SEND;
     }
 
-    const qint64 fromTime = dt.toMSecsSinceEpoch() / 1000;
-
     openDb();
-    loadLightDataFromDb(lightNode, rsp.list, fromTime, maxRecords);
+    loadLightDataFromDb(lightNode, rsp.list, historyQuery);
     closeDb();
 
     if (rsp.list.isEmpty())
@@ -3287,7 +3275,7 @@ int DeRestPluginPrivate::setWarningDeviceState(const ApiRequest &req, ApiRespons
             if (alert == "none" || alert == "select")
             {
                 ResourceItem *item = task.lightNode->item(RStateAlert);
-                const auto ddfItem = DDF_GetItem(item);
+                const auto &ddfItem = DDF_GetItem(item);
 
                 if (!ddfItem.writeParameters.isNull())
                 {
@@ -3954,6 +3942,21 @@ int DeRestPluginPrivate::removeAllGroups(const ApiRequest &req, ApiResponse &rsp
     return REQ_READY_SEND;
 }
 
+/*! Lets the groups of \p lightNode update their any_on state. */
+static void checkLightGroupsAnyOn(const LightNode *lightNode)
+{
+    auto g = lightNode->groups().cbegin();
+    const auto gend = lightNode->groups().cend();
+    for (; g != gend; ++g)
+    {
+        if (g->state == GroupInfo::StateInGroup)
+        {
+            Event e(RGroups, REventCheckGroupAnyOn, int(g->id));
+            enqueueEvent(e);
+        }
+    }
+}
+
 void DeRestPluginPrivate::handleLightEvent(const Event &e)
 {
     DBG_Assert(e.resource() == RLights);
@@ -4003,6 +4006,35 @@ void DeRestPluginPrivate::handleLightEvent(const Event &e)
         return;
     }
 
+    if (e.what() == REventChanged)
+    {
+        // check before the push, which might clear the flags of the whole state object
+        const ResourceItem *on = lightNode->item(RStateOn);
+        const ResourceItem *reachable = lightNode->item(RStateReachable);
+        const bool checkGroupAnyOn = (on && (on->needPushSet() || on->needPushChange())) ||
+                                     (reachable && (reachable->needPushSet() || reachable->needPushChange()));
+
+        for (int i = 0; i < lightNode->itemCount(); i++)
+        {
+            ResourceItem *item = lightNode->itemForIndex(static_cast<size_t>(i));
+            if (item && item->isPublic())
+            {
+                notifyLightItemChange(lightNode, item);
+            }
+        }
+
+        if (checkGroupAnyOn)
+        {
+            checkLightGroupsAnyOn(lightNode);
+        }
+        return;
+    }
+
+    if (e.isInChangeSet())
+    {
+        return; // pushed by REventChanged
+    }
+
     ResourceItem *item = lightNode->item(e.what());
     if (!item || !item->isPublic())
     {
@@ -4013,13 +4045,33 @@ void DeRestPluginPrivate::handleLightEvent(const Event &e)
         return; // already pushed
     }
 
-    if (e.what() == RAttrLastSeen)
+    notifyLightItemChange(lightNode, item);
+
+    if (e.what() == RStateOn || e.what() == RStateReachable)
+    {
+        checkLightGroupsAnyOn(lightNode);
+    }
+}
+
+/*! Pushes the websocket "changed" events for \p item, all items with the same
+    parent object (state, config, attr) which need a push are sent along.
+ */
+void DeRestPluginPrivate::notifyLightItemChange(LightNode *lightNode, ResourceItem *item)
+{
+    if (!(item->needPushSet() || item->needPushChange()))
+    {
+        return; // already pushed
+    }
+
+    const char *what = item->descriptor().suffix;
+
+    if (what == RAttrLastSeen)
     {
         QVariantMap map;
         map[QLatin1String("t")] = QLatin1String("event");
         map[QLatin1String("e")] = QLatin1String("changed");
         map[QLatin1String("r")] = QLatin1String("lights");
-        map[QLatin1String("id")] = e.id();
+        map[QLatin1String("id")] = lightNode->id();
         map[QLatin1String("uniqueid")] = lightNode->uniqueId();
         QVariantMap map1;
         map1[QLatin1String("lastseen")] = item->toString();
@@ -4035,7 +4087,7 @@ void DeRestPluginPrivate::handleLightEvent(const Event &e)
     QStringList path;  // dummy
     ApiRequest req(hdr, path, nullptr, QLatin1String("")); // dummy
     req.mode = ApiModeNormal;
-    lightToMap(req, lightNode, lmap, e.what());
+    lightToMap(req, lightNode, lmap, what);
 
     bool pushed = false;
     QVariantMap needPush = lmap[QLatin1String("_push")].toMap();
@@ -4045,13 +4097,13 @@ void DeRestPluginPrivate::handleLightEvent(const Event &e)
         suffix[0] = it.key()[0].toLatin1();
         suffix[1] = it.key()[1].toLatin1();
 
-        if (suffix[0] == e.what()[0] && suffix[1] == e.what()[1])
+        if (suffix[0] == what[0] && suffix[1] == what[1])
         {
             QVariantMap map;
             map[QLatin1String("t")] = QLatin1String("event");
             map[QLatin1String("e")] = QLatin1String("changed");
             map[QLatin1String("r")] = QLatin1String("lights");
-            map[QLatin1String("id")] = e.id();
+            map[QLatin1String("id")] = lightNode->id();
             map[QLatin1String("uniqueid")] = lightNode->uniqueId();
             map[it.key()] = lmap[it.key()];
             webSocketServer->broadcastTextMessage(Json::serialize(map));
@@ -4059,20 +4111,6 @@ void DeRestPluginPrivate::handleLightEvent(const Event &e)
         }
     }
 
-    if ((e.what() == RStateOn || e.what() == RStateReachable) && !lightNode->groups().empty())
-    {
-        auto g = lightNode->groups().cbegin();
-        const auto gend = lightNode->groups().cend();
-        for (; g != gend; ++g)
-        {
-            if (g->state == GroupInfo::StateInGroup)
-            {
-                Event e(RGroups, REventCheckGroupAnyOn, int(g->id));
-                enqueueEvent(e);
-            }
-        }
-    }
-
     if (pushed)
     {
         // cleanup push flags
@@ -4085,7 +4123,7 @@ void DeRestPluginPrivate::handleLightEvent(const Event &e)
                 if (item && (item->needPushChange() || item->needPushSet()))
                 {
                     const ResourceItemDescriptor &rid = item->descriptor();
-                    if (rid.suffix[0] == e.what()[0] && rid.suffix[1] == e.what()[1])
+                    if (rid.suffix[0] == what[0] && rid.suffix[1] == what[1])
                     {
                         item->clearNeedPush();
                     }
@@ -9,6 +9,7 @@
  */
 
 #include <QTime>
+#include "database.h"
 #include "de_web_plugin_private.h"
 
 /*! Constructor.
@@ -84,6 +85,10 @@ bool RestNodeBase::needSaveDatabase() const
  */
 void RestNodeBase::setNeedSaveDatabase(bool needSave)
 {
+    if (needSave && !m_needSaveDatabase)
+    {
+        DB_MarkNodeDirty(this);
+    }
     m_needSaveDatabase = needSave;
 }
 
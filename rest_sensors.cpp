@@ -11,7 +11,6 @@
 #include <QString>
 #include <QTextCodec>
 #include <QTcpSocket>
-#include <QUrlQuery>
 #include <QVariantMap>
 #include <QtCore/qmath.h>
 #include "database.h"
@@ -244,7 +243,12 @@ int DeRestPluginPrivate::getSensor(const ApiRequest &req, ApiResponse &rsp)
     return REQ_READY_SEND;
 }
 
-/*! GET /api/<apikey>/sensors/<id>/data?maxrecords=<maxrecords>&fromtime=<ISO 8601>
+/*! GET /api/<apikey>/sensors/<id>/data?maxrecords=<maxrecords>&fromtime=<ISO 8601>[&totime=<ISO 8601>][&bucket=<seconds>]
+
+    Without bucket the raw samples are returned. With bucket the samples are aggregated
+    per bucket (min, max, avg, sum, last, count) in the history store.
+    For paging the next request uses the last returned "t" as fromtime.
+
     \return REQ_READY_SEND
             REQ_NOT_HANDLED
  */
@@ -267,31 +271,15 @@ int DeRestPluginPrivate::getSensorData(const ApiRequest &req, ApiResponse &rsp)
         return REQ_READY_SEND;
     }
 
-    bool ok;
-    QUrl url(req.hdr.url());
-    QUrlQuery query(url);
+    DB_HistoryQuery historyQuery;
 
-    const int maxRecords = query.queryItemValue(QLatin1String("maxrecords")).toInt(&ok);
-    if (!ok || maxRecords <= 0)
+    if (!historyQueryFromRequest(req, rsp, &historyQuery))
     {
-        rsp.list.append(errorToMap(ERR_INVALID_VALUE, QLatin1String("/maxrecords"), QString("invalid value, %1, for parameter, maxrecords").arg(query.queryItemValue("maxrecords"))));
-        rsp.httpStatus = HttpStatusNotFound;
-        return REQ_READY_SEND;
-    }
-
-    QString t = query.queryItemValue(QLatin1String("fromtime"));
-    QDateTime dt = QDateTime::fromString(t, QLatin1String("yyyy-MM-ddTHH:mm:ss"));
-    if (!dt.isValid())
-    {
-        rsp.list.append(errorToMap(ERR_INVALID_VALUE, QLatin1String("/fromtime"), QString("invalid value, %1, for parameter, fromtime").arg(query.queryItemValue("fromtime"))));
-        rsp.httpStatus = HttpStatusNotFound;
         return REQ_READY_SEND;
     }
 
-    const qint64 fromTime = dt.toMSecsSinceEpoch() / 1000;
-
     openDb();
-    loadSensorDataFromDb(sensor, rsp.list, fromTime, maxRecords);
+    loadSensorDataFromDb(sensor, rsp.list, historyQuery);
     closeDb();
 
     if (rsp.list.isEmpty())
@@ -3025,6 +3013,19 @@ void DeRestPluginPrivate::handleSensorEvent(const Event &e)
         return;
     }
 
+    if (e.what() == REventChanged)
+    {
+        for (int i = 0; i < sensor->itemCount(); i++)
+        {
+            ResourceItem *item = sensor->itemForIndex(static_cast<size_t>(i));
+            if (item && item->isPublic())
+            {
+                notifySensorItemChange(sensor, item);
+            }
+        }
+        return;
+    }
+
     ResourceItem *item = sensor->item(e.what());
     if (!item || !item->isPublic())
     {
@@ -3044,18 +3045,38 @@ void DeRestPluginPrivate::handleSensorEvent(const Event &e)
         globalLastMotion = item->lastSet(); // remember
     }
 
+    if (e.isInChangeSet())
+    {
+        return; // pushed by REventChanged
+    }
+
     if (!(item->needPushSet() || item->needPushChange()))
     {
         return; // already pushed
     }
 
-    if (e.what() == RAttrLastSeen)
+    notifySensorItemChange(sensor, item);
+}
+
+/*! Pushes the websocket "changed" events for \p item, all items with the same
+    parent object (state, config, attr) which need a push are sent along.
+ */
+void DeRestPluginPrivate::notifySensorItemChange(Sensor *sensor, ResourceItem *item)
+{
+    if (!(item->needPushSet() || item->needPushChange()))
+    {
+        return; // already pushed
+    }
+
+    const char *what = item->descriptor().suffix;
+
+    if (what == RAttrLastSeen)
     {
         QVariantMap map;
         map[QLatin1String("t")] = QLatin1String("event");
         map[QLatin1String("e")] = QLatin1String("changed");
         map[QLatin1String("r")] = QLatin1String("sensors");
-        map[QLatin1String("id")] = e.id();
+        map[QLatin1String("id")] = sensor->id();
         map[QLatin1String("uniqueid")] = sensor->uniqueId();
         QVariantMap map1;
         map1[QLatin1String("lastseen")] = item->toString();
@@ -3071,7 +3092,7 @@ void DeRestPluginPrivate::handleSensorEvent(const Event &e)
     QStringList path;  // dummy
     ApiRequest req(hdr, path, nullptr, QLatin1String("")); // dummy
     req.mode = ApiModeNormal;
-    sensorToMap(sensor, smap, req, e.what());
+    sensorToMap(sensor, smap, req, what);
 
     bool pushed = false;
     QVariantMap needPush = smap[QLatin1String("_push")].toMap();
@@ -3081,7 +3102,7 @@ void DeRestPluginPrivate::handleSensorEvent(const Event &e)
         map[QLatin1String("t")] = QLatin1String("event");
         map[QLatin1String("e")] = QLatin1String("changed");
         map[QLatin1String("r")] = QLatin1String("sensors");
-        map[QLatin1String("id")] = e.id();
+        map[QLatin1String("id")] = sensor->id();
         map[QLatin1String("uniqueid")] = sensor->uniqueId();
         map[it.key()] = smap[it.key()];
         webSocketServer->broadcastTextMessage(Json::serialize(map));
@@ -84,15 +84,17 @@ int StateChange::tick(uint64_t extAddr, Resource *r, deCONZ::ApsController *apsC
     {
         m_state = StateFailed;
     }
-    else if (DA_ApsUnconfirmedRequests() > 5)
+    else if (m_state == StateCallFunction && m_changeFunction && !DA_ApsCanAdmit(extAddr, DA_ApsPriorityUser))
     {
-        // wait
+        DA_ApsUserRequestPending(extAddr); // wait, let background traffic yield
     }
     else if (m_state == StateCallFunction && m_changeFunction)
     {
         DBG_Printf(DBG_INFO, "SC tick --> StateCallFunction\n");
+        const uint32_t mark = DA_ApsEnqueueMark();
         if (m_changeFunction(r, this, apsCtrl) == 0)
         {
+            DA_ApsAdmitted(extAddr, mark, DA_ApsPriorityUser);
             for (auto &i : m_items)
             {
                 if (i.verified == VerifyNotSynced)
@@ -105,7 +107,7 @@ int StateChange::tick(uint64_t extAddr, Resource *r, deCONZ::ApsController *apsC
             result = 1;
         }
     }
-    else if (m_state == StateRead && DA_ApsUnconfirmedRequestsForExtAddress(extAddr) == 0)
+    else if (m_state == StateRead && DA_ApsUnconfirmedRequestsForExtAddress(extAddr) == 0 && DA_ApsCanAdmit(extAddr, DA_ApsPriorityNormal))
     {
         ResourceItem *item = nullptr;
         for (auto &i : m_items)
@@ -122,13 +124,15 @@ int StateChange::tick(uint64_t extAddr, Resource *r, deCONZ::ApsController *apsC
         if (item)
         {
             const auto &ddfItem = DDF_GetItem(item);
-            const auto readFunction = DA_GetReadFunction(ddfItem.readParameters);
+            const auto readFunction = ddfItem.params.readFunction;
             if (readFunction && ddfItem.isValid())
             {
+                const uint32_t mark = DA_ApsEnqueueMark();
                 m_readResult = readFunction(r, item, apsCtrl, ddfItem.readParameters);
 
                 if (m_readResult.isEnqueued)
                 {
+                    DA_ApsAdmitted(extAddr, mark, DA_ApsPriorityNormal);
                     DBG_Printf(DBG_INFO, "SC tick --> StateRead %s, %s\n", item->descriptor().suffix, uniqueId);
                     result = 1;
                 }
@@ -253,14 +257,14 @@ int SC_WriteZclAttribute(const Resource *r, const StateChange *stateChange, deCO
             return -1;
         }
 
-        const auto ddfItem = DDF_GetItem(item);
+        const auto &ddfItem = DDF_GetItem(item);
 
         if (ddfItem.writeParameters.isNull())
         {
             return -2;
         }
 
-        const auto fn = DA_GetWriteFunction(ddfItem.writeParameters);
+        const auto fn = ddfItem.params.writeFunction;
 
         if (!fn)
         {
@@ -115,6 +115,11 @@ std::vector<DB_ResourceItem> DB_LoadSubDeviceItems(const QString &/*uniqueId*/)
 }
 
 
+int DB_RestoreZdpDescriptors(const deCONZ::Node *)
+{
+    return 0;
+}
+
 Resource *DEV_InitCompatNodeFromDescription(Device *device, const DeviceDescription::SubDevice &sub, const QString &uniqueId)
 {
     Q_UNUSED(device)
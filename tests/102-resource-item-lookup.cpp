@@ -0,0 +1,61 @@
+#include "catch2/catch.hpp"
+#include "resource.h"
+
+TEST_CASE("102: Resource item lookup", "[Resource]")
+{
+    initResourceDescriptors();
+
+    SECTION("descriptor from suffix string")
+    {
+        ResourceItemDescriptor rid;
+
+        REQUIRE(getResourceItemDescriptor("state/on", rid));
+        REQUIRE(rid.suffix == RStateOn);
+
+        REQUIRE(getResourceItemDescriptor("config/color/ct/startup", rid));
+        REQUIRE(rid.suffix == RConfigColorCtStartup);
+
+        // full path as used in rule conditions
+        REQUIRE(getResourceItemDescriptor("/sensors/12/state/buttonevent", rid));
+        REQUIRE(rid.suffix == RStateButtonEvent);
+
+        REQUIRE(!getResourceItemDescriptor("state/does_not_exist", rid));
+    }
+
+    SECTION("add, lookup and remove items")
+    {
+        Resource r(RSensors);
+
+        REQUIRE(r.item(RStateOn) == nullptr);
+
+        REQUIRE(r.addItem(DataTypeBool, RStateOn));
+        REQUIRE(r.addItem(DataTypeString, RAttrName));
+        REQUIRE(r.addItem(DataTypeInt32, RStateButtonEvent));
+
+        // more items than the initial table size to trigger a rebuild
+        REQUIRE(r.addItem(DataTypeUInt8, RConfigBattery));
+        REQUIRE(r.addItem(DataTypeBool, RConfigReachable));
+        REQUIRE(r.addItem(DataTypeBool, RConfigOn));
+        REQUIRE(r.addItem(DataTypeTime, RStateLastUpdated));
+        REQUIRE(r.addItem(DataTypeString, RAttrUniqueId));
+        REQUIRE(r.itemCount() == 8);
+
+        REQUIRE(r.item(RStateOn)->descriptor().suffix == RStateOn);
+        REQUIRE(r.item(RStateButtonEvent)->descriptor().suffix == RStateButtonEvent);
+        REQUIRE(r.item(RAttrUniqueId)->descriptor().suffix == RAttrUniqueId);
+        REQUIRE(r.item(RStateBri) == nullptr);
+
+        // no double insertion
+        REQUIRE(r.addItem(DataTypeBool, RStateOn) == r.item(RStateOn));
+        REQUIRE(r.itemCount() == 8);
+
+        r.removeItem(RStateOn);
+        REQUIRE(r.itemCount() == 7);
+        REQUIRE(r.item(RStateOn) == nullptr);
+        REQUIRE(r.item(RAttrUniqueId)->descriptor().suffix == RAttrUniqueId);
+
+        Resource copy(r);
+        REQUIRE(copy.item(RConfigBattery) != nullptr);
+        REQUIRE(copy.item(RConfigBattery) != r.item(RConfigBattery));
+    }
+}
@@ -0,0 +1,233 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+#include "utils/timeseries.h"
+
+TEST_CASE("time series varint roundtrip") {
+    const uint64_t values[] = { 0, 1, 127, 128, 300, 0xFFFFFFFF, UINT64_MAX };
+    std::vector<uint8_t> buf;
+
+    for (uint64_t v : values)
+    {
+        TS_PutVarint(buf, v);
+    }
+
+    const uint8_t *p = buf.data();
+    const uint8_t *end = buf.data() + buf.size();
+
+    for (uint64_t v : values)
+    {
+        uint64_t x = 0;
+        REQUIRE(TS_GetVarint(&p, end, &x));
+        REQUIRE(x == v);
+    }
+
+    REQUIRE(p == end);
+
+    uint64_t x;
+    const uint8_t truncated[] = { 0x80, 0x80 };
+    p = truncated;
+    REQUIRE(!TS_GetVarint(&p, truncated + sizeof(truncated), &x));
+}
+
+TEST_CASE("time series append and query") {
+    TS_Store store;
+    const TS_Key key{0x00212EFFFF001234ULL, 0x0402, 0x0000, 1};
+    const int64_t t0 = 1700000000;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        REQUIRE(store.append(key, t0 + i * 60, 2100 + (i % 7) - 3));
+    }
+
+    // older samples are rejected
+    REQUIRE(!store.append(key, t0, 0));
+
+    const TS_Series *series = store.series(key);
+    REQUIRE(series);
+    REQUIRE(series->blocks.size() > 1);
+
+    size_t bytes = 0;
+    for (const TS_Block &b : series->blocks)
+    {
+        bytes += b.data.size();
+    }
+    REQUIRE(bytes < 1000 * 3); // about 2 bytes per sample
+
+    std::vector<TS_Sample> out;
+    REQUIRE(store.query(key, t0, t0 + 999 * 60, 5000, &out) == 1000);
+    REQUIRE(out.front().t == t0);
+    REQUIRE(out.front().value == 2100 - 3);
+    REQUIRE(out.back().t == t0 + 999 * 60);
+
+    out.clear();
+    REQUIRE(store.query(key, t0 + 60, t0 + 180, 5000, &out) == 3);
+    REQUIRE(out[0].value == 2100 + 1 - 3);
+
+    out.clear();
+    REQUIRE(store.query(key, t0, t0 + 999 * 60, 10, &out) == 10);
+
+    std::vector<TS_Rollup> rollups;
+    REQUIRE(store.queryRollups(key, t0, t0 + 999 * 60, &rollups) > 0);
+    uint32_t count = 0;
+    for (const TS_Rollup &r : rollups)
+    {
+        REQUIRE(r.min <= r.max);
+        count += r.count;
+    }
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("time series load persisted blocks and expire") {
+    TS_Store a;
+    const TS_Key key{0x1ULL, 0x0006, 0x0000, 1};
+    const int64_t t0 = 1700000000;
+
+    for (int i = 0; i < 600; i++)
+    {
+        a.append(key, t0 + i * 100, i & 1);
+    }
+
+    TS_Store b;
+    // a sample arrived before the history was loaded
+    b.append(key, t0 + 600 * 100, 1);
+
+    for (const TS_Block &block : a.series(key)->blocks)
+    {
+        REQUIRE(b.loadBlock(key, block.t0, block.data.data(), block.data.size()));
+        REQUIRE(!b.loadBlock(key, block.t0, block.data.data(), block.data.size()));
+    }
+
+    std::vector<TS_Sample> out;
+    REQUIRE(b.query(key, t0, t0 + 600 * 100, 5000, &out) == 601);
+
+    for (size_t i = 1; i < out.size(); i++)
+    {
+        REQUIRE(out[i - 1].t < out[i].t);
+    }
+
+    b.expire(t0 + 600 * 100);
+    out.clear();
+    REQUIRE(b.query(key, t0, t0 + 600 * 100, 5000, &out) == 1);
+
+    b.expire(t0 + 600 * 100 + 1);
+    REQUIRE(b.series(key) == nullptr);
+}
+
+TEST_CASE("time series import history after live samples") {
+    TS_Store store;
+    const TS_Key key{0x3ULL, 0x0402, 0x0000, 1};
+    const int64_t t0 = 1700000000;
+    const int64_t now = t0 + 500 * 60;
+
+    // live samples were appended before the legacy history was imported
+    REQUIRE(store.append(key, now, 2300));
+    REQUIRE(store.append(key, now + 60, 2310));
+
+    std::vector<TS_Sample> history;
+    for (int i = 0; i < 500; i++)
+    {
+        history.push_back(TS_Sample{t0 + i * 60, 2000 + i});
+    }
+
+    REQUIRE(store.insert(key, history) == 500);
+
+    std::vector<TS_Sample> out;
+    REQUIRE(store.query(key, t0, now + 60, 5000, &out) == 502);
+    REQUIRE(out.front().t == t0);
+    REQUIRE(out.front().value == 2000);
+    REQUIRE(out[499].value == 2000 + 499);
+    REQUIRE(out.back().value == 2310);
+
+    for (size_t i = 1; i < out.size(); i++)
+    {
+        REQUIRE(out[i - 1].t < out[i].t);
+    }
+
+    // imported blocks are persisted, live samples continue in the newest block
+    const TS_Series *series = store.series(key);
+    REQUIRE(series);
+    for (const TS_Block &b : series->blocks)
+    {
+        REQUIRE(b.dirty);
+    }
+    REQUIRE(!series->blocks.back().sealed);
+
+    std::vector<TS_Rollup> rollups;
+    store.queryRollups(key, t0, now + 60, &rollups);
+    uint32_t count = 0;
+    for (const TS_Rollup &r : rollups)
+    {
+        count += r.count;
+    }
+    REQUIRE(count == 502);
+
+    REQUIRE(store.append(key, now + 120, 2320));
+}
+
+TEST_CASE("time series aggregate buckets") {
+    TS_Store store;
+    const TS_Key key{0x2ULL, 0x0B04, 0x050B, 1};
+    const int64_t t0 = 1700000000 - (1700000000 % 86400); // midnight
+
+    // 10 second power readings over two days
+    for (int64_t t = t0; t < t0 + 2 * 86400; t += 10)
+    {
+        REQUIRE(store.append(key, t, (t / 10) % 100));
+    }
+
+    std::vector<TS_Rollup> days;
+    REQUIRE(store.aggregate(key, t0, t0 + 2 * 86400, 86400, 100, &days) == 2);
+    REQUIRE(days[0].t == t0);
+    REQUIRE(days[0].count == 8640);
+    REQUIRE(days[0].min == 0);
+    REQUIRE(days[0].max == 99);
+    REQUIRE(days[1].tLast == t0 + 2 * 86400 - 10);
+
+    // raw path must match the rollup path
+    std::vector<TS_Rollup> minutes;
+    REQUIRE(store.aggregate(key, t0, t0 + 86400 - 1, 60, 100000, &minutes) == 1440);
+    int64_t sum = 0;
+    uint32_t count = 0;
+    for (const TS_Rollup &r : minutes)
+    {
+        REQUIRE(r.count == 6);
+        sum += r.sum;
+        count += r.count;
+    }
+    REQUIRE(count == days[0].count);
+    REQUIRE(sum == days[0].sum);
+    REQUIRE(minutes.back().last == days[0].last);
+
+    // paging
+    std::vector<TS_Rollup> page;
+    REQUIRE(store.aggregate(key, t0, t0 + 86400, 60, 10, &page) == 10);
+    REQUIRE(page.back().t == t0 + 9 * 60);
+}
+
+TEST_CASE("time series aggregate clips rollups to the range") {
+    TS_Store store;
+    const TS_Key key{0x4ULL, 0x0B04, 0x050B, 1};
+    const int64_t t0 = 1700000000 - (1700000000 % 86400); // midnight
+
+    for (int64_t t = t0; t < t0 + 86400; t += 60)
+    {
+        REQUIRE(store.append(key, t, 1));
+    }
+
+    // 00:30 - 02:29:59, the partial hours at the edges come from raw samples
+    std::vector<TS_Rollup> hours;
+    REQUIRE(store.aggregate(key, t0 + 1800, t0 + 3 * 3600 - 1801, 3600, 100, &hours) == 3);
+    REQUIRE(hours[0].t == t0);
+    REQUIRE(hours[0].count == 30);
+    REQUIRE(hours[1].count == 60);
+    REQUIRE(hours[2].t == t0 + 2 * 3600);
+    REQUIRE(hours[2].count == 30);
+
+    // range within a single rollup
+    std::vector<TS_Rollup> part;
+    REQUIRE(store.aggregate(key, t0 + 600, t0 + 1199, 86400, 100, &part) == 1);
+    REQUIRE(part[0].count == 10);
+    REQUIRE(part[0].t == t0);
+}
@@ -0,0 +1,78 @@
+#include <cstring>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+#include "utils/snapshot.h"
+
+TEST_CASE("snapshot crc32") {
+    const char *str = "123456789";
+    REQUIRE(SNAP_Crc32(reinterpret_cast<const uint8_t*>(str), strlen(str)) == 0xCBF43926);
+}
+
+TEST_CASE("snapshot write and read") {
+    const uint64_t stamp = 0x1234567890ULL;
+    SNAP_Writer w;
+
+    w.addResource("/sensors", "00:21:2e:ff:ff:00:12:34-01-0402");
+    w.addItem("state/temperature", "2150", 4, 1700000000123LL);
+    w.addItem("config/battery", "87", 2, 1700000000000LL);
+    w.addResource("/lights", "00:17:88:01:02:03:04:05-0b");
+    w.addItem("state/on", "true", 4, 1700000001000LL);
+    w.addItem("state/empty", "", 0, 1700000001000LL);
+
+    REQUIRE(w.itemCount() == 4);
+
+    const std::vector<uint8_t> data = w.finish(stamp);
+
+    std::vector<SNAP_Item> items;
+    REQUIRE(SNAP_Read(data.data(), data.size(), stamp, &items));
+    REQUIRE(items.size() == 4);
+
+    REQUIRE(strcmp(items[0].prefix, "/sensors") == 0);
+    REQUIRE(strcmp(items[0].uniqueId, "00:21:2e:ff:ff:00:12:34-01-0402") == 0);
+    REQUIRE(strcmp(items[0].suffix, "state/temperature") == 0);
+    REQUIRE(strcmp(items[0].value, "2150") == 0);
+    REQUIRE(items[0].valueSize == 4);
+    REQUIRE(items[0].timestampMs == 1700000000123LL);
+
+    REQUIRE(strcmp(items[2].prefix, "/lights") == 0);
+    REQUIRE(strcmp(items[2].suffix, "state/on") == 0);
+    REQUIRE(items[3].valueSize == 0);
+    REQUIRE(items[3].value[0] == '\0');
+}
+
+TEST_CASE("snapshot rejects invalid data") {
+    const uint64_t stamp = 42;
+    SNAP_Writer w;
+    w.addResource("/sensors", "00:21:2e:ff:ff:00:12:34-01-0402");
+    w.addItem("state/temperature", "2150", 4, 1700000000123LL);
+
+    const std::vector<uint8_t> data = w.finish(stamp);
+    std::vector<SNAP_Item> items;
+
+    // database changed since the snapshot was written
+    REQUIRE(!SNAP_Read(data.data(), data.size(), stamp + 1, &items));
+    REQUIRE(items.empty());
+
+    // truncated
+    REQUIRE(!SNAP_Read(data.data(), data.size() - 1, stamp, &items));
+    REQUIRE(!SNAP_Read(data.data(), 10, stamp, &items));
+
+    // corrupted payload
+    std::vector<uint8_t> bad = data;
+    bad[SNAP_HEADER_SIZE + 5] ^= 0x01;
+    REQUIRE(!SNAP_Read(bad.data(), bad.size(), stamp, &items));
+
+    // other version
+    bad = data;
+    bad[4] = SNAP_VERSION + 1;
+    REQUIRE(!SNAP_Read(bad.data(), bad.size(), stamp, &items));
+
+    // items without a resource are ignored by the writer
+    SNAP_Writer w2;
+    w2.addItem("state/on", "true", 4, 0);
+    const std::vector<uint8_t> empty = w2.finish(stamp);
+    REQUIRE(SNAP_Read(empty.data(), empty.size(), stamp, &items));
+    REQUIRE(items.empty());
+}
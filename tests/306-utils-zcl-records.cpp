@@ -0,0 +1,115 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+#include "utils/zcl_records.h"
+
+TEST_CASE("zcl data type sizes") {
+    const uint8_t str[] = { 0x03, 'a', 'b', 'c' };
+    const uint8_t longStr[] = { 0x02, 0x00, 'a', 'b' };
+
+    REQUIRE(ZCL_DataTypeSize(0x10, nullptr, 1) == 1); // bool
+    REQUIRE(ZCL_DataTypeSize(0x21, nullptr, 2) == 2); // uint16
+    REQUIRE(ZCL_DataTypeSize(0x25, nullptr, 6) == 6); // uint48
+    REQUIRE(ZCL_DataTypeSize(0x2b, nullptr, 4) == 4); // int32
+    REQUIRE(ZCL_DataTypeSize(0x1f, nullptr, 8) == 8); // bitmap64
+    REQUIRE(ZCL_DataTypeSize(0xf0, nullptr, 8) == 8); // IEEE address
+    REQUIRE(ZCL_DataTypeSize(0x42, str, sizeof(str)) == 4);
+    REQUIRE(ZCL_DataTypeSize(0x44, longStr, sizeof(longStr)) == 4);
+
+    REQUIRE(ZCL_DataTypeSize(0x21, nullptr, 1) == -1); // truncated
+    REQUIRE(ZCL_DataTypeSize(0x42, str, 3) == -1); // truncated
+    REQUIRE(ZCL_DataTypeSize(0x4c, nullptr, 100) == -1); // structure
+}
+
+TEST_CASE("zcl index report attributes") {
+    // temperature 21.50 °C, battery 87 %, model id "abc"
+    const uint8_t payload[] = { 0x00, 0x00, 0x29, 0x66, 0x08,
+                                0x21, 0x00, 0x20, 0x57,
+                                0x05, 0x00, 0x42, 0x03, 'a', 'b', 'c' };
+
+    std::vector<ZCL_AttributeRecord> records;
+    REQUIRE(ZCL_IndexAttributeRecords(payload, sizeof(payload), false, &records) == ZCL_RecordsOk);
+    REQUIRE(records.size() == 3);
+
+    REQUIRE(records[0].id == 0x0000);
+    REQUIRE(records[0].dataType == 0x29);
+    REQUIRE(records[0].offset == 3);
+    REQUIRE(records[0].size == 2);
+
+    REQUIRE(records[1].id == 0x0021);
+    REQUIRE(payload[records[1].offset] == 0x57);
+
+    REQUIRE(records[2].id == 0x0005);
+    REQUIRE(records[2].offset == 12);
+    REQUIRE(records[2].size == 4);
+    REQUIRE(records[2].index == 2);
+
+    // last record truncated
+    REQUIRE(ZCL_IndexAttributeRecords(payload, sizeof(payload) - 1, false, &records) == ZCL_RecordsTruncated);
+    REQUIRE(records.size() == 2);
+}
+
+TEST_CASE("zcl index read attributes response") {
+    // 0x0004 unsupported attribute, 0x0005 "ab", 0x0006 array
+    const uint8_t payload[] = { 0x04, 0x00, 0x86,
+                                0x05, 0x00, 0x00, 0x42, 0x02, 'a', 'b',
+                                0x06, 0x00, 0x00, 0x48, 0x20, 0x01, 0x00, 0x01 };
+
+    std::vector<ZCL_AttributeRecord> records;
+    REQUIRE(ZCL_IndexAttributeRecords(payload, sizeof(payload), true, &records) == ZCL_RecordsUnsupported);
+    REQUIRE(records.size() == 2);
+
+    REQUIRE(records[0].id == 0x0004);
+    REQUIRE(records[0].status == 0x86);
+    REQUIRE(records[0].size == 0);
+
+    REQUIRE(records[1].id == 0x0005);
+    REQUIRE(records[1].status == 0x00);
+    REQUIRE(records[1].index == 1);
+    REQUIRE(records[1].size == 3);
+
+    REQUIRE(ZCL_IndexAttributeRecords(payload, 10, true, &records) == ZCL_RecordsOk);
+    REQUIRE(records.size() == 2);
+}
+
+TEST_CASE("zcl index xiaomi special attribute") {
+    // 0x0005 "ab" in front, 0xff01 with battery 3005 mV (tag 0x01) and temperature 21.50 °C (tag 0x64)
+    const uint8_t ff01[] = { 0x05, 0x00, 0x42, 0x02, 'a', 'b',
+                             0x01, 0xff, 0x42, 0x08,
+                             0x01, 0x21, 0xbd, 0x0b,
+                             0x64, 0x29, 0x66, 0x08 };
+
+    uint16_t attrId;
+    std::vector<ZCL_AttributeRecord> records;
+    REQUIRE(ZCL_IndexXiaomiTags(ff01, sizeof(ff01), &attrId, &records) == ZCL_RecordsOk);
+    REQUIRE(attrId == 0xff01);
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].id == 0x01);
+    REQUIRE(records[0].dataType == 0x21);
+    REQUIRE(records[0].offset == 12);
+    REQUIRE(records[1].id == 0x64);
+    REQUIRE(records[1].index == 1);
+    REQUIRE(records[1].size == 2);
+
+    REQUIRE(ZCL_IndexXiaomiTags(ff01, sizeof(ff01) - 1, &attrId, &records) == ZCL_RecordsTruncated);
+    REQUIRE(records.size() == 1);
+
+    // 0xff02 structure, elements are numbered
+    const uint8_t ff02[] = { 0x02, 0xff, 0x4c, 0x02, 0x00,
+                             0x10, 0x01,
+                             0x21, 0xbd, 0x0b };
+
+    REQUIRE(ZCL_IndexXiaomiTags(ff02, sizeof(ff02), &attrId, &records) == ZCL_RecordsOk);
+    REQUIRE(attrId == 0xff02);
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].id == 0);
+    REQUIRE(records[1].id == 1);
+    REQUIRE(records[1].offset == 8);
+
+    // no special attribute
+    const uint8_t other[] = { 0x05, 0x00, 0x42, 0x02, 'a', 'b' };
+    REQUIRE(ZCL_IndexXiaomiTags(other, sizeof(other), &attrId, &records) == ZCL_RecordsOk);
+    REQUIRE(attrId == 0);
+    REQUIRE(records.empty());
+}
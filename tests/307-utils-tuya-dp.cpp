@@ -0,0 +1,75 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+#include "utils/tuya_dp.h"
+
+TEST_CASE("tuya frame with multiple datapoints") {
+    const uint8_t payload[] = {
+        0x00, 0x4c,                               // seq
+        0x02, 0x02, 0x00, 0x04, 0xff, 0xff, 0xff, 0xce, // dp 2 value -50
+        0x01, 0x01, 0x00, 0x01, 0x01,             // dp 1 bool true
+        0x10, 0x00, 0x00, 0x03, 0xaa, 0xbb, 0xcc, // dp 16 raw
+        0x04, 0x04, 0x00, 0x01, 0x02,             // dp 4 enum 2
+        0x05, 0x05, 0x00, 0x02, 0x01, 0x02,       // dp 5 bitmap 0x0102
+        0x11, 0x03, 0x00, 0x02, 'h', 'i'          // dp 17 string
+    };
+
+    TY_Frame frame;
+    REQUIRE(TY_DecodeFrame(payload, sizeof(payload), &frame));
+    REQUIRE(frame.seq == 0x004c);
+    REQUIRE(frame.count == 6);
+    REQUIRE(frame.truncated == 0);
+
+    REQUIRE(frame.dp[0].dpid == 2);
+    REQUIRE(frame.dp[0].type == TY_TYPE_VALUE);
+    REQUIRE(frame.dp[0].hasValue == 1);
+    REQUIRE(frame.dp[0].value == -50);
+
+    REQUIRE(frame.dp[1].value == 1);
+
+    // raw data is skipped by its length
+    REQUIRE(frame.dp[2].hasValue == 0);
+    REQUIRE(frame.dp[2].offset == 19);
+    REQUIRE(frame.dp[2].length == 3);
+
+    REQUIRE(frame.dp[3].value == 2);
+    REQUIRE(frame.dp[4].value == 0x0102);
+    REQUIRE(frame.dp[5].hasValue == 0);
+    REQUIRE(frame.dp[5].index == 5);
+
+    REQUIRE(TY_FindDatapoint(frame, 4, 0) == &frame.dp[3]);
+    REQUIRE(TY_FindDatapoint(frame, 4, 4) == nullptr);
+    REQUIRE(TY_FindDatapoint(frame, 99, 0) == nullptr);
+}
+
+TEST_CASE("tuya frame malformed") {
+    TY_Frame frame;
+
+    const uint8_t tooShort[] = { 0x00, 0x01, 0x02, 0x02, 0x00 };
+    REQUIRE(!TY_DecodeFrame(tooShort, sizeof(tooShort), &frame));
+    REQUIRE(frame.count == 0);
+
+    // second datapoint is cut off
+    const uint8_t truncated[] = {
+        0x00, 0x01,
+        0x01, 0x01, 0x00, 0x01, 0x00,
+        0x02, 0x02, 0x00, 0x04, 0x00, 0x00
+    };
+    REQUIRE(TY_DecodeFrame(truncated, sizeof(truncated), &frame));
+    REQUIRE(frame.count == 1);
+    REQUIRE(frame.truncated == 1);
+    REQUIRE(frame.dp[0].value == 0);
+
+    // more datapoints than fit into the frame
+    std::vector<uint8_t> many = { 0x00, 0x02 };
+    for (unsigned i = 0; i < TY_MAX_DATAPOINTS + 2; i++)
+    {
+        const uint8_t dp[] = { uint8_t(i + 1), TY_TYPE_ENUM, 0x00, 0x01, uint8_t(i) };
+        many.insert(many.end(), dp, dp + sizeof(dp));
+    }
+    REQUIRE(TY_DecodeFrame(many.data(), many.size(), &frame));
+    REQUIRE(frame.count == TY_MAX_DATAPOINTS);
+    REQUIRE(frame.truncated == 1);
+    REQUIRE(frame.dp[TY_MAX_DATAPOINTS - 1].value == TY_MAX_DATAPOINTS - 1);
+}
@@ -0,0 +1,73 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+#include "utils/latency.h"
+
+TEST_CASE("latency histogram buckets and percentiles") {
+    LAT_Histogram hist;
+
+    REQUIRE(LAT_Percentile(hist, 50) == 0);
+
+    for (int i = 0; i < 90; i++)
+    {
+        LAT_Add(&hist, 10); // bucket 3: 8..15 us
+    }
+
+    for (int i = 0; i < 10; i++)
+    {
+        LAT_Add(&hist, 1000); // bucket 9: 512..1023 us
+    }
+
+    REQUIRE(hist.count == 100);
+    REQUIRE(hist.totalUs == 90 * 10 + 10 * 1000);
+    REQUIRE(hist.maxUs == 1000);
+    REQUIRE(hist.buckets[0] == 0);
+    REQUIRE(hist.buckets[3] == 90);
+    REQUIRE(hist.buckets[9] == 10);
+
+    REQUIRE(LAT_Percentile(hist, 50) == 15);
+    REQUIRE(LAT_Percentile(hist, 90) == 15);
+    REQUIRE(LAT_Percentile(hist, 91) == 1000); // capped by max
+    REQUIRE(LAT_Percentile(hist, 100) == 1000);
+
+    LAT_Add(&hist, 0);
+    LAT_Add(&hist, -5);
+    REQUIRE(hist.buckets[0] == 2);
+
+    LAT_Add(&hist, 60LL * 1000 * 1000); // a minute ends up in the last bucket
+    REQUIRE(hist.buckets[LAT_BUCKETS - 1] == 1);
+
+    LAT_Histogram sum;
+    LAT_Merge(&sum, hist);
+    LAT_Merge(&sum, hist);
+    REQUIRE(sum.count == 2 * hist.count);
+    REQUIRE(sum.buckets[3] == 180);
+    REQUIRE(sum.maxUs == hist.maxUs);
+}
+
+TEST_CASE("latency stats per stage and cluster") {
+    LAT_Reset();
+
+    LAT_SetCluster(0x0402);
+    LAT_Record(LAT_StageDdfParse, LAT_NowUs());
+    LAT_Record(LAT_StageDdfParse, LAT_NowUs());
+    LAT_Record(LAT_StageDeviceLookup, LAT_NowUs());
+    LAT_SetCluster(LAT_NO_CLUSTER);
+    LAT_Record(LAT_StageWebsocket, LAT_NowUs());
+
+    std::vector<LAT_Entry> entries;
+    LAT_GetStats(&entries);
+    REQUIRE(entries.size() == 3);
+
+    REQUIRE(entries[0].stage == LAT_StageDeviceLookup);
+    REQUIRE(entries[1].stage == LAT_StageDdfParse);
+    REQUIRE(entries[1].clusterId == 0x0402);
+    REQUIRE(entries[1].hist.count == 2);
+    REQUIRE(entries[2].stage == LAT_StageWebsocket);
+    REQUIRE(entries[2].clusterId == LAT_NO_CLUSTER);
+
+    LAT_Reset();
+    LAT_GetStats(&entries);
+    REQUIRE(entries.empty());
+}
@@ -0,0 +1,98 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+#include "utils/aps_capture.h"
+
+TEST_CASE("aps capture write and read records") {
+    std::vector<uint8_t> buf;
+    CAP_WriteHeader(&buf);
+    REQUIRE(buf.size() == CAP_HEADER_SIZE);
+
+    CAP_Record rec;
+    rec.timeMs = 123456;
+    rec.srcAddrMode = 3;
+    rec.srcNwk = 0x1a2b;
+    rec.srcExt = 0x00158d0001020304;
+    rec.dstAddrMode = 2;
+    rec.dstAddr = 0x0000;
+    rec.srcEndpoint = 0x01;
+    rec.dstEndpoint = 0x01;
+    rec.profileId = 0x0104;
+    rec.clusterId = 0x0402;
+    rec.lqi = 200;
+    rec.rssi = -67;
+    rec.asdu = { 0x18, 0x05, 0x0a, 0x00, 0x00, 0x29, 0x2c, 0x09 };
+    CAP_WriteRecord(&buf, rec);
+
+    CAP_Record rec2;
+    rec2.timeMs = 123500;
+    rec2.clusterId = 0x0006;
+    CAP_WriteRecord(&buf, rec2); // empty asdu
+
+    size_t pos = 0;
+    REQUIRE(CAP_ReadHeader(buf.data(), buf.size(), &pos) == CAP_Ok);
+    REQUIRE(pos == CAP_HEADER_SIZE);
+
+    CAP_Record out;
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_Ok);
+    REQUIRE(out.timeMs == rec.timeMs);
+    REQUIRE(out.srcAddrMode == rec.srcAddrMode);
+    REQUIRE(out.srcNwk == rec.srcNwk);
+    REQUIRE(out.srcExt == rec.srcExt);
+    REQUIRE(out.dstAddrMode == rec.dstAddrMode);
+    REQUIRE(out.profileId == rec.profileId);
+    REQUIRE(out.clusterId == rec.clusterId);
+    REQUIRE(out.lqi == rec.lqi);
+    REQUIRE(out.rssi == rec.rssi);
+    REQUIRE(out.asdu == rec.asdu);
+
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_Ok);
+    REQUIRE(out.timeMs == rec2.timeMs);
+    REQUIRE(out.clusterId == 0x0006);
+    REQUIRE(out.asdu.empty());
+
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_End);
+}
+
+TEST_CASE("aps capture malformed files") {
+    size_t pos = 0;
+
+    const uint8_t notCapture[] = { 'D', 'C', 'A', 'X', CAP_VERSION, 0, 0, 0 };
+    REQUIRE(CAP_ReadHeader(notCapture, sizeof(notCapture), &pos) == CAP_Invalid);
+
+    const uint8_t newerVersion[] = { 'D', 'C', 'A', 'P', CAP_VERSION + 1, 0, 0, 0 };
+    REQUIRE(CAP_ReadHeader(newerVersion, sizeof(newerVersion), &pos) == CAP_Invalid);
+
+    std::vector<uint8_t> buf;
+    CAP_WriteHeader(&buf);
+    CAP_Record rec;
+    rec.asdu = { 0x01, 0x02, 0x03 };
+    CAP_WriteRecord(&buf, rec);
+
+    // capture interrupted while writing the last record
+    buf.pop_back();
+    REQUIRE(CAP_ReadHeader(buf.data(), buf.size(), &pos) == CAP_Ok);
+    CAP_Record out;
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_Truncated);
+
+    // asdu length exceeds the record
+    buf.push_back(0x03);
+    buf[CAP_HEADER_SIZE + 2 + 26] = 0xff;
+    pos = CAP_HEADER_SIZE;
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_Invalid);
+
+    // fields appended by a later version are skipped
+    buf.clear();
+    CAP_WriteHeader(&buf);
+    CAP_WriteRecord(&buf, rec);
+    buf[CAP_HEADER_SIZE] += 2;
+    buf.push_back(0xaa);
+    buf.push_back(0xbb);
+    CAP_WriteRecord(&buf, rec);
+    pos = CAP_HEADER_SIZE;
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_Ok);
+    REQUIRE(out.asdu == rec.asdu);
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_Ok);
+    REQUIRE(CAP_ReadRecord(buf.data(), buf.size(), &pos, &out) == CAP_End);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include "aps_capture.h"
+
+#define CAP_FIXED_SIZE 28 // record fields before the asdu, without the length
+
+static void CAP_Put(std::vector<uint8_t> *buf, uint64_t val, unsigned size)
+{
+    for (unsigned i = 0; i < size; i++)
+    {
+        buf->push_back(uint8_t(val >> (i * 8)));
+    }
+}
+
+static uint64_t CAP_Get(const uint8_t *data, unsigned size)
+{
+    uint64_t val = 0;
+
+    for (unsigned i = size; i > 0; i--)
+    {
+        val = (val << 8) | data[i - 1];
+    }
+
+    return val;
+}
+
+void CAP_WriteHeader(std::vector<uint8_t> *buf)
+{
+    const uint8_t header[CAP_HEADER_SIZE] = { 'D', 'C', 'A', 'P', CAP_VERSION, 0, 0, 0 };
+    buf->insert(buf->end(), header, header + sizeof(header));
+}
+
+/*! Appends \p rec to \p buf, the asdu is cut at CAP_MAX_ASDU bytes.
+ */
+void CAP_WriteRecord(std::vector<uint8_t> *buf, const CAP_Record &rec)
+{
+    const size_t asduLength = rec.asdu.size() < CAP_MAX_ASDU ? rec.asdu.size() : CAP_MAX_ASDU;
+
+    CAP_Put(buf, CAP_FIXED_SIZE + asduLength, 2);
+    CAP_Put(buf, rec.timeMs, 4);
+    CAP_Put(buf, rec.srcAddrMode, 1);
+    CAP_Put(buf, rec.srcNwk, 2);
+    CAP_Put(buf, rec.srcExt, 8);
+    CAP_Put(buf, rec.dstAddrMode, 1);
+    CAP_Put(buf, rec.dstAddr, 2);
+    CAP_Put(buf, rec.srcEndpoint, 1);
+    CAP_Put(buf, rec.dstEndpoint, 1);
+    CAP_Put(buf, rec.profileId, 2);
+    CAP_Put(buf, rec.clusterId, 2);
+    CAP_Put(buf, rec.lqi, 1);
+    CAP_Put(buf, uint8_t(rec.rssi), 1);
+    CAP_Put(buf, asduLength, 2);
+    buf->insert(buf->end(), rec.asdu.begin(), rec.asdu.begin() + asduLength);
+}
+
+/*! Verifies the file header and sets \p pos to the first record.
+ */
+CAP_Result CAP_ReadHeader(const uint8_t *data, size_t size, size_t *pos)
+{
+    if (!data || size < CAP_HEADER_SIZE)
+    {
+        return CAP_Invalid;
+    }
+
+    if (data[0] != 'D' || data[1] != 'C' || data[2] != 'A' || data[3] != 'P')
+    {
+        return CAP_Invalid;
+    }
+
+    if (data[4] == 0 || data[4] > CAP_VERSION)
+    {
+        return CAP_Invalid;
+    }
+
+    *pos = CAP_HEADER_SIZE;
+    return CAP_Ok;
+}
+
+/*! Reads the record at \p pos into \p rec and advances \p pos to the next one.
+ */
+CAP_Result CAP_ReadRecord(const uint8_t *data, size_t size, size_t *pos, CAP_Record *rec)
+{
+    if (*pos >= size)
+    {
+        return CAP_End;
+    }
+
+    if (size - *pos < 2)
+    {
+        return CAP_Truncated;
+    }
+
+    const size_t length = size_t(CAP_Get(&data[*pos], 2));
+    const uint8_t *p = &data[*pos + 2];
+
+    if (size - *pos - 2 < length)
+    {
+        return CAP_Truncated;
+    }
+
+    if (length < CAP_FIXED_SIZE)
+    {
+        return CAP_Invalid;
+    }
+
+    const size_t asduLength = size_t(CAP_Get(&p[26], 2));
+
+    if (CAP_FIXED_SIZE + asduLength > length)
+    {
+        return CAP_Invalid;
+    }
+
+    rec->timeMs = uint32_t(CAP_Get(&p[0], 4));
+    rec->srcAddrMode = p[4];
+    rec->srcNwk = uint16_t(CAP_Get(&p[5], 2));
+    rec->srcExt = CAP_Get(&p[7], 8);
+    rec->dstAddrMode = p[15];
+    rec->dstAddr = uint16_t(CAP_Get(&p[16], 2));
+    rec->srcEndpoint = p[18];
+    rec->dstEndpoint = p[19];
+    rec->profileId = uint16_t(CAP_Get(&p[20], 2));
+    rec->clusterId = uint16_t(CAP_Get(&p[22], 2));
+    rec->lqi = p[24];
+    rec->rssi = int8_t(p[25]);
+    rec->asdu.assign(&p[CAP_FIXED_SIZE], &p[CAP_FIXED_SIZE] + asduLength);
+
+    *pos += 2 + length;
+    return CAP_Ok;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#ifndef APS_CAPTURE_H
+#define APS_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! File format to record APS data indications and replay them later.
+
+    Header:  magic "DCAP", version (U8), 3 reserved bytes
+    Record:  length (U16) of the following fields
+             time (U32) ms since the start of the capture
+             srcAddrMode (U8), srcNwk (U16), srcExt (U64)
+             dstAddrMode (U8), dstAddr (U16) group or nwk address
+             srcEndpoint (U8), dstEndpoint (U8), profileId (U16), clusterId (U16)
+             lqi (U8), rssi (S8), asdu length (U16), asdu
+
+    All numbers are little endian. Fields added in later versions are appended after the
+    asdu and skipped by older readers via the record length.
+ */
+
+#define CAP_VERSION 1
+#define CAP_HEADER_SIZE 8
+#define CAP_MAX_ASDU 1024
+
+struct CAP_Record
+{
+    uint32_t timeMs = 0;
+    uint64_t srcExt = 0;
+    uint16_t srcNwk = 0;
+    uint16_t dstAddr = 0;
+    uint16_t profileId = 0;
+    uint16_t clusterId = 0;
+    uint8_t srcAddrMode = 0;
+    uint8_t dstAddrMode = 0;
+    uint8_t srcEndpoint = 0;
+    uint8_t dstEndpoint = 0;
+    uint8_t lqi = 0;
+    int8_t rssi = 0;
+    std::vector<uint8_t> asdu;
+};
+
+enum CAP_Result
+{
+    CAP_Ok,
+    CAP_End,        // no more records
+    CAP_Truncated,  // incomplete record at the end, e.g. capture was interrupted
+    CAP_Invalid     // not a capture file or unsupported version
+};
+
+void CAP_WriteHeader(std::vector<uint8_t> *buf);
+void CAP_WriteRecord(std::vector<uint8_t> *buf, const CAP_Record &rec);
+CAP_Result CAP_ReadHeader(const uint8_t *data, size_t size, size_t *pos);
+CAP_Result CAP_ReadRecord(const uint8_t *data, size_t size, size_t *pos, CAP_Record *rec);
+
+#endif // APS_CAPTURE_H
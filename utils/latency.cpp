@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include "latency.h"
+
+static uint16_t latCluster = LAT_NO_CLUSTER;
+static std::unordered_map<uint32_t, LAT_Histogram> latStats; // key: stage << 16 | cluster
+
+/*! Monotonic time in microseconds. */
+int64_t LAT_NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static unsigned LAT_Bucket(uint64_t us)
+{
+    unsigned bucket = 0;
+
+    while (us > 1 && bucket < LAT_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void LAT_Add(LAT_Histogram *hist, int64_t us)
+{
+    if (us < 0)
+    {
+        us = 0; // clock adjusted, shouldn't happen with a steady clock
+    }
+
+    hist->count++;
+    hist->totalUs += uint64_t(us);
+    hist->maxUs = std::max(hist->maxUs, uint32_t(std::min<int64_t>(us, UINT32_MAX)));
+    hist->buckets[LAT_Bucket(uint64_t(us))]++;
+}
+
+void LAT_Merge(LAT_Histogram *hist, const LAT_Histogram &other)
+{
+    hist->count += other.count;
+    hist->totalUs += other.totalUs;
+    hist->maxUs = std::max(hist->maxUs, other.maxUs);
+
+    for (unsigned i = 0; i < LAT_BUCKETS; i++)
+    {
+        hist->buckets[i] += other.buckets[i];
+    }
+}
+
+/*! Returns the upper bound in microseconds of the bucket which contains the \p percent percentile.
+    The result is capped by the maximum recorded latency.
+ */
+uint32_t LAT_Percentile(const LAT_Histogram &hist, unsigned percent)
+{
+    if (hist.count == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t rank = (uint64_t(hist.count) * std::min(percent, 100U) + 99) / 100;
+    uint64_t n = 0;
+
+    for (unsigned i = 0; i < LAT_BUCKETS - 1; i++)
+    {
+        n += hist.buckets[i];
+        if (n >= rank && n > 0)
+        {
+            return std::min(uint32_t(2U << i) - 1, hist.maxUs);
+        }
+    }
+
+    return hist.maxUs;
+}
+
+const char *LAT_StageName(LAT_Stage stage)
+{
+    switch (stage)
+    {
+    case LAT_StageDeviceLookup: return "devicelookup";
+    case LAT_StageZclDecode: return "zcldecode";
+    case LAT_StageDdfParse: return "ddfparse";
+    case LAT_StageLegacyHandler: return "legacyhandler";
+    case LAT_StageEventEnqueue: return "eventenqueue";
+    case LAT_StageEventProcess: return "eventprocess";
+    case LAT_StageWebsocket: return "websocket";
+    case LAT_StageDbQueue: return "dbqueue";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+/*! Sets the cluster of the indication being processed, stages recorded until the next call are attributed to it.
+    Use LAT_NO_CLUSTER when the indication is done.
+ */
+void LAT_SetCluster(uint16_t clusterId)
+{
+    latCluster = clusterId;
+}
+
+/*! Records the time from \p startUs until now for \p stage of the current cluster. */
+void LAT_Record(LAT_Stage stage, int64_t startUs)
+{
+    const uint32_t key = uint32_t(stage) << 16 | latCluster;
+    LAT_Add(&latStats[key], LAT_NowUs() - startUs);
+}
+
+/*! Returns all recorded histograms sorted by stage and cluster. */
+void LAT_GetStats(std::vector<LAT_Entry> *entries)
+{
+    entries->clear();
+    entries->reserve(latStats.size());
+
+    for (const auto &i : latStats)
+    {
+        LAT_Entry e;
+        e.stage = LAT_Stage(i.first >> 16);
+        e.clusterId = uint16_t(i.first & 0xFFFF);
+        e.hist = i.second;
+        entries->push_back(e);
+    }
+
+    std::sort(entries->begin(), entries->end(), [](const LAT_Entry &a, const LAT_Entry &b)
+    {
+        return a.stage != b.stage ? a.stage < b.stage : a.clusterId < b.clusterId;
+    });
+}
+
+void LAT_Reset()
+{
+    latStats.clear();
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! Latency histograms of the stages an APS indication passes through.
+
+    Each stage is recorded per ZCL cluster of the indication being processed. Recording
+    is a clock read and a few increments, the histograms use power of two buckets in
+    microseconds: bucket 0 holds 0..1 us, bucket n holds [2^n, 2^(n+1)) us and the last
+    bucket everything above.
+ */
+
+#define LAT_BUCKETS 20
+#define LAT_NO_CLUSTER 0xFFFF // time spent outside of an indication, e.g. in event timers
+
+enum LAT_Stage
+{
+    LAT_StageDeviceLookup,
+    LAT_StageZclDecode,
+    LAT_StageDdfParse,
+    LAT_StageLegacyHandler,
+    LAT_StageEventEnqueue,
+    LAT_StageEventProcess,
+    LAT_StageWebsocket,
+    LAT_StageDbQueue,
+    LAT_StageMax
+};
+
+struct LAT_Histogram
+{
+    uint32_t count = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+    uint32_t buckets[LAT_BUCKETS] = {};
+};
+
+struct LAT_Entry
+{
+    LAT_Stage stage;
+    uint16_t clusterId;
+    LAT_Histogram hist;
+};
+
+int64_t LAT_NowUs();
+void LAT_Add(LAT_Histogram *hist, int64_t us);
+void LAT_Merge(LAT_Histogram *hist, const LAT_Histogram &other);
+uint32_t LAT_Percentile(const LAT_Histogram &hist, unsigned percent);
+const char *LAT_StageName(LAT_Stage stage);
+
+void LAT_SetCluster(uint16_t clusterId);
+void LAT_Record(LAT_Stage stage, int64_t startUs);
+void LAT_GetStats(std::vector<LAT_Entry> *entries);
+void LAT_Reset();
+
+#endif // LATENCY_H
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "snapshot.h"
+
+#define SNAP_TAG_RESOURCE 0x01
+#define SNAP_TAG_ITEM     0x02
+
+static void SNAP_PutU16(std::vector<uint8_t> &buf, uint16_t val)
+{
+    buf.push_back(val & 0xFF);
+    buf.push_back((val >> 8) & 0xFF);
+}
+
+static void SNAP_PutU32(std::vector<uint8_t> &buf, uint32_t val)
+{
+    SNAP_PutU16(buf, val & 0xFFFF);
+    SNAP_PutU16(buf, (val >> 16) & 0xFFFF);
+}
+
+static void SNAP_PutU64(std::vector<uint8_t> &buf, uint64_t val)
+{
+    SNAP_PutU32(buf, val & 0xFFFFFFFF);
+    SNAP_PutU32(buf, (val >> 32) & 0xFFFFFFFF);
+}
+
+static uint64_t SNAP_GetLE(const uint8_t *p, unsigned size)
+{
+    uint64_t val = 0;
+    for (unsigned i = size; i > 0; i--)
+    {
+        val = (val << 8) | p[i - 1];
+    }
+    return val;
+}
+
+/*! Writes a zero terminated string with a length prefix of \p lengthSize bytes. */
+static void SNAP_PutString(std::vector<uint8_t> &buf, const char *str, size_t size, unsigned lengthSize)
+{
+    if (lengthSize == 1)
+    {
+        buf.push_back(size & 0xFF);
+    }
+    else
+    {
+        SNAP_PutU16(buf, size & 0xFFFF);
+    }
+    buf.insert(buf.end(), str, str + size);
+    buf.push_back('\0');
+}
+
+/*! Reads a string written by SNAP_PutString(), returns nullptr if malformed. */
+static const char *SNAP_GetString(const uint8_t **p, const uint8_t *end, unsigned lengthSize, unsigned *size)
+{
+    if (size_t(end - *p) < lengthSize)
+    {
+        return nullptr;
+    }
+
+    const unsigned len = unsigned(SNAP_GetLE(*p, lengthSize));
+    const uint8_t *str = *p + lengthSize;
+
+    if (size_t(end - str) < len + 1 || str[len] != '\0')
+    {
+        return nullptr;
+    }
+
+    *p = str + len + 1;
+    if (size)
+    {
+        *size = len;
+    }
+    return reinterpret_cast<const char*>(str);
+}
+
+SNAP_Writer::SNAP_Writer()
+{
+    m_buf.resize(SNAP_HEADER_SIZE);
+}
+
+/*! Starts a new resource, following items belong to it. */
+void SNAP_Writer::addResource(const char *prefix, const char *uniqueId)
+{
+    const size_t prefixLen = strlen(prefix);
+    const size_t uniqueIdLen = strlen(uniqueId);
+
+    m_hasResource = prefixLen > 0 && prefixLen <= 0xFF && uniqueIdLen > 0 && uniqueIdLen <= 0xFF;
+
+    if (m_hasResource)
+    {
+        m_buf.push_back(SNAP_TAG_RESOURCE);
+        SNAP_PutString(m_buf, prefix, prefixLen, 1);
+        SNAP_PutString(m_buf, uniqueId, uniqueIdLen, 1);
+    }
+}
+
+void SNAP_Writer::addItem(const char *suffix, const char *value, size_t valueSize, int64_t timestampMs)
+{
+    const size_t suffixLen = strlen(suffix);
+
+    if (!m_hasResource || suffixLen == 0 || suffixLen > 0xFF || valueSize > 0xFFFF)
+    {
+        return;
+    }
+
+    m_buf.push_back(SNAP_TAG_ITEM);
+    SNAP_PutString(m_buf, suffix, suffixLen, 1);
+    SNAP_PutU64(m_buf, uint64_t(timestampMs));
+    SNAP_PutString(m_buf, value, valueSize, 2);
+    m_itemCount++;
+}
+
+/*! Fills in the header and returns the complete snapshot. */
+const std::vector<uint8_t> &SNAP_Writer::finish(uint64_t stamp)
+{
+    std::vector<uint8_t> hdr;
+    hdr.reserve(SNAP_HEADER_SIZE);
+
+    const uint8_t *payload = m_buf.data() + SNAP_HEADER_SIZE;
+    const size_t payloadSize = m_buf.size() - SNAP_HEADER_SIZE;
+
+    SNAP_PutU32(hdr, SNAP_MAGIC);
+    SNAP_PutU16(hdr, SNAP_VERSION);
+    SNAP_PutU16(hdr, SNAP_HEADER_SIZE);
+    SNAP_PutU32(hdr, uint32_t(payloadSize));
+    SNAP_PutU32(hdr, SNAP_Crc32(payload, payloadSize));
+    SNAP_PutU64(hdr, stamp);
+
+    std::copy(hdr.begin(), hdr.end(), m_buf.begin());
+    return m_buf;
+}
+
+/*! CRC-32 (IEEE 802.3) with a 16 entry nibble table. */
+uint32_t SNAP_Crc32(const uint8_t *data, size_t size)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+/*! Verifies and parses a snapshot.
+
+    The returned items point into \p data which must stay valid while they are used.
+    \returns false if the header, checksum, \p stamp or any record doesn't match,
+             \p items is empty in this case.
+ */
+bool SNAP_Read(const uint8_t *data, size_t size, uint64_t stamp, std::vector<SNAP_Item> *items)
+{
+    items->clear();
+
+    if (!data || size < SNAP_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    if (SNAP_GetLE(data, 4) != SNAP_MAGIC ||
+        SNAP_GetLE(data + 4, 2) != SNAP_VERSION ||
+        SNAP_GetLE(data + 6, 2) != SNAP_HEADER_SIZE ||
+        SNAP_GetLE(data + 8, 4) != size - SNAP_HEADER_SIZE ||
+        SNAP_GetLE(data + 16, 8) != stamp)
+    {
+        return false;
+    }
+
+    const uint8_t *p = data + SNAP_HEADER_SIZE;
+    const uint8_t *end = data + size;
+
+    if (SNAP_GetLE(data + 12, 4) != SNAP_Crc32(p, size_t(end - p)))
+    {
+        return false;
+    }
+
+    SNAP_Item item{};
+
+    while (p < end)
+    {
+        const uint8_t tag = *p++;
+
+        if (tag == SNAP_TAG_RESOURCE)
+        {
+            item.prefix = SNAP_GetString(&p, end, 1, nullptr);
+            item.uniqueId = item.prefix ? SNAP_GetString(&p, end, 1, nullptr) : nullptr;
+
+            if (!item.uniqueId)
+            {
+                items->clear();
+                return false;
+            }
+        }
+        else if (tag == SNAP_TAG_ITEM && item.uniqueId)
+        {
+            item.suffix = SNAP_GetString(&p, end, 1, nullptr);
+
+            if (!item.suffix || end - p < 8)
+            {
+                items->clear();
+                return false;
+            }
+
+            item.timestampMs = int64_t(SNAP_GetLE(p, 8));
+            p += 8;
+
+            item.value = SNAP_GetString(&p, end, 2, &item.valueSize);
+            if (!item.value)
+            {
+                items->clear();
+                return false;
+            }
+
+            items->push_back(item);
+        }
+        else
+        {
+            items->clear();
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! Binary snapshot of resource item values for fast warm restarts.
+
+    The file starts with a fixed header: magic, version, payload size, CRC-32
+    of the payload and a stamp given by the writer which ties the snapshot to
+    a certain state of the database. The payload is a sequence of resource
+    records each followed by its item records. All strings are length prefixed
+    and zero terminated, so SNAP_Read() can return pointers into a memory
+    mapped file without copying.
+ */
+
+#define SNAP_MAGIC       0x4E535A44 // "DZSN"
+#define SNAP_VERSION     1
+#define SNAP_HEADER_SIZE 24
+
+struct SNAP_Item
+{
+    const char *prefix; // e.g. "/sensors"
+    const char *uniqueId;
+    const char *suffix;
+    const char *value;
+    unsigned valueSize;
+    int64_t timestampMs; // last changed, milliseconds since Epoch
+};
+
+class SNAP_Writer
+{
+public:
+    SNAP_Writer();
+    void addResource(const char *prefix, const char *uniqueId);
+    void addItem(const char *suffix, const char *value, size_t valueSize, int64_t timestampMs);
+    const std::vector<uint8_t> &finish(uint64_t stamp);
+    size_t itemCount() const { return m_itemCount; }
+
+private:
+    std::vector<uint8_t> m_buf;
+    size_t m_itemCount = 0;
+    bool m_hasResource = false;
+};
+
+uint32_t SNAP_Crc32(const uint8_t *data, size_t size);
+bool SNAP_Read(const uint8_t *data, size_t size, uint64_t stamp, std::vector<SNAP_Item> *items);
+
+#endif // SNAPSHOT_H
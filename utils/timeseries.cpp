@@ -0,0 +1,618 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <algorithm>
+#include <iterator>
+#include "timeseries.h"
+
+static uint64_t TS_ZigZagEncode(int64_t val)
+{
+    return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+static int64_t TS_ZigZagDecode(uint64_t val)
+{
+    return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+}
+
+/*! Returns the start of the \p interval sized bucket which contains \p t. */
+int64_t TS_AlignDown(int64_t t, int64_t interval)
+{
+    int64_t r = t - (t % interval);
+    if (t < 0 && (t % interval) != 0)
+    {
+        r -= interval;
+    }
+    return r;
+}
+
+static TS_Rollup TS_InitRollup(int64_t t, const TS_Sample &s)
+{
+    return TS_Rollup{t, s.value, s.value, 0, s.value, s.t, 0};
+}
+
+static void TS_AddSample(TS_Rollup *r, const TS_Sample &s)
+{
+    r->min = std::min(r->min, s.value);
+    r->max = std::max(r->max, s.value);
+    r->sum += s.value;
+    r->count++;
+
+    if (s.t >= r->tLast)
+    {
+        r->tLast = s.t;
+        r->last = s.value;
+    }
+}
+
+/*! Combines two aggregates of the same interval. */
+void TS_MergeRollup(TS_Rollup *dst, const TS_Rollup &src)
+{
+    if (src.count == 0)
+    {
+        return;
+    }
+
+    if (dst->count == 0)
+    {
+        const int64_t t = dst->t;
+        *dst = src;
+        dst->t = t;
+        return;
+    }
+
+    dst->min = std::min(dst->min, src.min);
+    dst->max = std::max(dst->max, src.max);
+    dst->sum += src.sum;
+    dst->count += src.count;
+
+    if (src.tLast >= dst->tLast)
+    {
+        dst->tLast = src.tLast;
+        dst->last = src.last;
+    }
+}
+
+static void TS_AddToRollups(std::vector<TS_Rollup> &rollups, const TS_Sample &s)
+{
+    const int64_t t = TS_AlignDown(s.t, TS_ROLLUP_INTERVAL);
+
+    auto i = rollups.end();
+    if (rollups.empty() || rollups.back().t < t)
+    {
+        // common case, append
+    }
+    else if (rollups.back().t == t)
+    {
+        i = rollups.end() - 1;
+    }
+    else
+    {
+        i = std::lower_bound(rollups.begin(), rollups.end(), t, [](const TS_Rollup &r, int64_t t) { return r.t < t; });
+        if (i != rollups.end() && i->t != t)
+        {
+            i = rollups.insert(i, TS_InitRollup(t, s));
+        }
+    }
+
+    if (i == rollups.end())
+    {
+        rollups.push_back(TS_InitRollup(t, s));
+        i = rollups.end() - 1;
+    }
+
+    TS_AddSample(&*i, s);
+}
+
+/*! Strict weak ordering of series keys, the endpoint is the least significant part. */
+bool TS_KeyLess(const TS_Key &a, const TS_Key &b)
+{
+    if (a.extAddr != b.extAddr) return a.extAddr < b.extAddr;
+    if (a.clusterId != b.clusterId) return a.clusterId < b.clusterId;
+    if (a.attributeId != b.attributeId) return a.attributeId < b.attributeId;
+    return a.endpoint < b.endpoint;
+}
+
+static bool TS_KeyEqual(const TS_Key &a, const TS_Key &b)
+{
+    return a.extAddr == b.extAddr && a.clusterId == b.clusterId &&
+           a.attributeId == b.attributeId && a.endpoint == b.endpoint;
+}
+
+/*! Appends \p val as LEB128 varint to \p buf. */
+void TS_PutVarint(std::vector<uint8_t> &buf, uint64_t val)
+{
+    while (val >= 0x80)
+    {
+        buf.push_back(static_cast<uint8_t>(val | 0x80));
+        val >>= 7;
+    }
+    buf.push_back(static_cast<uint8_t>(val));
+}
+
+/*! Reads a LEB128 varint and advances \p p.
+    \returns false if the buffer ends prematurely or the varint is too long.
+ */
+bool TS_GetVarint(const uint8_t **p, const uint8_t *end, uint64_t *val)
+{
+    uint64_t result = 0;
+    unsigned shift = 0;
+    const uint8_t *q = *p;
+
+    while (q < end && shift < 64)
+    {
+        const uint8_t b = *q++;
+        result |= static_cast<uint64_t>(b & 0x7F) << shift;
+
+        if ((b & 0x80) == 0)
+        {
+            *p = q;
+            *val = result;
+            return true;
+        }
+        shift += 7;
+    }
+
+    return false;
+}
+
+/*! Decodes all samples of a block and appends them to \p out.
+    \returns the number of decoded samples.
+ */
+size_t TS_DecodeBlock(int64_t t0, const uint8_t *data, size_t size, std::vector<TS_Sample> *out)
+{
+    size_t count = 0;
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    TS_Sample s{t0, 0};
+
+    while (p < end)
+    {
+        uint64_t dt;
+        uint64_t dv;
+
+        if (!TS_GetVarint(&p, end, &dt) || !TS_GetVarint(&p, end, &dv))
+        {
+            break; // corrupt block, keep what was decoded
+        }
+
+        s.t += TS_ZigZagDecode(dt);
+        s.value += TS_ZigZagDecode(dv);
+        out->push_back(s);
+        count++;
+    }
+
+    return count;
+}
+
+/*! Encodes \p s as delta to the previous sample of \p block. */
+static void TS_EncodeSample(TS_Block *block, const TS_Sample &s)
+{
+    const int64_t prevValue = block->count == 0 ? 0 : block->lastValue;
+    const int64_t prevTime = block->count == 0 ? block->t0 : block->t1;
+
+    TS_PutVarint(block->data, TS_ZigZagEncode(s.t - prevTime));
+    TS_PutVarint(block->data, TS_ZigZagEncode(s.value - prevValue));
+
+    block->t1 = s.t;
+    block->lastValue = s.value;
+    block->count++;
+    block->dirty = true;
+}
+
+TS_Series *TS_Store::getOrCreateSeries(const TS_Key &key)
+{
+    auto i = std::lower_bound(m_series.begin(), m_series.end(), key, [](const TS_Series &s, const TS_Key &k) { return TS_KeyLess(s.key, k); });
+
+    if (i == m_series.end() || !TS_KeyEqual(i->key, key))
+    {
+        TS_Series series;
+        series.key = key;
+        i = m_series.insert(i, std::move(series));
+    }
+
+    return &*i;
+}
+
+/*! Returns the series for \p key or nullptr if there is none. */
+const TS_Series *TS_Store::series(const TS_Key &key) const
+{
+    auto i = std::lower_bound(m_series.cbegin(), m_series.cend(), key, [](const TS_Series &s, const TS_Key &k) { return TS_KeyLess(s.key, k); });
+
+    if (i != m_series.cend() && TS_KeyEqual(i->key, key))
+    {
+        return &*i;
+    }
+
+    return nullptr;
+}
+
+/*! Appends a sample to the series of \p key.
+    \returns false if \p t is older than the last sample.
+ */
+bool TS_Store::append(const TS_Key &key, int64_t t, int64_t value)
+{
+    TS_Series *series = getOrCreateSeries(key);
+
+    if (!series->blocks.empty())
+    {
+        TS_Block &last = series->blocks.back();
+
+        if (t < last.t1)
+        {
+            return false;
+        }
+
+        if (!last.sealed && (last.count >= TS_BLOCK_MAX_SAMPLES || (t - last.t0) >= TS_BLOCK_MAX_SPAN))
+        {
+            last.sealed = true;
+        }
+    }
+
+    if (series->blocks.empty() || series->blocks.back().sealed)
+    {
+        TS_Block block;
+        block.t0 = t;
+        block.t1 = t;
+        block.data.reserve(32);
+        series->blocks.push_back(std::move(block));
+    }
+
+    TS_EncodeSample(&series->blocks.back(), TS_Sample{t, value});
+    TS_AddToRollups(series->rollups, TS_Sample{t, value});
+
+    return true;
+}
+
+/*! Adds older samples, e.g. imported history, to the series of \p key.
+
+    \p samples must be ordered by time. Samples older than the first block are put
+    into new sealed blocks in front of it, so they can be added after live samples
+    were appended. The remaining samples are appended.
+
+    \returns the number of added samples.
+ */
+size_t TS_Store::insert(const TS_Key &key, const std::vector<TS_Sample> &samples)
+{
+    TS_Series *series = getOrCreateSeries(key);
+
+    size_t i = 0;
+    size_t count = 0;
+
+    if (!series->blocks.empty())
+    {
+        const int64_t tFirst = series->blocks.front().t0;
+        std::vector<TS_Block> blocks;
+
+        for (; i < samples.size() && samples[i].t < tFirst; i++)
+        {
+            const TS_Sample &s = samples[i];
+
+            if (blocks.empty() || blocks.back().count >= TS_BLOCK_MAX_SAMPLES || (s.t - blocks.back().t0) >= TS_BLOCK_MAX_SPAN)
+            {
+                TS_Block block;
+                block.t0 = s.t;
+                block.t1 = s.t;
+                block.sealed = true;
+                blocks.push_back(std::move(block));
+            }
+
+            TS_EncodeSample(&blocks.back(), s);
+            TS_AddToRollups(series->rollups, s);
+            count++;
+        }
+
+        series->blocks.insert(series->blocks.begin(), std::make_move_iterator(blocks.begin()), std::make_move_iterator(blocks.end()));
+    }
+
+    for (; i < samples.size(); i++)
+    {
+        if (append(key, samples[i].t, samples[i].value))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*! Adds a persisted block to the series of \p key.
+    Blocks can be loaded in any order and also after samples were appended,
+    a block whose \p t0 is already present is ignored.
+    \returns false if the block is empty or already present.
+ */
+bool TS_Store::loadBlock(const TS_Key &key, int64_t t0, const uint8_t *data, size_t size)
+{
+    std::vector<TS_Sample> samples;
+
+    if (TS_DecodeBlock(t0, data, size, &samples) == 0)
+    {
+        return false;
+    }
+
+    TS_Series *series = getOrCreateSeries(key);
+
+    auto i = std::lower_bound(series->blocks.begin(), series->blocks.end(), t0, [](const TS_Block &b, int64_t t) { return b.t0 < t; });
+
+    if (i != series->blocks.end() && i->t0 == t0)
+    {
+        return false;
+    }
+
+    TS_Block block;
+    block.t0 = t0;
+    block.t1 = samples.back().t;
+    block.lastValue = samples.back().value;
+    block.count = static_cast<uint32_t>(samples.size());
+    block.data.assign(data, data + size);
+    block.dirty = false;
+
+    // only the newest block continues to receive samples
+    const bool isLast = i == series->blocks.end();
+    block.sealed = !isLast || block.count >= TS_BLOCK_MAX_SAMPLES;
+
+    if (isLast && !series->blocks.empty())
+    {
+        series->blocks.back().sealed = true;
+    }
+
+    series->blocks.insert(i, std::move(block));
+
+    for (const TS_Sample &s : samples)
+    {
+        TS_AddToRollups(series->rollups, s);
+    }
+
+    return true;
+}
+
+/*! Removes all blocks and rollups which only contain samples older than \p minTime. */
+void TS_Store::expire(int64_t minTime)
+{
+    for (TS_Series &series : m_series)
+    {
+        auto b = std::find_if(series.blocks.begin(), series.blocks.end(), [minTime](const TS_Block &x) { return x.t1 >= minTime; });
+        series.blocks.erase(series.blocks.begin(), b);
+
+        auto r = std::find_if(series.rollups.begin(), series.rollups.end(), [minTime](const TS_Rollup &x) { return (x.t + TS_ROLLUP_INTERVAL) > minTime; });
+        series.rollups.erase(series.rollups.begin(), r);
+    }
+
+    m_series.erase(std::remove_if(m_series.begin(), m_series.end(), [](const TS_Series &x) { return x.blocks.empty(); }), m_series.end());
+}
+
+/*! Collects up to \p max samples of the series \p key within [from, to] in ascending order.
+    \returns the number of samples added to \p out.
+ */
+size_t TS_Store::query(const TS_Key &key, int64_t from, int64_t to, size_t max, std::vector<TS_Sample> *out) const
+{
+    const TS_Series *s = series(key);
+
+    if (!s || max == 0)
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    std::vector<TS_Sample> samples;
+
+    for (const TS_Block &block : s->blocks)
+    {
+        if (block.t1 < from)
+        {
+            continue;
+        }
+
+        if (block.t0 > to)
+        {
+            break;
+        }
+
+        samples.clear();
+        TS_DecodeBlock(block.t0, block.data.data(), block.data.size(), &samples);
+
+        for (const TS_Sample &x : samples)
+        {
+            if (x.t < from || x.t > to)
+            {
+                continue;
+            }
+
+            out->push_back(x);
+            count++;
+
+            if (count == max)
+            {
+                return count;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*! Collects the rollups of the series \p key which overlap [from, to].
+    \returns the number of rollups added to \p out.
+ */
+size_t TS_Store::queryRollups(const TS_Key &key, int64_t from, int64_t to, std::vector<TS_Rollup> *out) const
+{
+    const TS_Series *s = series(key);
+
+    if (!s)
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (const TS_Rollup &r : s->rollups)
+    {
+        if ((r.t + TS_ROLLUP_INTERVAL) <= from)
+        {
+            continue;
+        }
+
+        if (r.t > to)
+        {
+            break;
+        }
+
+        out->push_back(r);
+        count++;
+    }
+
+    return count;
+}
+
+/*! Adds \p r to the bucket it belongs to, the buckets in \p out are ordered by time.
+    \returns false if a new bucket would exceed \p max buckets.
+ */
+static bool TS_AddToBuckets(std::vector<TS_Rollup> *out, size_t first, size_t max, int64_t interval, const TS_Rollup &r)
+{
+    const int64_t t = TS_AlignDown(r.t, interval);
+
+    if (out->size() > first && out->back().t == t)
+    {
+        TS_MergeRollup(&out->back(), r);
+        return true;
+    }
+
+    if (out->size() - first >= max)
+    {
+        return false;
+    }
+
+    TS_Rollup bucket{};
+    bucket.t = t;
+    TS_MergeRollup(&bucket, r);
+    out->push_back(bucket);
+    return true;
+}
+
+/*! Adds the raw samples of \p s within [from, to] to the buckets in \p out.
+    \returns false if \p max buckets are reached.
+ */
+static bool TS_AggregateSamples(const TS_Series *s, int64_t from, int64_t to, int64_t interval, size_t first, size_t max, std::vector<TS_Rollup> *out)
+{
+    std::vector<TS_Sample> samples;
+
+    for (const TS_Block &block : s->blocks)
+    {
+        if (block.t1 < from)
+        {
+            continue;
+        }
+
+        if (block.t0 > to)
+        {
+            break;
+        }
+
+        samples.clear();
+        TS_DecodeBlock(block.t0, block.data.data(), block.data.size(), &samples);
+
+        for (const TS_Sample &x : samples)
+        {
+            if (x.t < from || x.t > to)
+            {
+                continue;
+            }
+
+            TS_Rollup r = TS_InitRollup(x.t, x);
+            TS_AddSample(&r, x);
+
+            if (!TS_AddToBuckets(out, first, max, interval, r))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*! Aggregates the samples of the series \p key within [from, to] into buckets of \p interval seconds.
+
+    Buckets are aligned to multiples of \p interval since Epoch. If \p interval is a
+    multiple of TS_ROLLUP_INTERVAL the precomputed rollups which lie completely within
+    [from, to] are combined, the partially covered rollups at the edges are computed
+    from the raw samples.
+
+    \returns the number of buckets added to \p out, at most \p max.
+ */
+size_t TS_Store::aggregate(const TS_Key &key, int64_t from, int64_t to, int64_t interval, size_t max, std::vector<TS_Rollup> *out) const
+{
+    const TS_Series *s = series(key);
+
+    if (!s || interval <= 0 || max == 0 || to < from)
+    {
+        return 0;
+    }
+
+    const size_t first = out->size();
+
+    // first and last rollup which are completely within [from, to]
+    const int64_t rFirst = TS_AlignDown(from + TS_ROLLUP_INTERVAL - 1, TS_ROLLUP_INTERVAL);
+    const int64_t rLast = TS_AlignDown(to - TS_ROLLUP_INTERVAL + 1, TS_ROLLUP_INTERVAL);
+
+    if ((interval % TS_ROLLUP_INTERVAL) != 0 || rLast < rFirst)
+    {
+        TS_AggregateSamples(s, from, to, interval, first, max, out);
+        return out->size() - first;
+    }
+
+    if (from < rFirst && !TS_AggregateSamples(s, from, rFirst - 1, interval, first, max, out))
+    {
+        return out->size() - first;
+    }
+
+    for (const TS_Rollup &r : s->rollups)
+    {
+        if (r.t < rFirst)
+        {
+            continue;
+        }
+
+        if (r.t > rLast)
+        {
+            break;
+        }
+
+        if (!TS_AddToBuckets(out, first, max, interval, r))
+        {
+            return out->size() - first;
+        }
+    }
+
+    if (rLast + TS_ROLLUP_INTERVAL <= to)
+    {
+        TS_AggregateSamples(s, rLast + TS_ROLLUP_INTERVAL, to, interval, first, max, out);
+    }
+
+    return out->size() - first;
+}
+
+/*! Returns the approximate number of bytes used by all series. */
+size_t TS_Store::memoryUsage() const
+{
+    size_t result = m_series.capacity() * sizeof(TS_Series);
+
+    for (const TS_Series &series : m_series)
+    {
+        result += series.blocks.capacity() * sizeof(TS_Block);
+        result += series.rollups.capacity() * sizeof(TS_Rollup);
+
+        for (const TS_Block &block : series.blocks)
+        {
+            result += block.data.capacity();
+        }
+    }
+
+    return result;
+}
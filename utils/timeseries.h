@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! Compact append-only store for ZCL value history.
+
+    Each series is identified by device, endpoint, cluster and attribute.
+    Samples are appended to blocks, every sample is stored as zigzag varint
+    encoded delta of time and value to the previous sample. A typical sensor
+    sample needs 2-4 bytes instead of a full SQL row.
+
+    Blocks are sealed after TS_BLOCK_MAX_SAMPLES samples or TS_BLOCK_MAX_SPAN
+    seconds, old blocks are dropped by TS_Store::expire(). Each series further
+    keeps TS_ROLLUP_INTERVAL downsampled min/max/sum/count/last rollups.
+
+    TS_Store::aggregate() computes buckets of arbitrary size. Bucket sizes which are
+    a multiple of TS_ROLLUP_INTERVAL are answered from the rollups without decoding
+    any block, so long ranges stay cheap.
+ */
+
+#define TS_BLOCK_MAX_SAMPLES 256
+#define TS_BLOCK_MAX_SPAN    (6 * 60 * 60) // 6 hours
+#define TS_ROLLUP_INTERVAL   (60 * 60) // 1 hour
+
+struct TS_Key
+{
+    uint64_t extAddr;
+    uint16_t clusterId;
+    uint16_t attributeId;
+    uint8_t endpoint;
+};
+
+struct TS_Sample
+{
+    int64_t t; // seconds since Epoch
+    int64_t value;
+};
+
+/*! Aggregate of the samples within [t, t + interval). */
+struct TS_Rollup
+{
+    int64_t t; // start of the interval
+    int64_t min;
+    int64_t max;
+    int64_t sum;
+    int64_t last; // value of the newest sample
+    int64_t tLast; // time of the newest sample
+    uint32_t count;
+};
+
+struct TS_Block
+{
+    int64_t t0 = 0; // first timestamp, base for the first delta
+    int64_t t1 = 0; // last timestamp
+    int64_t lastValue = 0;
+    uint32_t count = 0;
+    bool sealed = false;
+    bool dirty = false; // needs to be persisted
+    std::vector<uint8_t> data;
+};
+
+struct TS_Series
+{
+    TS_Key key;
+    std::vector<TS_Block> blocks; // ordered by t0
+    std::vector<TS_Rollup> rollups; // ordered by t
+};
+
+class TS_Store
+{
+public:
+    bool append(const TS_Key &key, int64_t t, int64_t value);
+    size_t insert(const TS_Key &key, const std::vector<TS_Sample> &samples);
+    bool loadBlock(const TS_Key &key, int64_t t0, const uint8_t *data, size_t size);
+    void expire(int64_t minTime);
+    size_t query(const TS_Key &key, int64_t from, int64_t to, size_t max, std::vector<TS_Sample> *out) const;
+    size_t queryRollups(const TS_Key &key, int64_t from, int64_t to, std::vector<TS_Rollup> *out) const;
+    size_t aggregate(const TS_Key &key, int64_t from, int64_t to, int64_t interval, size_t max, std::vector<TS_Rollup> *out) const;
+    const TS_Series *series(const TS_Key &key) const;
+    std::vector<TS_Series> &allSeries() { return m_series; }
+    size_t memoryUsage() const;
+
+private:
+    TS_Series *getOrCreateSeries(const TS_Key &key);
+    std::vector<TS_Series> m_series; // ordered by key
+};
+
+bool TS_KeyLess(const TS_Key &a, const TS_Key &b);
+void TS_PutVarint(std::vector<uint8_t> &buf, uint64_t val);
+bool TS_GetVarint(const uint8_t **p, const uint8_t *end, uint64_t *val);
+int64_t TS_AlignDown(int64_t t, int64_t interval);
+void TS_MergeRollup(TS_Rollup *dst, const TS_Rollup &src);
+size_t TS_DecodeBlock(int64_t t0, const uint8_t *data, size_t size, std::vector<TS_Sample> *out);
+
+#endif // TIMESERIES_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include "tuya_dp.h"
+
+/*! Decodes the numeric value of \p dp, strings and raw data are left as is.
+ */
+static void TY_DecodeValue(const uint8_t *data, TY_Datapoint *dp)
+{
+    dp->value = 0;
+    dp->hasValue = 0;
+
+    if (dp->type != TY_TYPE_BOOL && dp->type != TY_TYPE_VALUE &&
+        dp->type != TY_TYPE_ENUM && dp->type != TY_TYPE_BITMAP)
+    {
+        return;
+    }
+
+    if (dp->length != 1 && dp->length != 2 && dp->length != 4)
+    {
+        return;
+    }
+
+    uint32_t val = 0;
+    for (unsigned i = 0; i < dp->length; i++)
+    {
+        val = (val << 8) | data[i];
+    }
+
+    if (dp->type == TY_TYPE_VALUE && dp->length == 4)
+    {
+        dp->value = int32_t(val); // signed
+    }
+    else
+    {
+        dp->value = val;
+    }
+
+    dp->hasValue = 1;
+}
+
+/*! Splits a Tuya report or response payload into its datapoints.
+
+    \returns false if the payload is too short to contain a datapoint.
+             The frame might still contain valid datapoints when \p frame->truncated is set.
+ */
+bool TY_DecodeFrame(const uint8_t *payload, size_t size, TY_Frame *frame)
+{
+    frame->seq = 0;
+    frame->count = 0;
+    frame->truncated = 0;
+
+    if (!payload || size < 2 + 4)
+    {
+        return false;
+    }
+
+    frame->seq = uint16_t(payload[0] << 8 | payload[1]);
+
+    size_t pos = 2;
+
+    while (pos < size)
+    {
+        if (size - pos < 4 || frame->count == TY_MAX_DATAPOINTS)
+        {
+            frame->truncated = 1;
+            break;
+        }
+
+        TY_Datapoint &dp = frame->dp[frame->count];
+        dp.dpid = payload[pos];
+        dp.type = payload[pos + 1];
+        dp.length = uint16_t(payload[pos + 2] << 8 | payload[pos + 3]);
+        dp.offset = uint16_t(pos + 4);
+        dp.index = frame->count;
+
+        if (size - dp.offset < dp.length)
+        {
+            frame->truncated = 1;
+            break;
+        }
+
+        TY_DecodeValue(&payload[dp.offset], &dp);
+
+        pos = dp.offset + dp.length;
+        frame->count++;
+    }
+
+    return frame->count > 0;
+}
+
+/*! Returns the first datapoint \p dpid at or after index \p start, or nullptr if there is none.
+ */
+const TY_Datapoint *TY_FindDatapoint(const TY_Frame &frame, uint8_t dpid, size_t start)
+{
+    for (size_t i = start; i < frame.count; i++)
+    {
+        if (frame.dp[i].dpid == dpid)
+        {
+            return &frame.dp[i];
+        }
+    }
+
+    return nullptr;
+}
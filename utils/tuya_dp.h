@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#ifndef TUYA_DP_H
+#define TUYA_DP_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*! Decoder for the datapoint (DP) list of Tuya cluster (0xEF00) report and response commands.
+
+    Payload: seq (U16) followed by one or more datapoints
+             dpid (U8), type (U8), length (U16), value (big endian)
+
+    The datapoints are stored in a fixed size buffer, so decoding a frame doesn't allocate.
+ */
+
+#define TY_MAX_DATAPOINTS 32
+
+#define TY_TYPE_RAW    0x00
+#define TY_TYPE_BOOL   0x01
+#define TY_TYPE_VALUE  0x02
+#define TY_TYPE_STRING 0x03
+#define TY_TYPE_ENUM   0x04
+#define TY_TYPE_BITMAP 0x05
+
+struct TY_Datapoint
+{
+    int64_t value; // numeric value, only valid if hasValue is set
+    uint16_t offset; // value offset in the payload
+    uint16_t length; // value length in bytes
+    uint8_t dpid;
+    uint8_t type;
+    uint8_t index; // position in the frame
+    uint8_t hasValue; // bool, value, enum and bitmap with a length of 1, 2 or 4 bytes
+};
+
+struct TY_Frame
+{
+    uint16_t seq;
+    uint8_t count;
+    uint8_t truncated; // malformed or more than TY_MAX_DATAPOINTS datapoints, the first count are valid
+    TY_Datapoint dp[TY_MAX_DATAPOINTS];
+};
+
+bool TY_DecodeFrame(const uint8_t *payload, size_t size, TY_Frame *frame);
+const TY_Datapoint *TY_FindDatapoint(const TY_Frame &frame, uint8_t dpid, size_t start);
+
+#endif // TUYA_DP_H
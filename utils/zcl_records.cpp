@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include "zcl_records.h"
+
+/*! Returns the size of a value of \p dataType which starts at \p data.
+
+    Strings are sized by their length prefix, which is included in the result.
+    \returns -1 if the data type isn't supported or \p size is too small
+ */
+int ZCL_DataTypeSize(uint8_t dataType, const uint8_t *data, size_t size)
+{
+    int result = -1;
+
+    switch (dataType)
+    {
+    case 0x00: result = 0; break; // no data
+    case 0x10: result = 1; break; // boolean
+    case 0x30: result = 1; break; // enum8
+    case 0x31: result = 2; break; // enum16
+    case 0x38: result = 2; break; // semi precision
+    case 0x39: result = 4; break; // single precision
+    case 0x3a: result = 8; break; // double precision
+    case 0xe0: // time of day
+    case 0xe1: // date
+    case 0xe2: // UTC time
+        result = 4;
+        break;
+    case 0xe8: // cluster id
+    case 0xe9: // attribute id
+        result = 2;
+        break;
+    case 0xea: result = 4; break; // BACnet OID
+    case 0xf0: result = 8; break; // IEEE address
+    case 0xf1: result = 16; break; // 128-bit security key
+
+    case 0x41: // octet string
+    case 0x42: // character string
+        if (size >= 1)
+        {
+            result = data[0] == 0xff ? 1 : 1 + data[0]; // 0xff: invalid string
+        }
+        break;
+
+    case 0x43: // long octet string
+    case 0x44: // long character string
+        if (size >= 2)
+        {
+            const unsigned len = data[0] | data[1] << 8;
+            result = len == 0xffff ? 2 : int(2 + len);
+        }
+        break;
+
+    default:
+        if ((dataType >= 0x08 && dataType <= 0x0f) || // data8 .. data64
+            (dataType >= 0x18 && dataType <= 0x1f) || // bitmap8 .. bitmap64
+            (dataType >= 0x20 && dataType <= 0x27) || // uint8 .. uint64
+            (dataType >= 0x28 && dataType <= 0x2f))   // int8 .. int64
+        {
+            result = (dataType & 0x07) + 1;
+        }
+        break;
+    }
+
+    if (result > 0 && size_t(result) > size)
+    {
+        return -1;
+    }
+
+    return result;
+}
+
+/*! Returns why ZCL_DataTypeSize() failed for \p dataType.
+ */
+static ZCL_RecordsResult ZCL_SizeError(uint8_t dataType)
+{
+    // the size of all other supported types doesn't depend on the data
+    const bool isString = dataType >= 0x41 && dataType <= 0x44;
+    const bool known = isString || ZCL_DataTypeSize(dataType, nullptr, SIZE_MAX) >= 0;
+    return known ? ZCL_RecordsTruncated : ZCL_RecordsUnsupported;
+}
+
+/*! Indexes the attribute records of a Read Attributes Response (\p hasStatus) or Report Attributes payload.
+
+    Records with an error status have no data type and value, they are indexed with size 0.
+ */
+ZCL_RecordsResult ZCL_IndexAttributeRecords(const uint8_t *payload, size_t size, bool hasStatus, std::vector<ZCL_AttributeRecord> *records)
+{
+    records->clear();
+
+    size_t pos = 0;
+    int index = 0;
+
+    while (pos < size)
+    {
+        ZCL_AttributeRecord rec{};
+        rec.index = index++;
+
+        if (size - pos < 2)
+        {
+            return ZCL_RecordsTruncated;
+        }
+
+        rec.id = payload[pos] | payload[pos + 1] << 8;
+        pos += 2;
+
+        if (hasStatus)
+        {
+            if (pos == size)
+            {
+                return ZCL_RecordsTruncated;
+            }
+
+            rec.status = payload[pos++];
+            if (rec.status != 0x00)
+            {
+                rec.offset = uint16_t(pos);
+                records->push_back(rec);
+                continue;
+            }
+        }
+
+        if (pos == size)
+        {
+            return ZCL_RecordsTruncated;
+        }
+
+        rec.dataType = payload[pos++];
+
+        const int valueSize = ZCL_DataTypeSize(rec.dataType, &payload[pos], size - pos);
+
+        if (valueSize < 0)
+        {
+            return ZCL_SizeError(rec.dataType);
+        }
+
+        rec.offset = uint16_t(pos);
+        rec.size = uint16_t(valueSize);
+        pos += size_t(valueSize);
+        records->push_back(rec);
+    }
+
+    return ZCL_RecordsOk;
+}
+
+/*! Indexes the tagged values of the Xiaomi special attribute 0xff01, 0xff02 or 0x00f7 in a Report Attributes payload.
+
+    For 0xff01 and 0x00f7 the record id is the tag, for the 0xff02 structure it is the element index.
+    Attributes in front of the special attribute are skipped. Like the devices expect, the values are
+    read until the end of the payload and not only within the length of the special attribute.
+
+    \param attrId - set to the special attribute id, or 0 if there is none
+ */
+ZCL_RecordsResult ZCL_IndexXiaomiTags(const uint8_t *payload, size_t size, uint16_t *attrId, std::vector<ZCL_AttributeRecord> *records)
+{
+    records->clear();
+    *attrId = 0;
+
+    size_t pos = 0;
+
+    while (pos < size && *attrId == 0)
+    {
+        if (size - pos < 3)
+        {
+            return ZCL_RecordsTruncated;
+        }
+
+        const uint16_t id = payload[pos] | payload[pos + 1] << 8;
+        const uint8_t dataType = payload[pos + 2];
+        pos += 3;
+
+        if ((id == 0xff01 && dataType == 0x42) || (id == 0x00f7 && dataType == 0x41))
+        {
+            pos += 1; // string length
+            *attrId = id;
+        }
+        else if (id == 0xff02 && dataType == 0x4c)
+        {
+            pos += 2; // number of elements
+            *attrId = id;
+        }
+        else
+        {
+            const int valueSize = ZCL_DataTypeSize(dataType, &payload[pos], size - pos);
+            if (valueSize < 0)
+            {
+                return ZCL_SizeError(dataType);
+            }
+            pos += size_t(valueSize);
+        }
+    }
+
+    if (pos > size)
+    {
+        return ZCL_RecordsTruncated;
+    }
+
+    int index = 0;
+
+    while (pos < size && *attrId != 0)
+    {
+        ZCL_AttributeRecord rec{};
+        rec.index = index;
+        rec.id = uint16_t(index); // 0xff02 running struct index
+
+        if (*attrId != 0xff02)
+        {
+            rec.id = payload[pos++];
+        }
+
+        if (pos == size)
+        {
+            return ZCL_RecordsTruncated;
+        }
+
+        rec.dataType = payload[pos++];
+
+        const int valueSize = ZCL_DataTypeSize(rec.dataType, &payload[pos], size - pos);
+        if (valueSize < 0)
+        {
+            return ZCL_SizeError(rec.dataType);
+        }
+
+        rec.offset = uint16_t(pos);
+        rec.size = uint16_t(valueSize);
+        pos += size_t(valueSize);
+        records->push_back(rec);
+        index++;
+    }
+
+    return ZCL_RecordsOk;
+}
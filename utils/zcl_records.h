@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#ifndef ZCL_RECORDS_H
+#define ZCL_RECORDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! Position of one attribute record in a ZCL Read Attributes Response
+    or Report Attributes payload, the value itself isn't decoded.
+ */
+struct ZCL_AttributeRecord
+{
+    uint16_t id;
+    uint8_t status; // always success (0x00) for reports
+    uint8_t dataType;
+    uint16_t offset; // value offset in the payload, including the length of strings
+    uint16_t size; // value size in bytes
+    int index; // record number in the frame, counting records with error status
+};
+
+enum ZCL_RecordsResult
+{
+    ZCL_RecordsOk,
+    ZCL_RecordsTruncated, // records before the malformed one are valid
+    ZCL_RecordsUnsupported // a data type with unknown size, e.g. array or structure
+};
+
+int ZCL_DataTypeSize(uint8_t dataType, const uint8_t *data, size_t size);
+ZCL_RecordsResult ZCL_IndexAttributeRecords(const uint8_t *payload, size_t size, bool hasStatus, std::vector<ZCL_AttributeRecord> *records);
+ZCL_RecordsResult ZCL_IndexXiaomiTags(const uint8_t *payload, size_t size, uint16_t *attrId, std::vector<ZCL_AttributeRecord> *records);
+
+#endif // ZCL_RECORDS_H
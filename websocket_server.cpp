@@ -14,6 +14,7 @@
 #include "deconz/dbg_trace.h"
 #include "deconz/util.h"
 #include "websocket_server.h"
+#include "utils/latency.h"
 
 /*! Constructor.
  */
@@ -140,6 +141,8 @@ void WebSocketServer::onTextMessageReceived(const QString &message)
  */
 void WebSocketServer::broadcastTextMessage(const QString &msg)
 {
+    const int64_t startUs = LAT_NowUs();
+
     for (size_t i = 0; i < clients.size(); i++)
     {
         QWebSocket *sock = clients[i];
@@ -147,6 +150,8 @@ void WebSocketServer::broadcastTextMessage(const QString &msg)
         DBG_Printf(DBG_INFO_L2, "Websocket %s:%u send message: %s (ret = %d)\n", qPrintable(sock->peerAddress().toString()), sock->peerPort(), qPrintable(msg), (int)ret);
         sock->flush();
     }
+
+    LAT_Record(LAT_StageWebsocket, startUs);
 }
 
 /*! Flush the sockets of all connected clients.
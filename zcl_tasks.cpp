@@ -112,7 +112,7 @@ bool DeRestPluginPrivate::addTaskSetOnOff(TaskItem &task, quint8 cmd, quint16 on
         {
             uint target = 0;
             ResourceItem *onItem = task.lightNode->item(RStateOn);
-            const auto ddfItem = DDF_GetItem(onItem);
+            const auto &ddfItem = DDF_GetItem(onItem);
 
             if (cmd == ONOFF_COMMAND_ON || cmd == ONOFF_COMMAND_ON_WITH_TIMED_OFF)
             {
@@ -201,14 +201,14 @@ bool DeRestPluginPrivate::addTaskSetBrightness(TaskItem &task, uint8_t bri, bool
         {
             uint target = bri;
             ResourceItem *briItem = task.lightNode->item(RStateBri);
-            const auto ddfItem = DDF_GetItem(briItem);
+            const auto &ddfItem = DDF_GetItem(briItem);
 
             if (!ddfItem.writeParameters.isNull())
             {
                 if (withOnOff) // onoff is a dependency, check if there is a write funtion for it
                 {
                     ResourceItem *onItem = task.lightNode->item(RStateOn);
-                    const auto ddfItem2 = DDF_GetItem(onItem);
+                    const auto &ddfItem2 = DDF_GetItem(onItem);
 
                     if (!ddfItem2.writeParameters.isNull())
                     {